@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <benchmark/benchmark.h>
+#include "utils/base64.h"
+#include "utils/url.h"
+
+using namespace Wizrd;
+
+// throughput (bytes_per_second) and allocations per call of the codecs,
+// for inputs of 16 B to 16 MB. --benchmark_format=json (or
+// --benchmark_out=<file> --benchmark_out_format=json) gives results that
+// compare.py of Google Benchmark compares between builds
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+
+std::string randomBytes(size_t size)
+{
+    std::string bytes(size, '\0');
+    unsigned seed = 12345;
+    for (char& byte: bytes) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<char>(seed >> 16);
+    }
+    return bytes;
+}
+
+// text as found in query strings: mostly safe chars, some spaces,
+// punctuation and UTF-8
+std::string queryText(size_t size)
+{
+    static const std::string pieces[] = {"search", " ", "caf\xc3\xa9", "-", "items", "/", "42", "&", "\xe2\x82\xac"};
+    std::string text;
+    text.reserve(size + 8);
+    for (size_t i = 0; text.size() < size; i++)
+        text += pieces[(i * 7) % 9];
+    text.resize(size);
+    return text;
+}
+
+// key=value pairs joined by '&', a third of them escaped
+std::string queryString(size_t size)
+{
+    std::string query;
+    query.reserve(size + 32);
+    for (size_t i = 0; query.size() < size; i++) {
+        if (i)
+            query += '&';
+        query += "key" + std::to_string(i) + '=';
+        query += i % 3 ? "value" : "caf%C3%A9+au+lait";
+    }
+    query.resize(size);
+    return query;
+}
+
+// runs call on each iteration, counting its bytes and allocations
+template <class Function>
+void measure(benchmark::State& state, size_t bytes, Function call)
+{
+    const size_t before = allocations;
+    for (auto _: state)
+        benchmark::DoNotOptimize(call());
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(bytes));
+    state.counters["allocs/call"] = benchmark::Counter(double(allocations - before),
+                                                       benchmark::Counter::kAvgIterations);
+}
+
+void Base64Encode(benchmark::State& state)
+{
+    const std::string data = randomBytes(state.range(0));
+    measure(state, data.size(), [&data]() { return Base64::encode(data); });
+}
+
+void Base64EncodeLines(benchmark::State& state)
+{
+    const std::string data = randomBytes(state.range(0));
+    measure(state, data.size(), [&data]() { return Base64::encode(data, true); });
+}
+
+void Base64Decode(benchmark::State& state)
+{
+    const std::string encoded = Base64::encode(randomBytes(state.range(0)));
+    measure(state, encoded.size(), [&encoded]() { return Base64::decode(encoded); });
+}
+
+void Base64DecodeLines(benchmark::State& state)
+{
+    const std::string encoded = Base64::encode(randomBytes(state.range(0)), true);
+    measure(state, encoded.size(), [&encoded]() { return Base64::decode(encoded); });
+}
+
+void UrlQuote(benchmark::State& state)
+{
+    const std::string text = queryText(state.range(0));
+    measure(state, text.size(), [&text]() { return URL::quote(text); });
+}
+
+void UrlQuotePlus(benchmark::State& state)
+{
+    const std::string text = queryText(state.range(0));
+    measure(state, text.size(), [&text]() { return URL::quotePlus(text); });
+}
+
+void UrlUnquote(benchmark::State& state)
+{
+    const std::string quoted = URL::quote(queryText(state.range(0)));
+    measure(state, quoted.size(), [&quoted]() { return URL::unquote(quoted); });
+}
+
+void UrlUnquotePlus(benchmark::State& state)
+{
+    const std::string quoted = URL::quotePlus(queryText(state.range(0)));
+    measure(state, quoted.size(), [&quoted]() { return URL::unquotePlus(quoted); });
+}
+
+void UrlDecode(benchmark::State& state)
+{
+    const std::string query = queryString(state.range(0));
+    measure(state, query.size(), [&query]() { return URL::decode(query); });
+}
+
+void UrlDecodeMap(benchmark::State& state)
+{
+    const std::string query = queryString(state.range(0));
+    measure(state, query.size(), [&query]() { return URL::decodeMap(query); });
+}
+
+void sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(8)->Range(16, 16 << 20);
+}
+
+}
+
+BENCHMARK(Base64Encode)->Apply(sizes);
+BENCHMARK(Base64EncodeLines)->Apply(sizes);
+BENCHMARK(Base64Decode)->Apply(sizes);
+BENCHMARK(Base64DecodeLines)->Apply(sizes);
+BENCHMARK(UrlQuote)->Apply(sizes);
+BENCHMARK(UrlQuotePlus)->Apply(sizes);
+BENCHMARK(UrlUnquote)->Apply(sizes);
+BENCHMARK(UrlUnquotePlus)->Apply(sizes);
+BENCHMARK(UrlDecode)->Apply(sizes);
+BENCHMARK(UrlDecodeMap)->Apply(sizes);
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+BENCHMARK_MAIN();
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "app.h"
+#include <csignal>
+#include <boost/algorithm/string/predicate.hpp>
+#include "metrics.h"
+#include "server.h"
+
+namespace Wizrd {
+
+namespace {
+
+std::vector<std::unique_ptr<App>>& registeredApps()
+{
+    static std::vector<std::unique_ptr<App>> apps;
+    return apps;
+}
+
+}
+
+bool Detail::accepts(const std::vector<std::string>& accepted, const Request& request)
+{
+    if (request.contentType.empty() && request.data.empty())
+        return true;
+    // the media type, without parameters as charset
+    boost::string_ref type(request.contentType);
+    type = type.substr(0, type.find(';'));
+    for (const std::string& accept: accepted) {
+        if (boost::iequals(type, accept))
+            return true;
+    }
+    return false;
+}
+
+RouteBuilder::RouteBuilder(App& app, std::string pattern)
+    : get(*this, Server::Method::GET),
+      head(*this, Server::Method::HEAD),
+      post(*this, Server::Method::POST),
+      put(*this, Server::Method::PUT),
+      remove(*this, Server::Method::DELETE),
+      patch(*this, Server::Method::PATCH),
+      options(*this, Server::Method::OPTIONS),
+      app_(app),
+      pattern_(std::move(pattern)),
+      pool_(nullptr),
+      cache_(nullptr),
+      done_(false)
+{
+}
+
+void RouteBuilder::accept(std::string contentType)
+{
+    accepted_.push_back(std::move(contentType));
+}
+
+void RouteBuilder::addHandler(Server::Method method, Server::RequestHandler handler)
+{
+    if (pool_)
+        handler = Server::Offload<Server::RequestHandler>(*pool_, std::move(handler));
+    if (!accepted_.empty()) {
+        handler = [accepted = accepted_, handler = std::move(handler)](Request& request, Response& response) {
+            if (Detail::accepts(accepted, request))
+                handler(request, response);
+            else
+                response.status = 415;
+        };
+    }
+    // inside the middleware, a hit still runs the before hooks
+    if (cache_ && (method == Server::Method::GET || method == Server::Method::HEAD))
+        handler = Server::Cached<Server::RequestHandler>(*cache_, cacheTtl_, cacheVary_, std::move(handler));
+    handler = app_.wrap(std::move(handler));
+    app_.router_->add(method, pattern_, std::move(handler), app_.host_);
+}
+
+App::~App()
+{
+}
+
+Server::RequestHandler App::wrap(Server::RequestHandler handler)
+{
+    return handler;
+}
+
+void App::install(Server::Router& router)
+{
+    router_ = &router;
+    host_.clear();
+    routes();
+    router_ = nullptr;
+}
+
+bool registerApp(std::unique_ptr<App> app)
+{
+    registeredApps().push_back(std::move(app));
+    return true;
+}
+
+int runApps(const std::string& address, unsigned short port)
+{
+    Server::Router router;
+    for (auto& app: registeredApps())
+        app->install(router);
+    try {
+        router.add(Server::Method::GET, "/metrics", Server::Metrics::handler());
+    }
+    catch (const Server::RouteException&) {
+        // an app serves /metrics itself
+    }
+
+    Server::Server server([&router](Request& request, Response& response) {
+        router(request, response);
+    });
+    server.listen(address, port);
+    boost::asio::signal_set signals(server.ioContext(), SIGINT, SIGTERM);
+    signals.async_wait([&server](boost::system::error_code, int) { server.stop(); });
+    server.run();
+    return 0;
+}
+
+}
@@ -0,0 +1,317 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "middleware.h"
+#include "responsecache.h"
+#include "router.h"
+#include "staticroute.h"
+#include "workerpool.h"
+
+namespace Wizrd {
+
+using Server::Request;
+using Server::Response;
+
+namespace Detail {
+
+// handlers may take (Request&, Response&), (Request&) or nothing
+template <class Function>
+Server::RequestHandler adapt(Function function)
+{
+    return [function](Request& request, Response& response) mutable {
+        std::tuple<> captures;
+        Server::Detail::invoke(function, request, response, captures);
+    };
+}
+
+/// false if request has a body of a content type not in accepted
+bool accepts(const std::vector<std::string>& accepted, const Request& request);
+
+}
+
+class App;
+template <Server::FixedString Pattern, class AppType> class StaticRouteBuilder;
+
+/// method of a route builder, assigning a handler to it registers it
+template <class Builder>
+class RouteSlot
+{
+public:
+    inline RouteSlot(Builder& route, Server::Method method) : route_(route), method_(method) {}
+    RouteSlot(const RouteSlot&) = delete;
+    template <class Function>
+    RouteSlot& operator=(Function function)
+    {
+        route_.add(method_, std::move(function));
+        return *this;
+    }
+private:
+    Builder& route_;
+    Server::Method method_;
+};
+
+/// builds the routes of a pattern only known at run time, they go in the
+/// radix tree of the router
+class RouteBuilder
+{
+public:
+    using Slot = RouteSlot<RouteBuilder>;
+
+    RouteBuilder(App& app, std::string pattern);
+    RouteBuilder(const RouteBuilder&) = delete;
+    RouteBuilder& operator=(const RouteBuilder&) = delete;
+
+    /// requests with a body of another content type get 415, applies to
+    /// the handlers assigned after it
+    void accept(std::string contentType);
+    /// the handlers assigned after it run on pool instead of the I/O thread
+    inline void offload(Server::WorkerPool& pool = Server::defaultWorkerPool()) noexcept { pool_ = &pool; }
+    /// the GET (and HEAD) handlers assigned after it are cached for ttl,
+    /// per value of the vary request headers, see Server::Cached
+    inline void cache(std::chrono::seconds ttl, std::vector<std::string> vary = {},
+                      Server::ResponseCache& cache = Server::defaultResponseCache())
+    {
+        cache_ = &cache;
+        cacheTtl_ = ttl;
+        cacheVary_ = std::move(vary);
+    }
+    /// lets the Route macro run its block exactly once
+    inline bool once() noexcept { return done_ ? false : (done_ = true); }
+
+    Slot get;
+    Slot head;
+    Slot post;
+    Slot put;
+    Slot remove;
+    Slot patch;
+    Slot options;
+
+private:
+    friend Slot;
+    template <class Function>
+    inline void add(Server::Method method, Function function)
+    {
+        addHandler(method, Detail::adapt(std::move(function)));
+    }
+    void addHandler(Server::Method method, Server::RequestHandler handler);
+
+    App& app_;
+    std::string pattern_;
+    std::vector<std::string> accepted_;
+    Server::WorkerPool* pool_;
+    Server::ResponseCache* cache_;
+    std::chrono::seconds cacheTtl_;
+    std::vector<std::string> cacheVary_;
+    bool done_;
+};
+
+class App
+{
+public:
+    virtual ~App();
+    /// adds the routes of the app to router
+    void install(Server::Router& router);
+
+    /// handler behind the middleware of the app, BasicApp hides it
+    template <class Function>
+    inline Function pipeline(Function function) { return function; }
+
+protected:
+    virtual void routes() = 0;
+    /// the routes declared after it are only served to the given virtual
+    /// host, an empty one means any host
+    inline void host(std::string name) { host_ = std::move(name); }
+    /// same as pipeline for the handlers of routes built at run time
+    virtual Server::RequestHandler wrap(Server::RequestHandler handler);
+
+private:
+    friend class RouteBuilder;
+    template <Server::FixedString Pattern, class AppType> friend class StaticRouteBuilder;
+
+    template <Server::FixedString Pattern, class Function>
+    inline void add(Server::Method method, Function function)
+    {
+        Server::addCompiled<Pattern>(*router_, method, std::move(function), host_);
+    }
+
+    Server::Router* router_ = nullptr;
+    std::string host_;
+};
+
+/// app whose routes run behind Middleware..., composed when the routes are
+/// installed. A middleware has `bool before(Request&, Response&)`, returning
+/// false to answer without the handler (e.g. 401), `void after(Request&,
+/// Response&)` or both. The layers are members of the app, shared by its
+/// routes, so the app must outlive the router
+template <class... Middleware>
+class BasicApp : public App
+{
+public:
+    using Chain = std::tuple<Middleware...>;
+
+    template <class Layer>
+    inline Layer& middleware() noexcept { return std::get<Layer>(middleware_); }
+
+    template <class Function>
+    inline auto pipeline(Function function)
+    {
+        if constexpr (sizeof...(Middleware) == 0)
+            return function;
+        else
+            return Server::Pipeline<Chain, Function>(middleware_, std::move(function));
+    }
+
+protected:
+    Server::RequestHandler wrap(Server::RequestHandler handler) override
+    {
+        return pipeline(std::move(handler));
+    }
+
+private:
+    Chain middleware_;
+};
+
+/// the object called request inside a Route(...) block, the pattern is
+/// compiled into a matcher of its own and the handlers get the converted
+/// captures as extra arguments, e.g. (Request&, int id) for "/user/<int:id>"
+template <Server::FixedString Pattern, class AppType = App>
+class StaticRouteBuilder
+{
+public:
+    using Slot = RouteSlot<StaticRouteBuilder>;
+
+    explicit StaticRouteBuilder(AppType& app)
+        : get(*this, Server::Method::GET),
+          head(*this, Server::Method::HEAD),
+          post(*this, Server::Method::POST),
+          put(*this, Server::Method::PUT),
+          remove(*this, Server::Method::DELETE),
+          patch(*this, Server::Method::PATCH),
+          options(*this, Server::Method::OPTIONS),
+          app_(app),
+          pool_(nullptr),
+          cache_(nullptr),
+          done_(false)
+    {
+    }
+    StaticRouteBuilder(const StaticRouteBuilder&) = delete;
+    StaticRouteBuilder& operator=(const StaticRouteBuilder&) = delete;
+
+    /// requests with a body of another content type get 415, applies to
+    /// the handlers assigned after it
+    inline void accept(std::string contentType) { accepted_.push_back(std::move(contentType)); }
+    /// the handlers assigned after it run on pool instead of the I/O thread
+    inline void offload(Server::WorkerPool& pool = Server::defaultWorkerPool()) noexcept { pool_ = &pool; }
+    /// the GET (and HEAD) handlers assigned after it are cached for ttl,
+    /// per value of the vary request headers, see Server::Cached
+    inline void cache(std::chrono::seconds ttl, std::vector<std::string> vary = {},
+                      Server::ResponseCache& cache = Server::defaultResponseCache())
+    {
+        cache_ = &cache;
+        cacheTtl_ = ttl;
+        cacheVary_ = std::move(vary);
+    }
+    /// lets the Route macro run its block exactly once
+    inline bool once() noexcept { return done_ ? false : (done_ = true); }
+
+    Slot get;
+    Slot head;
+    Slot post;
+    Slot put;
+    Slot remove;
+    Slot patch;
+    Slot options;
+
+private:
+    friend Slot;
+    // the offloaded handler is innermost, so that the rest runs on the
+    // I/O thread
+    template <class Function>
+    void add(Server::Method method, Function function)
+    {
+        if (pool_)
+            addAccepting(method, Server::Offload<Function>(*pool_, std::move(function)));
+        else
+            addAccepting(method, std::move(function));
+    }
+
+    template <class Function>
+    void addAccepting(Server::Method method, Function function)
+    {
+        if (accepted_.empty()) {
+            install(method, std::move(function));
+            return;
+        }
+        auto handler = [accepted = accepted_, function](Request& request, Response& response,
+                                                        auto&... captures) mutable -> void {
+            if (!Detail::accepts(accepted, request)) {
+                response.status = 415;
+                return;
+            }
+            auto arguments = std::tie(captures...);
+            Server::Detail::invoke(function, request, response, arguments);
+        };
+        install(method, std::move(handler));
+    }
+
+    // the cache goes inside the middleware, so that a hit still runs the
+    // before hooks (an authentication layer answers 401 before it)
+    template <class Function>
+    void install(Server::Method method, Function function)
+    {
+        if (cache_ && (method == Server::Method::GET || method == Server::Method::HEAD)) {
+            app_.template add<Pattern>(method, app_.pipeline(Server::Cached<Function>(
+                                                   *cache_, cacheTtl_, cacheVary_, std::move(function))));
+        }
+        else {
+            app_.template add<Pattern>(method, app_.pipeline(std::move(function)));
+        }
+    }
+
+    AppType& app_;
+    std::vector<std::string> accepted_;
+    Server::WorkerPool* pool_;
+    Server::ResponseCache* cache_;
+    std::chrono::seconds cacheTtl_;
+    std::vector<std::string> cacheVary_;
+    bool done_;
+};
+
+/// keeps app to be served by runApps
+bool registerApp(std::unique_ptr<App> app);
+/// serves every registered app until SIGINT or SIGTERM
+int runApps(const std::string& address = "0.0.0.0", unsigned short port = 8080);
+
+}
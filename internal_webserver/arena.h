@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+namespace Wizrd { namespace Server {
+
+/// bump allocator for everything a request allocates: the parsed request,
+/// its headers and the scratch memory of its handler. Nothing is freed
+/// until reset(), which drops it all at once when the response is sent.
+/// The first size bytes are allocated with the arena, requests that don't
+/// fit take more chunks from the heap, given back by reset()
+class Arena
+{
+public:
+    static constexpr size_t initialSize = 16384;
+
+    explicit Arena(size_t size = initialSize)
+        : buffer_(new char[size]),
+          resource_(buffer_.get(), size)
+    {
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    inline std::pmr::memory_resource* resource() noexcept { return &resource_; }
+    /// every container allocated from the arena must be destroyed before,
+    /// assigning an empty one to it keeps its storage
+    inline void reset() noexcept { resource_.release(); }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    std::pmr::monotonic_buffer_resource resource_;
+};
+
+}}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "cgi.h"
+#include <cctype>
+#include <boost/lexical_cast.hpp>
+#include "utils/uri.h"
+
+namespace Wizrd { namespace Server { namespace Cgi {
+
+void reset(Request& request)
+{
+    request.url.clear();
+    request.host.clear();
+    request.methodString.clear();
+    request.versionString.clear();
+    request.contentType.clear();
+    request.headers.clear();
+    request.data.clear();
+    request.parameters.clear();
+    request.route = 0;
+    request.method = Method::GET;
+    request.versionMajor = 1;
+    request.versionMinor = 1;
+    // persistence of the client connection is up to the web server
+    request.keepAlive = true;
+    request.connectionTimeout = 15;
+    request.contentLength = -1;
+}
+
+void setVariable(Request& request, boost::string_ref name, boost::string_ref value)
+{
+    if (name.starts_with("HTTP_")) {
+        name.remove_prefix(5);
+        if (name == "HOST")
+            request.host.assign(value.data(), value.size());
+        else if (name == "CONNECTION")
+            // the connection to the client belongs to the web server
+            return;
+        // HTTP_X_APP_TEST -> X-App-Test, converted in place in the header
+        appendHeader(request.headers, name, value);
+        bool wordStart = true;
+        for (char& chr: request.headers.back()[0]) {
+            if (chr == '_') {
+                chr = '-';
+                wordStart = true;
+            }
+            else {
+                if (!wordStart)
+                    chr = static_cast<char>(std::tolower(chr));
+                wordStart = false;
+            }
+        }
+    }
+    else if (name == "REQUEST_METHOD") {
+        request.methodString.assign(value.data(), value.size());
+        request.method = methodFromString(request.methodString);
+    }
+    else if (name == "REQUEST_URI") {
+        request.url.assign(value.data(), value.size());
+        RequestTarget target;
+        if (RequestTarget::parse(boost::string_ref(request.url.data(), request.url.size()), target))
+            request.url.resize(canonicalTarget(request.url.data(), target));
+    }
+    else if (name == "SERVER_PROTOCOL") {
+        request.versionString.assign(value.data(), value.size());
+        // HTTP/x.y
+        if (value.size() == 8 && value.starts_with("HTTP/") && value[6] == '.') {
+            request.versionMajor = value[5] - '0';
+            request.versionMinor = value[7] - '0';
+        }
+    }
+    else if (name == "CONTENT_TYPE") {
+        if (value.empty())
+            return;
+        request.contentType.assign(value.data(), value.size());
+        appendHeader(request.headers, "Content-Type", request.contentType);
+    }
+    else if (name == "CONTENT_LENGTH") {
+        if (value.empty())
+            return;
+        try {
+            request.contentLength = boost::lexical_cast<int>(value);
+        }
+        catch (const boost::bad_lexical_cast&) {
+            return;
+        }
+        appendHeader(request.headers, "Content-Length", value);
+    }
+}
+
+}}}
@@ -26,20 +26,34 @@
 
 #include "connection.h"
 #include "connectionmanager.h"
+#include "utils/log.h"
+#include <memory>
 #include <utility>
 #include <vector>
 
 using namespace Wizrd::Server;
 
-Connection::Connection(ip::tcp::socket socket, ConnectionManager& manager)
+Connection::Connection(StreamProtocol::socket socket, ConnectionManager& manager,
+                       const RequestHandler& handler)
     : socket_(std::move(socket)),
-      connectionManager_(manager)
+      pending_(nullptr),
+      pendingEnd_(nullptr),
+      streaming_(false),
+      parseTime_(0),
+      serializeTime_(0),
+      sent_(0),
+      request_(arena_.resource()),
+      connectionManager_(manager),
+      handler_(handler)
 {
+    response_.responder = this;
+    parser_.setConnection(id());
 }
 
 void Connection::stop()
 {
-    socket_.close();
+    boost::system::error_code ignored;
+    socket_.close(ignored);
 }
 
 void Connection::read()
@@ -49,7 +63,160 @@ void Connection::read()
     [this, self](boost::system::error_code errorCode, std::size_t bytesTransferred)
     {
         if (!errorCode) {
+            Metrics::count(Metrics::BytesIn, bytesTransferred);
+            WIZRD_PROBE(read__done, id(), bytesTransferred);
+            lastByte_ = Metrics::now();
+            if (firstByte_ == Metrics::Clock::time_point())
+                firstByte_ = lastByte_;
+            consume(buffer_.data(), buffer_.data() + bytesTransferred);
+        }
+        else if (errorCode != boost::asio::error::operation_aborted) {
+            connectionManager_.stop(shared_from_this());
+        }
+    });
+}
+
+void Connection::consume(const char* begin, const char* end)
+{
+    RequestParser::ResultType result;
+    const Metrics::Clock::time_point start = Metrics::now();
+    std::tie(begin, result) = parser_.parse(request_, begin, end);
+    parseTime_ += Metrics::now() - start;
+
+    switch (result) {
+    case RequestParser::Processing:
+        read();
+        return;
+    case RequestParser::Error:
+        Metrics::count(Metrics::ParseErrors);
+        request_.keepAlive = false;
+        response_.reset();
+        response_.status = 400;
+        break;
+    case RequestParser::TooLarge:
+        // the body isn't read, the connection ends with the response
+        request_.keepAlive = false;
+        response_.reset();
+        response_.status = 413;
+        break;
+    case RequestParser::Ok:
+        break;
+    }
+    pending_ = begin;
+    pendingEnd_ = end;
+    if (result != RequestParser::Ok) {
+        send();
+        return;
+    }
+    response_.reset();
+    // taken before the handler runs, a deferred response can be sent from
+    // another thread before it returns
+    self_ = shared_from_this();
+    hold();
+    handler_(request_, response_);
+    release();
+}
+
+void Connection::send()
+{
+    auto self(std::move(self_));
+    // a cache hit is written as is, the entry outlives the write
+    if (response_.cached && response_.cached->sendsAsIs(request_)) {
+        writeStart_ = Metrics::now();
+        write(boost::asio::buffer(response_.cached->http));
+        return;
+    }
+    const Response& response = response_.resolved();
+    // HTTP/1.0 has no chunks, the end of a stream is the end of the connection
+    if (response.stream && request_.versionMinor == 0)
+        request_.keepAlive = false;
+    const Metrics::Clock::time_point start = Metrics::now();
+    output_.clear();
+    response.toHttpHead(output_, request_);
+    streaming_ = response.stream && request_.method != Method::HEAD;
+    if (streaming_)
+        streaming_ = response.nextChunk(output_, request_.versionMinor != 0);
+    writeStart_ = Metrics::now();
+    serializeTime_ = writeStart_ - start;
+    // the body is written from the response, not copied after the head
+    if (response.hasBody(request_) && !response.body.empty()) {
+        write(std::array<boost::asio::const_buffer, 2>{boost::asio::buffer(output_),
+                                                       boost::asio::buffer(response.body)});
+    }
+    else {
+        write(boost::asio::buffer(output_));
+    }
+}
+
+void Connection::sendChunk()
+{
+    output_.clear();
+    streaming_ = response_.nextChunk(output_, request_.versionMinor != 0);
+    write(boost::asio::buffer(output_));
+}
+
+void Connection::recycle()
+{
+    // assigned containers keep their storage, the request is rebuilt so
+    // that nothing points into the arena once it is released
+    std::destroy_at(&request_);
+    arena_.reset();
+    std::construct_at(&request_, arena_.resource());
+}
 
+void Connection::recordMetrics()
+{
+    const uint32_t route = request_.route;
+    Metrics::record(route, Metrics::Read, lastByte_ - firstByte_);
+    Metrics::record(route, Metrics::Parse, parseTime_);
+    Metrics::record(route, Metrics::Serialize, serializeTime_);
+    Metrics::record(route, Metrics::Write, Metrics::now() - writeStart_);
+    firstByte_ = lastByte_ = Metrics::Clock::time_point();
+    parseTime_ = serializeTime_ = Metrics::Clock::duration(0);
+}
+
+void Connection::logAccess()
+{
+    WIZRD_LOG(Info, "{} {} HTTP/{}.{} {} {}", request_.methodString, request_.url,
+              request_.versionMajor, request_.versionMinor, response_.resolved().status, sent_);
+}
+
+template <class Buffers>
+void Connection::write(const Buffers& buffers)
+{
+    auto self(shared_from_this());
+    boost::asio::async_write(socket_, buffers,
+    [this, self](boost::system::error_code errorCode, std::size_t bytesTransferred)
+    {
+        if (!errorCode) {
+            Metrics::count(Metrics::BytesOut, bytesTransferred);
+            sent_ += bytesTransferred;
+            WIZRD_PROBE(write__done, id(), bytesTransferred, response_.resolved().status);
+            if (streaming_) {
+                sendChunk();
+                return;
+            }
+            recordMetrics();
+            if (Log::accessLog())
+                logAccess();
+            sent_ = 0;
+            if (!request_.keepAlive) {
+                boost::system::error_code ignored;
+                socket_.shutdown(StreamProtocol::socket::shutdown_both, ignored);
+                connectionManager_.stop(shared_from_this());
+            }
+            else if (pending_ != pendingEnd_) {
+                recycle();
+                Metrics::count(Metrics::KeepAliveReuses);
+                // a pipelined request is all there already
+                firstByte_ = lastByte_ = Metrics::now();
+                consume(pending_, pendingEnd_);
+            }
+            else {
+                recycle();
+                Metrics::count(Metrics::KeepAliveReuses);
+                read();
+            }
         }
         else if (errorCode != boost::asio::error::operation_aborted) {
             connectionManager_.stop(shared_from_this());
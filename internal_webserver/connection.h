@@ -27,38 +27,100 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <boost/asio.hpp>
-
-namespace ip = boost::asio::ip;
+#include "arena.h"
+#include "listener.h"
+#include "metrics.h"
+#include "requesthandler.h"
+#include "requestparser.h"
+#include "responder.h"
 
 
 namespace Wizrd { namespace Server {
 
 class ConnectionManager;
 
+/// anything accepted by a listener and kept alive by the ConnectionManager
+class BasicConnection
+{
+public:
+    virtual ~BasicConnection() = default;
+    virtual void start() = 0;
+    virtual void stop() = 0;
+
+    /// unique in the process, what the probes report (see probes.h)
+    inline uint64_t id() const noexcept { return id_; }
+
+private:
+    static inline std::atomic<uint64_t> count_{0};
+    const uint64_t id_ = ++count_;
+};
+
+typedef std::shared_ptr<BasicConnection> ConnectionPtr;
+
 /// container to store http connections
-class Connection : public std::enable_shared_from_this<Connection>
+class Connection : public BasicConnection, public Responder,
+                   public std::enable_shared_from_this<Connection>
 {
 public:
     Connection(const Connection&) = delete;
     Connection& operator=(const Connection&) = delete;
 
-    explicit Connection(ip::tcp::socket socket, ConnectionManager& manager);
-    inline void start() { read(); };
-    void stop();
+    explicit Connection(StreamProtocol::socket socket, ConnectionManager& manager,
+                        const RequestHandler& handler);
+    inline void start() override { read(); };
+    void stop() override;
+    inline boost::asio::any_io_executor executor() override { return socket_.get_executor(); }
 private:
     void read();
-    void write();
+    // parses [begin, end) and answers the first request completed by it,
+    // bytes after it (pipelined requests) are kept for when the write is done
+    void consume(const char* begin, const char* end);
+    void send() override;
+    // writes the next chunk of a streamed response, one per write so that
+    // only a chunk is buffered at a time
+    void sendChunk();
+    template <class Buffers>
+    void write(const Buffers& buffers);
+    // drops the request and everything allocated for it
+    void recycle();
+    // records the phases timed by the connection once the response is sent
+    void recordMetrics();
+    // the access log line of the response sent, see Log::accessLog
+    void logAccess();
 
-    ip::tcp::socket socket_;
+    StreamProtocol::socket socket_;
     std::array<char, 16348> buffer_;
+    const char* pending_;
+    const char* pendingEnd_;
+    // the response stream has chunks left
+    bool streaming_;
 
-    ConnectionManager& connectionManager_;
+    // phases of the request at hand, see Metrics
+    Metrics::Clock::time_point firstByte_;
+    Metrics::Clock::time_point lastByte_;
+    Metrics::Clock::time_point writeStart_;
+    Metrics::Clock::duration parseTime_;
+    Metrics::Clock::duration serializeTime_;
+    // bytes of the response written so far
+    size_t sent_;
 
-};
+    RequestParser parser_;
+    Arena arena_;
+    Request request_;
+    Response response_;
+    std::string output_;
 
-typedef std::shared_ptr<Connection> ConnectionPtr;
+    ConnectionManager& connectionManager_;
+    const RequestHandler& handler_;
+    // keeps the connection alive while a handler completes the response
+    std::shared_ptr<Connection> self_;
+};
 
 }}
 
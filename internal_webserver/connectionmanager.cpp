@@ -25,6 +25,8 @@
  */
 
 #include "connectionmanager.h"
+#include "metrics.h"
+#include "probes.h"
 
 using namespace Wizrd::Server;
 
@@ -34,20 +36,39 @@ ConnectionManager::ConnectionManager()
 
 void ConnectionManager::start(ConnectionPtr connection)
 {
-    connections_.insert(connection);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (connections_.insert(connection).second)
+            Metrics::count(Metrics::ConnectionsOpened);
+    }
+    WIZRD_PROBE(connection__accept, connection->id());
     connection->start();
 }
 
 void ConnectionManager::stop(ConnectionPtr connection)
 {
-    connections_.erase(connection);
+    bool erased;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        erased = connections_.erase(connection) != 0;
+    }
+    if (erased) {
+        Metrics::count(Metrics::ConnectionsClosed);
+        WIZRD_PROBE(connection__close, connection->id());
+    }
     connection->stop();
 }
 
 void ConnectionManager::stopAll()
 {
-    for(auto connection: connections_) {
+    std::set<ConnectionPtr> connections;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections.swap(connections_);
+    }
+    Metrics::count(Metrics::ConnectionsClosed, connections.size());
+    for(auto connection: connections) {
+        WIZRD_PROBE(connection__close, connection->id());
         connection->stop();
     }
-    connections_.clear();
 }
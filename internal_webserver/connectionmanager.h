@@ -26,6 +26,7 @@
 
 #pragma once
 
+#include <mutex>
 #include <set>
 
 #include "connection.h"
@@ -43,6 +44,7 @@ public:
     void stop(ConnectionPtr connection);
     void stopAll();
 private:
+    std::mutex mutex_;
     std::set<ConnectionPtr> connections_;
 };
 
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "cookies.h"
+#include <algorithm>
+#include "utils/base64.h"
+#include "utils/hmac.h"
+
+namespace Wizrd {
+namespace Server {
+
+namespace {
+
+HmacSha256::Digest signature(boost::string_ref name, boost::string_ref value,
+                             boost::string_ref secret) noexcept
+{
+    HmacSha256 hmac(secret);
+    hmac.update(name);
+    hmac.update("=");
+    hmac.update(value);
+    return hmac.finish();
+}
+
+inline bool isBase64(char c) noexcept
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+           c == '+' || c == '/';
+}
+
+// length of the Base64 of a digest, with its padding
+const size_t SignatureSize = (Sha256::DigestSize + 2) / 3 * 4;
+
+} // anonymous namespace
+
+std::string signCookie(boost::string_ref name, boost::string_ref value, boost::string_ref secret)
+{
+    const HmacSha256::Digest digest = signature(name, value, secret);
+    std::string signed_(value.data(), value.size());
+    signed_ += '.';
+    signed_ += Base64::encode(reinterpret_cast<const char*>(digest.data()), digest.size());
+    return signed_;
+}
+
+boost::string_ref signedCookie(const Request& request, boost::string_ref name,
+                               boost::string_ref secret)
+{
+    const boost::string_ref cookie = request.cookies()[name];
+    const size_t dot = cookie.rfind('.');
+    if (dot == boost::string_ref::npos || cookie.size() - dot - 1 != SignatureSize)
+        return boost::string_ref();
+
+    // checked up front so that forged cookies don't cost an exception
+    const boost::string_ref encoded = cookie.substr(dot + 1);
+    if (encoded.back() != '=' || !std::all_of(encoded.begin(), encoded.end() - 1, isBase64))
+        return boost::string_ref();
+    char decoded[SignatureSize / 4 * 3];
+    if (Base64::decodeInto(encoded.data(), encoded.size(), decoded) != Sha256::DigestSize)
+        return boost::string_ref();
+    const boost::string_ref value = cookie.substr(0, dot);
+    const HmacSha256::Digest digest = signature(name, value, secret);
+    if (!HmacSha256::equal(digest.data(), decoded, digest.size()))
+        return boost::string_ref();
+    return value;
+}
+
+} // Server namespace
+} // Wizrd namespace
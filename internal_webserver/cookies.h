@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <boost/utility/string_ref.hpp>
+#include "request.h"
+
+namespace Wizrd { namespace Server {
+
+/// value for the cookie name that signedCookie() accepts back: value, a dot
+/// and the Base64 HMAC-SHA256 under secret of name=value, so that a signed
+/// value is not accepted for another cookie
+std::string signCookie(boost::string_ref name, boost::string_ref value, boost::string_ref secret);
+
+/// the value of the cookie name signed with secret by signCookie(), empty if
+/// there is no such cookie or its signature doesn't match. Checked without
+/// allocating, the value is a view into the Cookie header
+boost::string_ref signedCookie(const Request& request, boost::string_ref name,
+                               boost::string_ref secret);
+
+}}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <exception>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <boost/asio.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include "responder.h"
+#include "response.h"
+#include "utils/log.h"
+
+namespace Wizrd { namespace Server {
+
+/// what coroutine handlers return, they may co_await anything asio can,
+/// with boost::asio::use_awaitable, and co_return what a synchronous
+/// handler would return (nothing, a body or a Response)
+template <class T = void>
+using Task = boost::asio::awaitable<T>;
+
+namespace Detail {
+
+inline void setResult(Response& response, std::string body) { response.body = std::move(body); }
+inline void setResult(Response& response, const char* body) { response.body = body; }
+inline void setResult(Response& response, Response result)
+{
+    Responder* responder = response.responder;
+    response = std::move(result);
+    response.responder = responder;
+}
+
+inline void fail(Response& response, std::exception_ptr error)
+{
+    try {
+        std::rethrow_exception(error);
+    }
+    catch (const std::exception& exception) {
+        WIZRD_LOG(Error, "handler failed: {}", exception.what());
+    }
+    catch (...) {
+        WIZRD_LOG(Error, "handler failed");
+    }
+    response.reset();
+    response.status = 500;
+}
+
+/// runs the coroutine of a handler on the executor of the connection, the
+/// response is sent when it is done. Without a connection (tests, CGI) it
+/// runs to completion in place
+template <class T>
+void setResult(Response& response, Task<T> task)
+{
+    Responder* responder = response.responder;
+    // only built when there is no connection, it allocates its scheduler
+    std::optional<boost::asio::io_context> context;
+    boost::asio::any_io_executor executor;
+    if (responder) {
+        executor = responder->executor();
+        responder->defer();
+    }
+    else {
+        executor = context.emplace().get_executor();
+    }
+
+    if constexpr (std::is_void<T>::value) {
+        boost::asio::co_spawn(executor, std::move(task), [&response, responder](std::exception_ptr error) {
+            if (error)
+                fail(response, error);
+            if (responder)
+                responder->complete();
+        });
+    }
+    else {
+        boost::asio::co_spawn(executor, std::move(task), [&response, responder](std::exception_ptr error, T result) {
+            if (error)
+                fail(response, error);
+            else
+                setResult(response, std::move(result));
+            if (responder)
+                responder->complete();
+        });
+    }
+
+    if (context)
+        context->run();
+}
+
+}
+
+}}
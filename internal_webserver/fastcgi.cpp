@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "fastcgi.h"
+#include <algorithm>
+
+namespace Wizrd { namespace Server { namespace FastCgi {
+
+void appendRecord(std::string& output, uint8_t type, uint16_t requestId,
+                  boost::string_ref content)
+{
+    // keeping records 8 bytes aligned, as recommended by the specification
+    const uint8_t padding = (8 - (content.size() % 8)) % 8;
+    const char header[HeaderSize] = {
+        static_cast<char>(Version),
+        static_cast<char>(type),
+        static_cast<char>(requestId >> 8),
+        static_cast<char>(requestId & 0xFF),
+        static_cast<char>(content.size() >> 8),
+        static_cast<char>(content.size() & 0xFF),
+        static_cast<char>(padding),
+        0
+    };
+    output.append(header, HeaderSize);
+    output.append(content.data(), content.size());
+    output.append(padding, '\0');
+}
+
+void appendStream(std::string& output, uint8_t type, uint16_t requestId,
+                  boost::string_ref content)
+{
+    // largest 8 bytes aligned chunk, so no record needs padding but the last
+    static const size_t chunkSize = MaxContentLength & ~size_t(7);
+    output.reserve(output.size() + content.size() +
+                   (content.size() / chunkSize + 1) * (HeaderSize + 8));
+    while (content.size() > chunkSize) {
+        appendRecord(output, type, requestId, content.substr(0, chunkSize));
+        content.remove_prefix(chunkSize);
+    }
+    if (!content.empty())
+        appendRecord(output, type, requestId, content);
+}
+
+void appendEndRequest(std::string& output, uint16_t requestId, uint32_t appStatus,
+                      ProtocolStatus status)
+{
+    const char body[8] = {
+        static_cast<char>(appStatus >> 24),
+        static_cast<char>((appStatus >> 16) & 0xFF),
+        static_cast<char>((appStatus >> 8) & 0xFF),
+        static_cast<char>(appStatus & 0xFF),
+        static_cast<char>(status),
+        0, 0, 0
+    };
+    appendRecord(output, EndRequest, requestId, boost::string_ref(body, sizeof(body)));
+}
+
+void appendPair(std::string& output, boost::string_ref name, boost::string_ref value)
+{
+    auto appendLength = [&output](size_t length) {
+        if (length < 0x80) {
+            output += static_cast<char>(length);
+        }
+        else {
+            output += static_cast<char>(((length >> 24) & 0x7F) | 0x80);
+            output += static_cast<char>((length >> 16) & 0xFF);
+            output += static_cast<char>((length >> 8) & 0xFF);
+            output += static_cast<char>(length & 0xFF);
+        }
+    };
+    appendLength(name.size());
+    appendLength(value.size());
+    output.append(name.data(), name.size());
+    output.append(value.data(), value.size());
+}
+
+RecordParser::RecordParser()
+    : state_(Header),
+      headerSize_(0),
+      remaining_(0)
+{
+}
+
+const char* RecordParser::consumeHeader(const char* begin, const char* end)
+{
+    const size_t size = std::min<size_t>(end - begin, HeaderSize - headerSize_);
+    std::copy(begin, begin + size, headerBuffer_ + headerSize_);
+    headerSize_ += size;
+    if (headerSize_ < HeaderSize)
+        return begin + size;
+
+    headerSize_ = 0;
+    header_.version = headerBuffer_[0];
+    header_.type = headerBuffer_[1];
+    header_.requestId = (headerBuffer_[2] << 8) | headerBuffer_[3];
+    header_.contentLength = (headerBuffer_[4] << 8) | headerBuffer_[5];
+    header_.paddingLength = headerBuffer_[6];
+    remaining_ = header_.contentLength;
+    content_.clear();
+    state_ = Content;
+    return begin + size;
+}
+
+}}}
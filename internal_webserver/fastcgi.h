@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <boost/utility/string_ref.hpp>
+#include "request.h"
+
+namespace Wizrd { namespace Server { namespace FastCgi {
+
+// FastCGI 1.0 wire protocol, see https://fastcgi-archives.github.io/FastCGI_Specification.html
+
+enum RecordType : uint8_t {
+    BeginRequest = 1,
+    AbortRequest,
+    EndRequest,
+    Params,
+    Stdin,
+    Stdout,
+    Stderr,
+    Data,
+    GetValues,
+    GetValuesResult,
+    UnknownType
+};
+
+enum Role : uint16_t {
+    Responder = 1,
+    Authorizer,
+    Filter
+};
+
+enum ProtocolStatus : uint8_t {
+    RequestComplete = 0,
+    CantMultiplexConnection,
+    Overloaded,
+    UnknownRole
+};
+
+static const uint8_t Version = 1;
+static const uint8_t KeepConnection = 1;
+static const size_t HeaderSize = 8;
+static const size_t MaxContentLength = 0xFFFF;
+
+struct RecordHeader {
+    uint8_t version;
+    uint8_t type;
+    uint16_t requestId;
+    uint16_t contentLength;
+    uint8_t paddingLength;
+};
+
+/// appends a single record, content must fit in MaxContentLength
+void appendRecord(std::string& output, uint8_t type, uint16_t requestId,
+                  boost::string_ref content = boost::string_ref());
+/// appends content as a stream of as many records as needed, it doesn't
+/// append the empty record that ends the stream
+void appendStream(std::string& output, uint8_t type, uint16_t requestId,
+                  boost::string_ref content);
+void appendEndRequest(std::string& output, uint16_t requestId, uint32_t appStatus,
+                      ProtocolStatus status);
+/// appends a name-value pair in the PARAMS/GET_VALUES encoding
+void appendPair(std::string& output, boost::string_ref name, boost::string_ref value);
+
+/// splits a byte stream in records, the content of stream records
+/// (PARAMS, STDIN, DATA) is handed out as slices of the input as it comes,
+/// the others are buffered and handed out whole
+class RecordParser
+{
+public:
+    RecordParser();
+
+    // visitor(const RecordHeader&, boost::string_ref content, bool complete)
+    // returns false when the stream is not a FastCGI one
+    template <class Visitor>
+    bool parse(const char* begin, const char* end, Visitor&& visitor)
+    {
+        while (begin != end) {
+            switch (state_) {
+            case Header:
+                begin = consumeHeader(begin, end);
+                if (state_ == Header)
+                    break;
+                if (header_.version != Version)
+                    return false;
+                if (header_.contentLength == 0) {
+                    visitor(header_, boost::string_ref(), true);
+                    remaining_ = header_.paddingLength;
+                    state_ = remaining_ ? Padding : Header;
+                }
+                break;
+            case Content: {
+                const size_t size = std::min<size_t>(end - begin, remaining_);
+                remaining_ -= size;
+                const bool complete = remaining_ == 0;
+                if (streamed(header_.type)) {
+                    visitor(header_, boost::string_ref(begin, size), complete);
+                }
+                else {
+                    content_.append(begin, size);
+                    if (complete)
+                        visitor(header_, boost::string_ref(content_), true);
+                }
+                begin += size;
+                if (complete) {
+                    remaining_ = header_.paddingLength;
+                    state_ = remaining_ ? Padding : Header;
+                }
+                break;
+            }
+            case Padding: {
+                const size_t size = std::min<size_t>(end - begin, remaining_);
+                remaining_ -= size;
+                begin += size;
+                if (!remaining_)
+                    state_ = Header;
+                break;
+            }
+            }
+        }
+        return true;
+    }
+
+private:
+    const char* consumeHeader(const char* begin, const char* end);
+    static inline bool streamed(uint8_t type) noexcept
+    {
+        return type == Params || type == Stdin || type == Data;
+    }
+
+    enum {
+        Header,
+        Content,
+        Padding
+    } state_;
+    unsigned char headerBuffer_[HeaderSize];
+    size_t headerSize_;
+    size_t remaining_;
+    RecordHeader header_;
+    std::string content_;
+};
+
+/// decodes the name-value pairs of a PARAMS stream, pairs fully contained in
+/// a slice are handed out as views of it, only pairs split between slices
+/// are copied
+class ParamsDecoder
+{
+public:
+    // visitor(boost::string_ref name, boost::string_ref value)
+    // returns false when a pair grows past MaxPairSize
+    template <class Visitor>
+    bool feed(boost::string_ref slice, Visitor&& visitor)
+    {
+        if (pending_.empty()) {
+            const size_t used = decode(slice, visitor);
+            pending_.assign(slice.data() + used, slice.size() - used);
+        }
+        else {
+            pending_.append(slice.data(), slice.size());
+            pending_.erase(0, decode(pending_, visitor));
+        }
+        return pending_.size() <= MaxPairSize;
+    }
+    inline bool empty() const noexcept { return pending_.empty(); }
+    inline void clear() noexcept { pending_.clear(); }
+
+private:
+    static const size_t MaxPairSize = 1 << 20;
+
+    // returns how much of data was decoded in complete pairs
+    template <class Visitor>
+    static size_t decode(boost::string_ref data, Visitor& visitor)
+    {
+        size_t position = 0;
+        while (position < data.size()) {
+            size_t nameLength, valueLength;
+            size_t current = position;
+            if (!readLength(data, current, nameLength) ||
+                !readLength(data, current, valueLength))
+                break;
+            if (data.size() - current < nameLength + valueLength)
+                break;
+            visitor(data.substr(current, nameLength),
+                    data.substr(current + nameLength, valueLength));
+            position = current + nameLength + valueLength;
+        }
+        return position;
+    }
+    static inline bool readLength(boost::string_ref data, size_t& position, size_t& length) noexcept
+    {
+        if (position >= data.size())
+            return false;
+        const unsigned char first = data[position];
+        if (!(first & 0x80)) {
+            length = first;
+            position += 1;
+            return true;
+        }
+        if (data.size() - position < 4)
+            return false;
+        length = (size_t(first & 0x7F) << 24) |
+                 (size_t(static_cast<unsigned char>(data[position + 1])) << 16) |
+                 (size_t(static_cast<unsigned char>(data[position + 2])) << 8) |
+                 size_t(static_cast<unsigned char>(data[position + 3]));
+        position += 4;
+        return true;
+    }
+
+    std::string pending_;
+};
+
+}}}
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "fastcgiconnection.h"
+#include "cgi.h"
+#include "connectionmanager.h"
+#include <algorithm>
+#include <utility>
+
+using namespace Wizrd::Server;
+
+FastCgiConnection::FastCgiConnection(StreamProtocol::socket socket, ConnectionManager& manager,
+                                     const RequestHandler& handler)
+    : socket_(std::move(socket)),
+      writing_(false),
+      closing_(false),
+      connectionManager_(manager),
+      handler_(handler)
+{
+}
+
+void FastCgiConnection::stop()
+{
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+}
+
+void FastCgiConnection::read()
+{
+    auto self(shared_from_this());
+    socket_.async_read_some(boost::asio::buffer(buffer_),
+    [this, self](boost::system::error_code errorCode, std::size_t bytesTransferred)
+    {
+        if (!errorCode) {
+            // other requests may still come while closing_, the web server
+            // multiplexed them before it saw the end of the first one
+            if (!consume(buffer_.data(), buffer_.data() + bytesTransferred))
+                connectionManager_.stop(shared_from_this());
+            else
+                read();
+        }
+        else if (errorCode != boost::asio::error::operation_aborted) {
+            connectionManager_.stop(shared_from_this());
+        }
+    });
+}
+
+bool FastCgiConnection::consume(const char* begin, const char* end)
+{
+    bool valid = true;
+    const bool isFastCgi = parser_.parse(begin, end,
+        [this, &valid](const FastCgi::RecordHeader& header, boost::string_ref content, bool complete) {
+            if (valid)
+                valid = record(header, content, complete);
+        });
+    return isFastCgi && valid;
+}
+
+bool FastCgiConnection::record(const FastCgi::RecordHeader& header, boost::string_ref content,
+                               bool complete)
+{
+    if (header.requestId == 0) {
+        // management records
+        if (header.type == FastCgi::GetValues) {
+            getValues(content);
+        }
+        else {
+            const char body[8] = {static_cast<char>(header.type)};
+            FastCgi::appendRecord(queued_, FastCgi::UnknownType, 0,
+                                  boost::string_ref(body, sizeof(body)));
+        }
+        write();
+        return true;
+    }
+
+    if (header.type == FastCgi::BeginRequest) {
+        beginRequest(header.requestId, content);
+        return true;
+    }
+
+    const auto found = exchanges_.find(header.requestId);
+    // records of unknown (or already aborted) requests are ignored
+    if (found == exchanges_.end())
+        return true;
+    Exchange& exchange = *found->second;
+
+    switch (header.type) {
+    case FastCgi::Params:
+        if (content.empty() && complete) {
+            // an empty record ends the stream
+            if (!exchange.params.empty())
+                return false;
+        }
+        else if (!exchange.params.feed(content, [&exchange](boost::string_ref name, boost::string_ref value) {
+                     Cgi::setVariable(exchange.request, name, value);
+                 })) {
+            return false;
+        }
+        break;
+    case FastCgi::Stdin:
+        if (content.empty() && complete) {
+            respond(exchange);
+        }
+        else {
+            if (exchange.request.data.empty() && exchange.request.contentLength > 0)
+                exchange.request.data.reserve(exchange.request.contentLength);
+            exchange.request.data.append(content.data(), content.size());
+        }
+        break;
+    case FastCgi::AbortRequest:
+        FastCgi::appendEndRequest(queued_, header.requestId, 0, FastCgi::RequestComplete);
+        if (exchange.streaming)
+            streams_.erase(std::find(streams_.begin(), streams_.end(), &exchange));
+        if (!exchange.keepConnection)
+            closing_ = true;
+        if (exchange.deferred()) {
+            // the handler still uses it, its response is dropped
+            exchange.aborted = true;
+            aborted_.push_back(std::move(found->second));
+        }
+        exchanges_.erase(found);
+        write();
+        break;
+    default:
+        // DATA only matters to filters
+        break;
+    }
+    return true;
+}
+
+void FastCgiConnection::beginRequest(uint16_t requestId, boost::string_ref content)
+{
+    if (content.size() < 8)
+        return;
+    const uint16_t role = (static_cast<unsigned char>(content[0]) << 8) |
+                          static_cast<unsigned char>(content[1]);
+    const bool keepConnection = content[2] & FastCgi::KeepConnection;
+    if (role != FastCgi::Responder) {
+        FastCgi::appendEndRequest(queued_, requestId, 0, FastCgi::UnknownRole);
+        if (!keepConnection)
+            closing_ = true;
+        write();
+        return;
+    }
+
+    auto& exchange = exchanges_[requestId];
+    // the id is still in use by a handler that didn't complete, that's a
+    // protocol error of the web server
+    if (exchange && exchange->deferred())
+        return;
+    if (!exchange)
+        exchange.reset(new Exchange(*this, requestId));
+    Cgi::reset(exchange->request);
+    exchange->params.clear();
+    exchange->keepConnection = keepConnection;
+}
+
+void FastCgiConnection::getValues(boost::string_ref content)
+{
+    std::string values;
+    FastCgi::ParamsDecoder decoder;
+    decoder.feed(content, [&values](boost::string_ref name, boost::string_ref) {
+        if (name == "FCGI_MPXS_CONNS")
+            FastCgi::appendPair(values, name, "1");
+        else if (name == "FCGI_MAX_REQS" || name == "FCGI_MAX_CONNS")
+            FastCgi::appendPair(values, name, "65535");
+    });
+    FastCgi::appendRecord(queued_, FastCgi::GetValuesResult, 0, values);
+}
+
+void FastCgiConnection::respond(Exchange& exchange)
+{
+    exchange.response.reset();
+    exchange.request.connection = id();
+    // taken before the handler runs, a deferred response can be sent from
+    // another thread before it returns
+    exchange.owner = shared_from_this();
+    exchange.hold();
+    handler_(exchange.request, exchange.response);
+    exchange.release();
+}
+
+void FastCgiConnection::finish(Exchange& exchange)
+{
+    auto owner(std::move(exchange.owner));
+    if (exchange.aborted) {
+        aborted_.erase(std::find_if(aborted_.begin(), aborted_.end(),
+                                    [&exchange](const std::unique_ptr<Exchange>& aborted) {
+                                        return aborted.get() == &exchange;
+                                    }));
+        closeWhenDone();
+        return;
+    }
+
+    const Response& response = exchange.response.resolved();
+    std::string headers;
+    response.toCgiHeaders(headers);
+    FastCgi::appendStream(queued_, FastCgi::Stdout, exchange.requestId, headers);
+    if (exchange.request.method != Method::HEAD && response.stream) {
+        // STDOUT records are the chunks, their length is the framing. Each
+        // one is produced once the previous write is done
+        exchange.streaming = true;
+        streams_.push_back(&exchange);
+        write();
+        return;
+    }
+    if (exchange.request.method != Method::HEAD)
+        FastCgi::appendStream(queued_, FastCgi::Stdout, exchange.requestId, response.body);
+    end(exchange);
+}
+
+void FastCgiConnection::end(Exchange& exchange)
+{
+    const uint16_t requestId = exchange.requestId;
+    FastCgi::appendRecord(queued_, FastCgi::Stdout, requestId);
+    FastCgi::appendEndRequest(queued_, requestId, 0, FastCgi::RequestComplete);
+
+    if (!exchange.keepConnection)
+        closing_ = true;
+    exchanges_.erase(requestId);
+    write();
+}
+
+void FastCgiConnection::nextChunk()
+{
+    Exchange& exchange = *streams_.front();
+    streams_.pop_front();
+    chunk_.clear();
+    const bool more = exchange.response.resolved().nextChunk(chunk_, false);
+    FastCgi::appendStream(queued_, FastCgi::Stdout, exchange.requestId, chunk_);
+    if (more) {
+        streams_.push_back(&exchange);
+        write();
+    }
+    else {
+        exchange.streaming = false;
+        end(exchange);
+    }
+}
+
+void FastCgiConnection::closeWhenDone()
+{
+    if (closing_ && !writing_ && queued_.empty() && exchanges_.empty() && aborted_.empty())
+        connectionManager_.stop(shared_from_this());
+}
+
+void FastCgiConnection::write()
+{
+    if (writing_ || queued_.empty())
+        return;
+    writing_ = true;
+    output_.clear();
+    output_.swap(queued_);
+
+    auto self(shared_from_this());
+    boost::asio::async_write(socket_, boost::asio::buffer(output_),
+    [this, self](boost::system::error_code errorCode, std::size_t)
+    {
+        writing_ = false;
+        if (!errorCode) {
+            if (!queued_.empty())
+                write();
+            else if (!streams_.empty())
+                nextChunk();
+            else
+                closeWhenDone();
+        }
+        else if (errorCode != boost::asio::error::operation_aborted) {
+            connectionManager_.stop(shared_from_this());
+        }
+    });
+}
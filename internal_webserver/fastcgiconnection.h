@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <array>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "connection.h"
+#include "fastcgi.h"
+
+namespace Wizrd { namespace Server {
+
+/// FastCGI responder connection, the web server may multiplex any number of
+/// requests over it and keep it open between them (FCGI_KEEP_CONN)
+class FastCgiConnection : public BasicConnection,
+                          public std::enable_shared_from_this<FastCgiConnection>
+{
+public:
+    FastCgiConnection(const FastCgiConnection&) = delete;
+    FastCgiConnection& operator=(const FastCgiConnection&) = delete;
+
+    explicit FastCgiConnection(StreamProtocol::socket socket, ConnectionManager& manager,
+                               const RequestHandler& handler);
+    inline void start() override { read(); }
+    void stop() override;
+
+private:
+    struct Exchange : public Responder {
+        inline Exchange(FastCgiConnection& connection, uint16_t requestId)
+            : connection(connection), requestId(requestId), keepConnection(false), aborted(false),
+              streaming(false)
+        {
+            response.responder = this;
+        }
+        inline boost::asio::any_io_executor executor() override { return connection.socket_.get_executor(); }
+        inline void send() override { connection.finish(*this); }
+
+        FastCgiConnection& connection;
+        const uint16_t requestId;
+        Request request;
+        Response response;
+        FastCgi::ParamsDecoder params;
+        bool keepConnection;
+        bool aborted;
+        // its response stream has chunks left, see streams_
+        bool streaming;
+        // keeps the connection alive while a handler completes the response
+        std::shared_ptr<FastCgiConnection> owner;
+    };
+
+    void read();
+    bool consume(const char* begin, const char* end);
+    bool record(const FastCgi::RecordHeader& header, boost::string_ref content, bool complete);
+    void beginRequest(uint16_t requestId, boost::string_ref content);
+    void getValues(boost::string_ref content);
+    void respond(Exchange& exchange);
+    void finish(Exchange& exchange);
+    // ends the STDOUT stream of exchange and drops it
+    void end(Exchange& exchange);
+    // the next chunk of the first stream, once everything before is written
+    void nextChunk();
+    // without FCGI_KEEP_CONN the connection closes, once no other request
+    // on it is pending and everything is written
+    void closeWhenDone();
+    void write();
+
+    StreamProtocol::socket socket_;
+    std::array<char, 16348> buffer_;
+    FastCgi::RecordParser parser_;
+    std::unordered_map<uint16_t, std::unique_ptr<Exchange>> exchanges_;
+    // aborted exchanges whose handler is still running
+    std::vector<std::unique_ptr<Exchange>> aborted_;
+    // exchanges sending a stream, they take turns one chunk at a time
+    std::deque<Exchange*> streams_;
+
+    // output_ is being written while queued_ collects what comes next
+    std::string output_;
+    std::string queued_;
+    std::string chunk_;
+    bool writing_;
+    // a request without FCGI_KEEP_CONN ended, see closeWhenDone
+    bool closing_;
+
+    ConnectionManager& connectionManager_;
+    const RequestHandler& handler_;
+};
+
+}}
@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "json.h"
+#include <charconv>
+#include <cmath>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace Wizrd {
+namespace Server {
+
+namespace {
+
+// escape of each byte needing one, 'u' for \u00XX, 0 for the others
+struct EscapeTable
+{
+    char escapes[256] = {};
+
+    constexpr EscapeTable()
+    {
+        for (int i = 0; i < 0x20; ++i)
+            escapes[i] = 'u';
+        escapes[static_cast<int>('"')] = '"';
+        escapes[static_cast<int>('\\')] = '\\';
+        escapes[static_cast<int>('\b')] = 'b';
+        escapes[static_cast<int>('\f')] = 'f';
+        escapes[static_cast<int>('\n')] = 'n';
+        escapes[static_cast<int>('\r')] = 'r';
+        escapes[static_cast<int>('\t')] = 't';
+    }
+};
+
+constexpr EscapeTable table;
+
+inline void appendEscape(std::string& output, unsigned char byte)
+{
+    static const char digits[] = "0123456789abcdef";
+    const char escape = table.escapes[byte];
+    if (escape != 'u') {
+        const char sequence[2] = {'\\', escape};
+        output.append(sequence, 2);
+    }
+    else {
+        const char sequence[6] = {'\\', 'u', '0', '0', digits[byte >> 4], digits[byte & 0xF]};
+        output.append(sequence, 6);
+    }
+}
+
+} // anonymous namespace
+
+void JsonWriter::escape(std::string& output, std::string_view text)
+{
+    const char* run = text.data();
+    const char* current = run;
+    const char* const end = run + text.size();
+    output.reserve(output.size() + text.size());
+
+#ifdef __SSE2__
+    // 16 bytes at a time: most strings have nothing to escape and are
+    // copied in runs as long as the string
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    while (end - current >= 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(current));
+        // bytes up to 0x1F are the ones unchanged by an unsigned max with it
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(bytes, quote), _mm_cmpeq_epi8(bytes, backslash)),
+            _mm_cmpeq_epi8(_mm_max_epu8(bytes, control), control));
+        const int mask = _mm_movemask_epi8(special);
+        if (mask == 0) {
+            current += 16;
+            continue;
+        }
+        current += __builtin_ctz(mask);
+        output.append(run, current);
+        appendEscape(output, static_cast<unsigned char>(*current));
+        run = ++current;
+    }
+#endif
+
+    for (; current != end; ++current) {
+        const unsigned char byte = static_cast<unsigned char>(*current);
+        if (table.escapes[byte] == 0)
+            continue;
+        output.append(run, current);
+        appendEscape(output, byte);
+        run = current + 1;
+    }
+    output.append(run, end);
+}
+
+void JsonWriter::separate()
+{
+    if (afterKey_) {
+        afterKey_ = false;
+        return;
+    }
+    if (nested_.empty())
+        return;
+    if (nested_.back())
+        nested_.back() = false;
+    else
+        *output_ += ',';
+}
+
+JsonWriter& JsonWriter::beginObject()
+{
+    separate();
+    *output_ += '{';
+    nested_.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    nested_.pop_back();
+    *output_ += '}';
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    separate();
+    *output_ += '[';
+    nested_.push_back(true);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    nested_.pop_back();
+    *output_ += ']';
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name)
+{
+    separate();
+    *output_ += '"';
+    escape(*output_, name);
+    *output_ += "\":";
+    afterKey_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text)
+{
+    separate();
+    *output_ += '"';
+    escape(*output_, text);
+    *output_ += '"';
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag)
+{
+    separate();
+    *output_ += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::nullptr_t)
+{
+    separate();
+    *output_ += "null";
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number)
+{
+    // JSON has no infinities nor NaN
+    if (!std::isfinite(number))
+        return value(nullptr);
+    separate();
+    // without a precision to_chars writes the shortest representation
+    // that round trips (Ryu)
+    char digits[32];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    output_->append(digits, result.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json)
+{
+    separate();
+    output_->append(json);
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(long long number)
+{
+    separate();
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    output_->append(digits, result.ptr);
+    return *this;
+}
+
+JsonWriter& JsonWriter::integer(unsigned long long number)
+{
+    separate();
+    char digits[24];
+    const auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    output_->append(digits, result.ptr);
+    return *this;
+}
+
+} // Server namespace
+} // Wizrd namespace
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+#include "response.h"
+
+namespace Wizrd { namespace Server {
+
+/// writes a JSON document straight into a string, usually the body of a
+/// response, without building a tree first. Commas and nesting are kept
+/// track of, strings are escaped and numbers written in their shortest
+/// form that reads back to the same value
+class JsonWriter
+{
+public:
+    JsonWriter() = default;
+    explicit JsonWriter(std::string& output) : output_(&output) {}
+
+    /// writes into output from now on, keeping the nesting (streams write
+    /// each chunk into another buffer)
+    inline void rebind(std::string& output) noexcept { output_ = &output; }
+    inline std::string& output() noexcept { return *output_; }
+    inline size_t depth() const noexcept { return nested_.size(); }
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(std::string_view name);
+    inline JsonWriter& key(boost::string_ref name) { return key(std::string_view(name.data(), name.size())); }
+    inline JsonWriter& key(const char* name) { return key(std::string_view(name)); }
+    template <class Allocator>
+    inline JsonWriter& key(const std::basic_string<char, std::char_traits<char>, Allocator>& name)
+    {
+        return key(std::string_view(name));
+    }
+
+    JsonWriter& value(std::string_view text);
+    inline JsonWriter& value(boost::string_ref text) { return value(std::string_view(text.data(), text.size())); }
+    inline JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    template <class Allocator>
+    inline JsonWriter& value(const std::basic_string<char, std::char_traits<char>, Allocator>& text)
+    {
+        return value(std::string_view(text));
+    }
+    JsonWriter& value(bool flag);
+    JsonWriter& value(std::nullptr_t);
+    JsonWriter& value(double number);
+    template <class Integer>
+        requires (std::is_integral_v<Integer> && !std::is_same_v<Integer, bool>)
+    inline JsonWriter& value(Integer number)
+    {
+        if constexpr (std::is_signed_v<Integer>)
+            return integer(static_cast<long long>(number));
+        else
+            return integer(static_cast<unsigned long long>(number));
+    }
+    inline JsonWriter& value(float number) { return value(static_cast<double>(number)); }
+
+    /// writes already serialized JSON as the next value
+    JsonWriter& raw(std::string_view json);
+
+    /// writes range as an array, element(writer, item) writes each item
+    template <class Range, class Function>
+    JsonWriter& array(const Range& range, Function element)
+    {
+        beginArray();
+        for (const auto& item: range)
+            element(*this, item);
+        return endArray();
+    }
+
+    /// appends text escaped as the content of a JSON string
+    static void escape(std::string& output, std::string_view text);
+
+private:
+    // writes the comma before a value unless it is the first one of its
+    // container or follows a key
+    void separate();
+    JsonWriter& integer(long long number);
+    JsonWriter& integer(unsigned long long number);
+
+    std::string* output_ = nullptr;
+    // per open container, whether it has no value yet
+    std::vector<bool> nested_;
+    bool afterKey_ = false;
+};
+
+/// sends the document written by producer chunk by chunk, large arrays are
+/// never held whole. producer(JsonWriter&) writes the next part of the
+/// document, typically a batch of array items, and returns false once it
+/// is over; the writer writes into the buffer of the connection and keeps
+/// its nesting from one call to the next
+template <class Producer>
+void streamJson(Response& response, Producer producer)
+{
+    response.addHeader("Content-Type", "application/json");
+    response.stream = [writer = JsonWriter(), producer = std::move(producer)](std::string& output) mutable {
+        writer.rebind(output);
+        return producer(writer);
+    };
+}
+
+}}
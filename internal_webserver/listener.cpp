@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "listener.h"
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace Wizrd::Server;
+
+namespace {
+
+// asio only ships the portable options, these are the linux specific ones
+template <int Level, int Name>
+class IntegerOption
+{
+public:
+    explicit IntegerOption(int value) : value_(value) {}
+    template <class Protocol> int level(const Protocol&) const { return Level; }
+    template <class Protocol> int name(const Protocol&) const { return Name; }
+    template <class Protocol> const int* data(const Protocol&) const { return &value_; }
+    template <class Protocol> std::size_t size(const Protocol&) const { return sizeof(value_); }
+private:
+    int value_;
+};
+
+using NoDelay = IntegerOption<IPPROTO_TCP, TCP_NODELAY>;
+using DeferAccept = IntegerOption<IPPROTO_TCP, TCP_DEFER_ACCEPT>;
+using FastOpen = IntegerOption<IPPROTO_TCP, TCP_FASTOPEN>;
+using BusyPoll = IntegerOption<SOL_SOCKET, SO_BUSY_POLL>;
+using ReusePort = IntegerOption<SOL_SOCKET, SO_REUSEPORT>;
+
+}
+
+Listener::Listener(boost::asio::io_context& ioContext, const ip::tcp::endpoint& endpoint,
+                   const TcpOptions& options, Handler handler)
+    : acceptor_(ioContext),
+      retryTimer_(ioContext),
+      handler_(std::move(handler)),
+      tcp_(true),
+      tcpOptions_(options),
+      acceptBatch_(options.acceptBatch)
+{
+    const StreamProtocol::endpoint genericEndpoint(endpoint);
+    acceptor_.open(genericEndpoint.protocol());
+    acceptor_.set_option(boost::asio::socket_base::reuse_address(true));
+    if (options.reusePort)
+        acceptor_.set_option(ReusePort(1));
+    if (options.deferAccept)
+        acceptor_.set_option(DeferAccept(options.deferAccept));
+    if (options.fastOpen)
+        acceptor_.set_option(FastOpen(options.fastOpen));
+    acceptor_.bind(genericEndpoint);
+    acceptor_.listen(options.backlog);
+    acceptor_.non_blocking(true);
+}
+
+Listener::Listener(boost::asio::io_context& ioContext, const std::string& path,
+                   const UnixOptions& options, Handler handler)
+    : acceptor_(ioContext),
+      retryTimer_(ioContext),
+      handler_(std::move(handler)),
+      tcp_(false),
+      acceptBatch_(options.acceptBatch),
+      path_(path)
+{
+    // a socket file left behind by a previous run would make bind fail,
+    // anything that is not a socket is left alone
+    struct stat status;
+    if (::stat(path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        ::unlink(path.c_str());
+
+    const StreamProtocol::endpoint genericEndpoint(local::stream_protocol::endpoint{path});
+    acceptor_.open(genericEndpoint.protocol());
+    acceptor_.bind(genericEndpoint);
+    if (options.permissions)
+        ::chmod(path.c_str(), options.permissions);
+    acceptor_.listen(options.backlog);
+    acceptor_.non_blocking(true);
+}
+
+Listener::~Listener()
+{
+    stop();
+}
+
+void Listener::start()
+{
+    accept();
+}
+
+void Listener::stop()
+{
+    if (!acceptor_.is_open())
+        return;
+    boost::system::error_code ignored;
+    retryTimer_.cancel();
+    acceptor_.close(ignored);
+    if (!path_.empty())
+        ::unlink(path_.c_str());
+}
+
+StreamProtocol::endpoint Listener::endpoint() const
+{
+    return acceptor_.local_endpoint();
+}
+
+unsigned short Listener::port() const
+{
+    if (!tcp_)
+        return 0;
+    const StreamProtocol::endpoint bound = acceptor_.local_endpoint();
+    if (bound.data()->sa_family == AF_INET6)
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(bound.data())->sin6_port);
+    return ntohs(reinterpret_cast<const sockaddr_in*>(bound.data())->sin_port);
+}
+
+void Listener::accept()
+{
+    acceptor_.async_accept(
+    [this](boost::system::error_code errorCode, StreamProtocol::socket socket)
+    {
+        if (errorCode == boost::asio::error::operation_aborted || !acceptor_.is_open())
+            return;
+        if (errorCode) {
+            // out of descriptors or buffers (EMFILE, ENFILE, ENOBUFS), the
+            // connection stays queued and accepting again at once would spin
+            retryTimer_.expires_after(RetryDelay);
+            retryTimer_.async_wait([this](boost::system::error_code errorCode) {
+                if (!errorCode && acceptor_.is_open())
+                    accept();
+            });
+            return;
+        }
+        configure(socket);
+        handler_(std::move(socket));
+        // drain whatever else is already queued without going back to
+        // the reactor for each connection
+        for (int i = 1; i < acceptBatch_; i++) {
+            StreamProtocol::socket next = acceptor_.accept(errorCode);
+            if (errorCode)
+                break;
+            configure(next);
+            handler_(std::move(next));
+        }
+        accept();
+    });
+}
+
+void Listener::configure(StreamProtocol::socket& socket)
+{
+    if (!tcp_)
+        return;
+    boost::system::error_code ignored;
+    if (tcpOptions_.noDelay)
+        socket.set_option(NoDelay(1), ignored);
+    if (tcpOptions_.busyPoll)
+        socket.set_option(BusyPoll(tcpOptions_.busyPoll), ignored);
+}
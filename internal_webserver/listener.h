@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+// boost 1.74 asio uses std::exchange without including <utility> in C++20
+#include <utility>
+#include <boost/asio.hpp>
+
+namespace Wizrd { namespace Server {
+
+namespace ip = boost::asio::ip;
+namespace local = boost::asio::local;
+
+/// every endpoint type (tcp, unix) is carried over the same generic stream
+/// socket, so connections don't care where they came from
+using StreamProtocol = boost::asio::generic::stream_protocol;
+using StreamAcceptor = boost::asio::basic_socket_acceptor<StreamProtocol>;
+
+/// socket options profile of a tcp listener, the sockets it accepts
+/// inherit the per connection options
+struct TcpOptions {
+    bool noDelay = true;
+    bool reusePort = false;
+    /// TCP_DEFER_ACCEPT, seconds to wait for data before waking up accept, 0 disables
+    int deferAccept = 0;
+    /// TCP_FASTOPEN pending queue length, 0 disables
+    int fastOpen = 0;
+    /// SO_BUSY_POLL on accepted sockets, microseconds, 0 disables
+    int busyPoll = 0;
+    int backlog = boost::asio::socket_base::max_listen_connections;
+    /// connections accepted per accept wakeup
+    int acceptBatch = 16;
+};
+
+struct UnixOptions {
+    int backlog = boost::asio::socket_base::max_listen_connections;
+    int acceptBatch = 16;
+    /// mode of the socket file, 0 keeps the one given by the umask
+    int permissions = 0;
+};
+
+class Listener
+{
+public:
+    using Handler = std::function<void(StreamProtocol::socket)>;
+
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+    Listener(boost::asio::io_context& ioContext, const ip::tcp::endpoint& endpoint,
+             const TcpOptions& options, Handler handler);
+    Listener(boost::asio::io_context& ioContext, const std::string& path,
+             const UnixOptions& options, Handler handler);
+    ~Listener();
+
+    void start();
+    void stop();
+
+    StreamProtocol::endpoint endpoint() const;
+    /// port of a tcp listener (the one picked for port 0), 0 for a unix one
+    unsigned short port() const;
+    inline StreamAcceptor::native_handle_type nativeHandle()
+    {
+        return acceptor_.native_handle();
+    }
+
+private:
+    /// pause before accepting again after an accept error
+    static constexpr std::chrono::milliseconds RetryDelay{50};
+
+    void accept();
+    void configure(StreamProtocol::socket& socket);
+
+    StreamAcceptor acceptor_;
+    boost::asio::steady_timer retryTimer_;
+    Handler handler_;
+    bool tcp_;
+    TcpOptions tcpOptions_;
+    int acceptBatch_;
+    std::string path_;
+};
+
+}}
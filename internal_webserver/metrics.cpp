@@ -0,0 +1,429 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "metrics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+#include "response.h"
+
+namespace Wizrd { namespace Server {
+
+namespace {
+
+struct RouteHistograms
+{
+    std::array<LatencyHistogram, Metrics::PhaseCount> phases;
+};
+
+// what a thread records, or what the exited ones did
+struct ThreadMetrics
+{
+    ~ThreadMetrics()
+    {
+        for (auto& histograms: routes)
+            delete histograms.load(std::memory_order_relaxed);
+    }
+
+    // allocated on the first request of a route on the thread
+    RouteHistograms* histograms(uint32_t route) noexcept
+    {
+        auto& slot = routes[route];
+        RouteHistograms* histograms = slot.load(std::memory_order_relaxed);
+        if (!histograms) {
+            histograms = new (std::nothrow) RouteHistograms;
+            slot.store(histograms, std::memory_order_release);
+        }
+        return histograms;
+    }
+
+    std::array<std::atomic<uint64_t>, Metrics::CounterCount> counters{};
+    std::array<std::atomic<RouteHistograms*>, Metrics::MaxRoutes> routes{};
+};
+
+using Threads = std::vector<std::shared_ptr<ThreadMetrics>>;
+
+struct Registry
+{
+    std::mutex mutex;
+    // the live threads, and first the aggregate of the exited ones
+    Threads threads{std::make_shared<ThreadMetrics>()};
+    std::vector<std::string> patterns{std::string()};
+    std::unordered_map<std::string, uint32_t> ids;
+    // held shared while the blocks are added together and exclusively while
+    // one is folded into the aggregate, so it is never counted twice
+    std::shared_mutex retiring;
+};
+
+// never destroyed, threads may record while the statics are torn down
+Registry& registry()
+{
+    static Registry* registry = new Registry;
+    return *registry;
+}
+
+// the blocks to add together, the caller holds retiring shared
+Threads threads(Registry& shared)
+{
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    return shared.threads;
+}
+
+void retire(ThreadMetrics* metrics)
+{
+    Registry& shared = registry();
+    std::unique_lock<std::shared_mutex> retiring(shared.retiring);
+    ThreadMetrics& retired = *shared.threads.front();
+    for (size_t i = 0; i < Metrics::CounterCount; i++) {
+        retired.counters[i].store(retired.counters[i].load(std::memory_order_relaxed) +
+                                  metrics->counters[i].load(std::memory_order_relaxed),
+                                  std::memory_order_relaxed);
+    }
+    for (uint32_t route = 0; route < Metrics::MaxRoutes; route++) {
+        const RouteHistograms* histograms = metrics->routes[route].load(std::memory_order_relaxed);
+        RouteHistograms* merged = histograms ? retired.histograms(route) : nullptr;
+        if (!merged)
+            continue;
+        for (int phase = 0; phase < Metrics::PhaseCount; phase++)
+            merged->phases[phase].merge(histograms->phases[phase]);
+    }
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.threads.erase(std::find_if(shared.threads.begin(), shared.threads.end(),
+                                      [metrics](const std::shared_ptr<ThreadMetrics>& thread) {
+                                          return thread.get() == metrics;
+                                      }));
+}
+
+// plain thread locals, still usable while the thread is being torn down
+thread_local ThreadMetrics* current = nullptr;
+thread_local bool exited = false;
+
+// folds the block of the thread into the aggregate when the thread exits
+struct Retirer
+{
+    ~Retirer()
+    {
+        retire(current);
+        current = nullptr;
+        exited = true;
+    }
+};
+
+ThreadMetrics& local()
+{
+    if (!current) {
+        Registry& shared = registry();
+        auto metrics = std::make_shared<ThreadMetrics>();
+        current = metrics.get();
+        {
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.threads.push_back(std::move(metrics));
+        }
+        // what is recorded by the destructors of other thread locals, after
+        // the block was retired, keeps a block of its own
+        if (!exited) {
+            thread_local Retirer retirer;
+            (void)retirer;
+        }
+    }
+    return *current;
+}
+
+std::atomic<bool> active{true};
+
+const char* const phaseNames[] = {"read", "parse", "route", "handler", "serialize", "write"};
+
+// label values escape backslashes, double quotes and new lines
+void appendLabel(std::string& output, boost::string_ref value)
+{
+    for (char chr: value) {
+        if (chr == '\\' || chr == '"')
+            output += '\\';
+        if (chr == '\n')
+            output += "\\n";
+        else
+            output += chr;
+    }
+}
+
+void appendNumber(std::string& output, double value)
+{
+    char number[32];
+    const int size = std::snprintf(number, sizeof(number), "%.9g", value);
+    output.append(number, size);
+}
+
+void appendCounter(std::string& output, const char* name, const char* type, const char* help,
+                   uint64_t value)
+{
+    output += "# HELP ";
+    output += name;
+    output += ' ';
+    output += help;
+    output += "\n# TYPE ";
+    output += name;
+    output += ' ';
+    output += type;
+    output += '\n';
+    output += name;
+    output += ' ';
+    output += std::to_string(value);
+    output += '\n';
+}
+
+}
+
+size_t LatencyHistogram::bucket(uint64_t value) noexcept
+{
+    const uint64_t max = (uint64_t(1) << MaxBits) - 1;
+    if (value > max)
+        value = max;
+    if (value < (uint64_t(1) << SubBucketBits))
+        return value;
+    const int msb = 63 - __builtin_clzll(value);
+    return ((msb - SubBucketBits + 1) << SubBucketBits) +
+           ((value >> (msb - SubBucketBits)) & ((1 << SubBucketBits) - 1));
+}
+
+uint64_t LatencyHistogram::upperBound(size_t bucket) noexcept
+{
+    if (bucket < (size_t(1) << SubBucketBits))
+        return bucket;
+    const int msb = static_cast<int>(bucket >> SubBucketBits) + SubBucketBits - 1;
+    const uint64_t sub = bucket & ((1 << SubBucketBits) - 1);
+    const uint64_t width = uint64_t(1) << (msb - SubBucketBits);
+    return (((uint64_t(1) << SubBucketBits) + sub) << (msb - SubBucketBits)) + width - 1;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept
+{
+    for (size_t i = 0; i < Buckets; i++)
+        bump(buckets_[i], other.buckets_[i].load(std::memory_order_relaxed));
+    bump(count_, other.count_.load(std::memory_order_relaxed));
+    bump(sum_, other.sum_.load(std::memory_order_relaxed));
+}
+
+void LatencyHistogram::Snapshot::add(const LatencyHistogram& histogram) noexcept
+{
+    for (size_t i = 0; i < Buckets; i++)
+        counts[i] += histogram.buckets_[i].load(std::memory_order_relaxed);
+    count += histogram.count_.load(std::memory_order_relaxed);
+    sum += histogram.sum_.load(std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Snapshot::record(uint64_t value, uint64_t times) noexcept
+{
+    counts[bucket(value)] += times;
+    count += times;
+    sum += value * times;
+}
+
+uint64_t LatencyHistogram::Snapshot::quantile(double q) const noexcept
+{
+    // the buckets are read one by one while being written, their total
+    // may be a little off count
+    uint64_t total = 0;
+    for (uint64_t bucketCount: counts)
+        total += bucketCount;
+    if (!total)
+        return 0;
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+    if (rank < 1)
+        rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < Buckets; i++) {
+        seen += counts[i];
+        if (seen >= rank)
+            return upperBound(i);
+    }
+    return upperBound(Buckets - 1);
+}
+
+bool Metrics::enabled() noexcept
+{
+    return active.load(std::memory_order_relaxed);
+}
+
+void Metrics::setEnabled(bool enabled) noexcept
+{
+    active.store(enabled, std::memory_order_relaxed);
+}
+
+uint32_t Metrics::routeId(boost::string_ref pattern)
+{
+    if (pattern.empty())
+        return 0;
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    const auto found = shared.ids.find(pattern.to_string());
+    if (found != shared.ids.end())
+        return found->second;
+    if (shared.patterns.size() >= MaxRoutes)
+        return 0;
+    const auto id = static_cast<uint32_t>(shared.patterns.size());
+    shared.patterns.push_back(pattern.to_string());
+    shared.ids.emplace(pattern.to_string(), id);
+    return id;
+}
+
+void Metrics::record(uint32_t route, Phase phase, Clock::duration elapsed) noexcept
+{
+    if (!enabled())
+        return;
+    if (route >= MaxRoutes)
+        route = 0;
+    RouteHistograms* histograms = local().histograms(route);
+    if (!histograms)
+        return;
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    histograms->phases[phase].record(nanoseconds > 0 ? static_cast<uint64_t>(nanoseconds) : 0);
+}
+
+void Metrics::count(Counter counter, uint64_t value) noexcept
+{
+    if (!enabled())
+        return;
+    auto& total = local().counters[counter];
+    total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+namespace {
+
+uint64_t sum(const Threads& threads, Metrics::Counter counter) noexcept
+{
+    uint64_t total = 0;
+    for (const auto& thread: threads)
+        total += thread->counters[counter].load(std::memory_order_relaxed);
+    return total;
+}
+
+LatencyHistogram::Snapshot merge(const Threads& threads, uint32_t route, Metrics::Phase phase) noexcept
+{
+    LatencyHistogram::Snapshot snapshot;
+    for (const auto& thread: threads) {
+        if (const RouteHistograms* histograms = thread->routes[route].load(std::memory_order_acquire))
+            snapshot.add(histograms->phases[phase]);
+    }
+    return snapshot;
+}
+
+}
+
+uint64_t Metrics::total(Counter counter) noexcept
+{
+    Registry& shared = registry();
+    std::shared_lock<std::shared_mutex> retiring(shared.retiring);
+    return sum(threads(shared), counter);
+}
+
+LatencyHistogram::Snapshot Metrics::snapshot(uint32_t route, Phase phase) noexcept
+{
+    if (route >= MaxRoutes)
+        return LatencyHistogram::Snapshot();
+    Registry& shared = registry();
+    std::shared_lock<std::shared_mutex> retiring(shared.retiring);
+    return merge(threads(shared), route, phase);
+}
+
+void Metrics::write(std::string& output)
+{
+    static const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+    Registry& shared = registry();
+    std::shared_lock<std::shared_mutex> retiring(shared.retiring);
+    Threads threads;
+    std::vector<std::string> patterns;
+    {
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        threads = shared.threads;
+        patterns = shared.patterns;
+    }
+
+    output += "# HELP wizrd_request_phase_seconds Time spent in each phase of the requests, per route\n"
+              "# TYPE wizrd_request_phase_seconds summary\n";
+    for (uint32_t route = 0; route < patterns.size(); route++) {
+        std::string labels = "route=\"";
+        if (route == 0)
+            labels += "unmatched";
+        else
+            appendLabel(labels, patterns[route]);
+        labels += "\",phase=\"";
+        for (int phase = 0; phase < PhaseCount; phase++) {
+            const auto merged = merge(threads, route, static_cast<Phase>(phase));
+            if (!merged.count)
+                continue;
+            const std::string series = labels + phaseNames[phase] + '"';
+            for (double q: quantiles) {
+                output += "wizrd_request_phase_seconds{";
+                output += series;
+                output += ",quantile=\"";
+                appendNumber(output, q);
+                output += "\"} ";
+                appendNumber(output, merged.quantile(q) * 1e-9);
+                output += '\n';
+            }
+            output += "wizrd_request_phase_seconds_sum{";
+            output += series;
+            output += "} ";
+            appendNumber(output, merged.sum * 1e-9);
+            output += "\nwizrd_request_phase_seconds_count{";
+            output += series;
+            output += "} ";
+            output += std::to_string(merged.count);
+            output += '\n';
+        }
+    }
+
+    const uint64_t opened = sum(threads, ConnectionsOpened);
+    const uint64_t closed = sum(threads, ConnectionsClosed);
+    appendCounter(output, "wizrd_received_bytes_total", "counter", "Bytes read from clients",
+                  sum(threads, BytesIn));
+    appendCounter(output, "wizrd_sent_bytes_total", "counter", "Bytes written to clients",
+                  sum(threads, BytesOut));
+    appendCounter(output, "wizrd_connections_total", "counter", "Connections accepted", opened);
+    appendCounter(output, "wizrd_connections_active", "gauge", "Connections open",
+                  opened > closed ? opened - closed : 0);
+    appendCounter(output, "wizrd_parse_errors_total", "counter", "Requests rejected by the parser",
+                  sum(threads, ParseErrors));
+    appendCounter(output, "wizrd_keepalive_reuses_total", "counter",
+                  "Requests read from a connection that served one before",
+                  sum(threads, KeepAliveReuses));
+}
+
+RequestHandler Metrics::handler()
+{
+    return [](Request&, Response& response) {
+        response.body.clear();
+        write(response.body);
+        response.addHeader("Content-Type", "text/plain; version=0.0.4");
+    };
+}
+
+}}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <boost/utility/string_ref.hpp>
+#include "requesthandler.h"
+
+namespace Wizrd { namespace Server {
+
+/// HDR style histogram of nanoseconds: 8 buckets per power of two, so that
+/// values are kept within 12.5%, up to about 18 minutes. It is written by
+/// a single thread, other ones may read it at any time
+class LatencyHistogram
+{
+public:
+    static const int SubBucketBits = 3;
+    static const int MaxBits = 40;
+    static const size_t Buckets = (MaxBits - SubBucketBits + 1) << SubBucketBits;
+
+    /// histograms of several threads added together
+    struct Snapshot
+    {
+        std::array<uint64_t, Buckets> counts{};
+        uint64_t count = 0;
+        uint64_t sum = 0;
+
+        void add(const LatencyHistogram& histogram) noexcept;
+        /// adds times samples of value
+        void record(uint64_t value, uint64_t times = 1) noexcept;
+        /// value that a fraction q of the recorded ones do not exceed, as
+        /// the upper bound of its bucket
+        uint64_t quantile(double q) const noexcept;
+    };
+
+    /// adds the samples of other, by the writer of this histogram
+    void merge(const LatencyHistogram& other) noexcept;
+
+    inline void record(uint64_t nanoseconds) noexcept
+    {
+        bump(buckets_[bucket(nanoseconds)], 1);
+        bump(count_, 1);
+        bump(sum_, nanoseconds);
+    }
+
+    static size_t bucket(uint64_t value) noexcept;
+    static uint64_t upperBound(size_t bucket) noexcept;
+
+private:
+    // a plain increment, the only writer is the owning thread
+    static inline void bump(std::atomic<uint64_t>& counter, uint64_t value) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, Buckets> buckets_{};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+};
+
+/// latency of the phases of the requests, per route, and server counters.
+/// Threads record into their own histograms and counters, which are only
+/// added together when scraped, so recording takes no lock and shares no
+/// cache line. What a thread recorded is folded into a shared aggregate
+/// when it exits. Routes get their id when they are added to a Router
+class Metrics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum Phase {
+        /// from the first to the last byte of the request
+        Read,
+        Parse,
+        /// finding the handler, for every request, matched or not
+        Route,
+        /// the handler, up to the point it returns or defers the response
+        Handler,
+        Serialize,
+        /// from the first write of the response to the completion of the last
+        Write,
+        PhaseCount
+    };
+
+    enum Counter {
+        BytesIn,
+        BytesOut,
+        ConnectionsOpened,
+        ConnectionsClosed,
+        ParseErrors,
+        /// requests read from a connection that served one already
+        KeepAliveReuses,
+        CounterCount
+    };
+
+    /// routes past it share the id of requests without route
+    static const size_t MaxRoutes = 1024;
+
+    static bool enabled() noexcept;
+    /// recording is on by default
+    static void setEnabled(bool enabled) noexcept;
+
+    /// the time, or the epoch when disabled so that nothing is measured
+    static inline Clock::time_point now() noexcept
+    {
+        return enabled() ? Clock::now() : Clock::time_point();
+    }
+
+    /// id of the route with pattern, the same for the same pattern; 0 is
+    /// for requests without route
+    static uint32_t routeId(boost::string_ref pattern);
+
+    static void record(uint32_t route, Phase phase, Clock::duration elapsed) noexcept;
+    static void count(Counter counter, uint64_t value = 1) noexcept;
+
+    /// everything recorded so far, in the Prometheus text format
+    static void write(std::string& output);
+    /// answers with write(), what runApps serves at /metrics
+    static RequestHandler handler();
+
+    /// sums of the counters and histograms of every thread
+    static uint64_t total(Counter counter) noexcept;
+    static LatencyHistogram::Snapshot snapshot(uint32_t route, Phase phase) noexcept;
+};
+
+}}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <concepts>
+#include <tuple>
+#include <utility>
+#include "staticroute.h"
+
+namespace Wizrd { namespace Server {
+
+namespace Detail {
+
+// hooks are optional, before may return false to answer the request
+// without running the next layers and the handler
+template <class Layer>
+inline bool before(Layer& layer, Request& request, Response& response)
+{
+    if constexpr (requires { { layer.before(request, response) } -> std::convertible_to<bool>; }) {
+        return layer.before(request, response);
+    }
+    else if constexpr (requires { layer.before(request, response); }) {
+        layer.before(request, response);
+        return true;
+    }
+    else {
+        return true;
+    }
+}
+
+template <class Layer>
+inline void after(Layer& layer, Request& request, Response& response)
+{
+    if constexpr (requires { layer.after(request, response); })
+        layer.after(request, response);
+}
+
+}
+
+/// handler behind a chain of middleware (a tuple of layers), composed once
+/// when the route is added: the before hooks run in order, then the handler,
+/// then the after hooks of the layers that ran, in reverse order. Every
+/// call is direct, nothing is allocated per request
+template <class Chain, class Function>
+class Pipeline
+{
+public:
+    inline Pipeline(Chain& chain, Function function) : chain_(&chain), function_(std::move(function)) {}
+
+    /// captures are the converted captures of a compiled route, if any
+    template <class... Captures>
+    inline void operator()(Request& request, Response& response, Captures&... captures)
+    {
+        run<0>(request, response, captures...);
+    }
+
+private:
+    template <size_t I, class... Captures>
+    inline void run(Request& request, Response& response, Captures&... captures)
+    {
+        if constexpr (I == std::tuple_size<Chain>::value) {
+            auto arguments = std::tie(captures...);
+            Detail::invoke(function_, request, response, arguments);
+        }
+        else {
+            auto& layer = std::get<I>(*chain_);
+            if (Detail::before(layer, request, response))
+                run<I + 1>(request, response, captures...);
+            // a coroutine handler is still running, after hooks wait for it
+            if (response.responder && response.responder->deferred()) {
+                response.responder->onComplete([&layer, &request, &response]() {
+                    Detail::after(layer, request, response);
+                });
+            }
+            else {
+                Detail::after(layer, request, response);
+            }
+        }
+    }
+
+    Chain* chain_;
+    Function function_;
+};
+
+}}
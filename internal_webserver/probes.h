@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include "wizrd_config.h"
+
+/// static tracepoints of the "wizrd" provider, for perf, bpftrace or
+/// SystemTap. Built with -DUSE_USDT=ON they are a nop in the code and a
+/// note in the binary, otherwise nothing at all, arguments included:
+///
+///   connection__accept  (connection)
+///   connection__close   (connection)
+///   read__done          (connection, bytes)
+///   parse__start        (connection)
+///   headers__complete   (connection, method, headers)
+///   parse__done         (connection, method, body bytes, ok)
+///   handler__enter      (connection, method, route)
+///   handler__exit       (connection, method, route, status)
+///   write__done         (connection, bytes, status)
+///
+/// connection is BasicConnection::id(), method the value of Method and
+/// route the id Metrics::routeId gave to its pattern (0 for none). e.g.
+///   bpftrace -e 'usdt:./libwizrd_ws.so:wizrd:read__done { @[arg0] = sum(arg1); }'
+#ifdef USE_USDT
+#include <sys/sdt.h>
+#define WIZRD_PROBE(name, ...) STAP_PROBEV(wizrd, name __VA_OPT__(,) __VA_ARGS__)
+#else
+#define WIZRD_PROBE(name, ...) do {} while (false)
+#endif
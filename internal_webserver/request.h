@@ -26,18 +26,48 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <vector>
 #include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <boost/utility/string_ref.hpp>
+#include "utils/query.h"
 
 namespace Wizrd {
 namespace Server {
 
-using Header = std::vector<std::string>;
+/// strings of a request live in its memory resource, see Arena
+using String = std::pmr::string;
+using Header = std::pmr::vector<String>;
+using Headers = std::pmr::vector<Header>;
 
+/// value of the first header called name (case insensitive), empty if none
+inline boost::string_ref headerValue(const Headers& headers, boost::string_ref name) noexcept
+{
+    for (const Header& header: headers) {
+        if (header.size() > 1 && header[0].size() == name.size() &&
+            std::equal(name.begin(), name.end(), header[0].begin(), [](char a, char b) {
+                return (a >= 'A' && a <= 'Z' ? a - 'A' + 'a' : a) == (b >= 'A' && b <= 'Z' ? b - 'A' + 'a' : b);
+            }))
+            return boost::string_ref(header[1].data(), header[1].size());
+    }
+    return boost::string_ref();
+}
 
-using Headers = std::vector<Header>;
+/// appends the header name: value, allocated from the resource of headers
+inline void appendHeader(Headers& headers, boost::string_ref name, boost::string_ref value)
+{
+    Header& header = headers.emplace_back();
+    header.reserve(2);
+    header.emplace_back(name.data(), name.size());
+    header.emplace_back(value.data(), value.size());
+}
 
 enum class Method {
     GET,
@@ -52,20 +82,198 @@ enum class Method {
     CUSTOM
 };
 
+inline Method methodFromString(std::string_view method)
+{
+    static const std::unordered_map<std::string_view, Method> methodTable{{"GET", Method::GET},
+                                                                          {"HEAD", Method::HEAD},
+                                                                          {"POST", Method::POST},
+                                                                          {"PUT", Method::PUT},
+                                                                          {"DELETE", Method::DELETE},
+                                                                          {"TRACE", Method::TRACE},
+                                                                          {"OPTIONS", Method::OPTIONS},
+                                                                          {"CONNECT", Method::CONNECT},
+                                                                          {"PATCH", Method::PATCH}};
+    const auto found = methodTable.find(method);
+    return found != methodTable.end() ? found->second : Method::CUSTOM;
+}
+
+/// path parameters captured by the router, names are views into the route
+/// pattern and values views into Request::url, so they are only valid while
+/// the url is not changed
+class PathParameters {
+public:
+    static const size_t Max = 8;
+
+    inline bool push(boost::string_ref name, boost::string_ref value) noexcept
+    {
+        if (size_ == Max)
+            return false;
+        items_[size_++] = std::make_pair(name, value);
+        return true;
+    }
+    inline void pop() noexcept { size_--; }
+    inline void clear() noexcept { size_ = 0; }
+    inline size_t size() const noexcept { return size_; }
+    inline bool empty() const noexcept { return size_ == 0; }
+    inline boost::string_ref name(size_t index) const noexcept { return items_[index].first; }
+    inline boost::string_ref value(size_t index) const noexcept { return items_[index].second; }
+    /// value of the parameter called name, empty if there is none
+    inline boost::string_ref operator[](boost::string_ref name) const noexcept
+    {
+        for (size_t i = 0; i < size_; i++) {
+            if (items_[i].first == name)
+                return items_[i].second;
+        }
+        return boost::string_ref();
+    }
+
+private:
+    std::array<std::pair<boost::string_ref, boost::string_ref>, Max> items_;
+    size_t size_ = 0;
+};
+
+/// cookies of the Cookie headers of a request as views into them, split
+/// once on first use (see Request::cookies). A copy is not split yet, its
+/// views would point into the headers of the original
+class Cookies {
+public:
+    typedef std::pair<boost::string_ref, boost::string_ref> Cookie;
+
+    explicit Cookies(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : items_(resource)
+    {
+    }
+    Cookies(const Cookies& other) : items_(other.items_.get_allocator()) {}
+    inline Cookies& operator=(const Cookies&) noexcept
+    {
+        items_.clear();
+        parsed_ = false;
+        return *this;
+    }
+
+    inline bool parsed() const noexcept { return parsed_; }
+    /// splits the Cookie headers of headers, name=value pairs separated by
+    /// semicolons; quoted values are unquoted
+    void parse(const Headers& headers)
+    {
+        items_.clear();
+        parsed_ = true;
+        for (const Header& header: headers) {
+            if (header.size() < 2 || !equalNoCase(header[0], "cookie"))
+                continue;
+            boost::string_ref rest(header[1].data(), header[1].size());
+            while (!rest.empty()) {
+                const size_t end = std::min(rest.find(';'), rest.size());
+                boost::string_ref pair = trim(rest.substr(0, end));
+                rest.remove_prefix(std::min(end + 1, rest.size()));
+                const size_t equals = pair.find('=');
+                if (equals == 0 || equals == boost::string_ref::npos)
+                    continue;
+                boost::string_ref value = trim(pair.substr(equals + 1));
+                if (value.size() > 1 && value.front() == '"' && value.back() == '"')
+                    value = value.substr(1, value.size() - 2);
+                items_.emplace_back(trim(pair.substr(0, equals)), value);
+            }
+        }
+    }
+
+    inline size_t size() const noexcept { return items_.size(); }
+    inline bool empty() const noexcept { return items_.empty(); }
+    inline auto begin() const noexcept { return items_.begin(); }
+    inline auto end() const noexcept { return items_.end(); }
+    inline bool contains(boost::string_ref name) const noexcept { return find(name) != items_.end(); }
+    /// value of the first cookie called name, empty if there is none
+    inline boost::string_ref operator[](boost::string_ref name) const noexcept
+    {
+        const auto found = find(name);
+        return found != items_.end() ? found->second : boost::string_ref();
+    }
+
+private:
+    inline std::pmr::vector<Cookie>::const_iterator find(boost::string_ref name) const noexcept
+    {
+        return std::find_if(items_.begin(), items_.end(), [name](const Cookie& cookie) {
+            return cookie.first == name;
+        });
+    }
+    static inline boost::string_ref trim(boost::string_ref text) noexcept
+    {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+            text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+            text.remove_suffix(1);
+        return text;
+    }
+    static inline bool equalNoCase(const String& text, boost::string_ref lower) noexcept
+    {
+        return text.size() == lower.size() &&
+               std::equal(lower.begin(), lower.end(), text.begin(), [](char a, char b) {
+                   return a == (b >= 'A' && b <= 'Z' ? b - 'A' + 'a' : b);
+               });
+    }
+
+    std::pmr::vector<Cookie> items_;
+    bool parsed_ = false;
+};
+
 struct Request {
-    std::string url;
-    std::string host;
-    std::string methodString;
-    std::string versionString;
-    bool keepAlive;
-    int connectionTimeout;
-    int versionMajor;
-    int versionMinor;
-    Method method;
-    std::string contentType;
-    int contentLength;
+    Request() = default;
+    /// every string and header is allocated from resource
+    explicit Request(std::pmr::memory_resource* resource)
+        : url(resource),
+          host(resource),
+          methodString(resource),
+          versionString(resource),
+          contentType(resource),
+          headers(resource),
+          data(resource),
+          cookies_(resource)
+    {
+    }
+
+    String url;
+    String host;
+    String methodString;
+    String versionString;
+    bool keepAlive = true;
+    int connectionTimeout = 15;
+    int versionMajor = 1;
+    int versionMinor = 1;
+    Method method = Method::GET;
+    String contentType;
+    int contentLength = -1;
     Headers headers;
-    std::string data;
+    String data;
+    PathParameters parameters;
+    /// id of the route that matched, for the Metrics, 0 if none did
+    uint32_t route = 0;
+    /// id of the connection it came from, for the probes
+    uint64_t connection = 0;
+
+    /// where the request is allocated, handlers may use it for scratch
+    /// memory that lives as long as the request
+    inline std::pmr::memory_resource* arena() const noexcept { return url.get_allocator().resource(); }
+
+    /// the cookies sent with the request, split on first use. They are views
+    /// into the headers, valid while the headers are not changed
+    inline const Cookies& cookies() const
+    {
+        if (!cookies_.parsed())
+            cookies_.parse(headers);
+        return cookies_;
+    }
+
+    /// the parameters of the query string of url, as views into it
+    inline QueryString query() const noexcept
+    {
+        boost::string_ref target(url.data(), url.size());
+        const size_t question = target.find('?');
+        if (question == boost::string_ref::npos)
+            return QueryString();
+        target.remove_prefix(question + 1);
+        return QueryString(target.substr(0, target.find('#')));
+    }
+
     inline std::string toString()
     {
         auto headerString = [](const Header& header) -> std::string {
@@ -103,6 +311,9 @@ struct Request {
         return os.str();
 
     }
+
+private:
+    mutable Cookies cookies_;
 };
 
 } // Server namespace
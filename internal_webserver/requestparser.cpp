@@ -1,10 +1,13 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/algorithm/string.hpp>
-#include <boost/log/trivial.hpp>
 #include <boost/utility/string_ref.hpp>
 #include <boost/format.hpp>
 #include "requestparser.h"
+#include "arena.h"
+#include "utils/log.h"
+#include "utils/uri.h"
 #include "utils/url.h"
+#include <algorithm>
 #include <iostream>
 
 
@@ -13,38 +16,38 @@ namespace Wizrd {
 namespace Server {
 using namespace std::string_literals;
 
-#define LOG BOOST_LOG_TRIVIAL(debug)
-
 RequestParser::RequestParser()
     :state_(Start),
+     currentImportantHeader_(None),
      consumedContent_(0)
 {
+    currentBuffer_.reserve(256);
+    currentHeader_.reserve(64);
 }
 
 
 //initializing only what matters in the request;
 void RequestParser::reset(Request &request)
 {
+    request.url.clear();
+    request.host.clear();
+    request.contentType.clear();
+    request.headers.clear();
+    request.data.clear();
+    request.parameters.clear();
+    request.route = 0;
+    request.connection = connection_;
     request.contentLength = -1;
     request.keepAlive = false;
     request.connectionTimeout = 15;
     consumedContent_ = 0;
+    absoluteTarget_ = false;
+    currentImportantHeader_ = None;
     currentBuffer_.clear();
-    currentBuffer_.reserve(8192);
 }
 
 RequestParser::ResultType RequestParser::consume(Request &request, char chr)
 {
-    static std::unordered_map<std::string, Wizrd::Server::Method> methodTable{{"GET", Method::GET},
-                                                                              {"HEAD", Method::HEAD},
-                                                                              {"POST", Method::POST},
-                                                                              {"PUT", Method::PUT},
-                                                                              {"DELETE", Method::DELETE},
-                                                                              {"TRACE", Method::TRACE},
-                                                                              {"OPTIONS", Method::OPTIONS},
-                                                                              {"CONNECT", Method::CONNECT},
-                                                                              {"PATCH", Method::PATCH}};
-
     // when there is a content length header, it should be respected
     // due to HTTP/1.1
     // the request.contentLength must be initialized as -1 in Start case
@@ -52,21 +55,15 @@ RequestParser::ResultType RequestParser::consume(Request &request, char chr)
     switch (state_)
     {
     case Start:
+        WIZRD_PROBE(parse__start, connection_);
         reset(request);
         state_ = Method;
     case Method:
         if (isUpperAlpha(chr))
             currentBuffer_ += chr;
         else if (isSpace(chr)) {
-            const auto method = methodTable.find(currentBuffer_);
-
-            if (method != methodTable.end()) {
-                request.method = method->second;
-            }
-            else {
-                request.method = Method::CUSTOM;
-            }
-            request.methodString = std::move(currentBuffer_);
+            request.method = methodFromString(currentBuffer_);
+            request.methodString.assign(currentBuffer_.data(), currentBuffer_.size());
             currentBuffer_.clear();
             state_ = Space_1;
         }
@@ -82,7 +79,16 @@ RequestParser::ResultType RequestParser::consume(Request &request, char chr)
     case Url:
         if(isSpace(chr))
         {
-            request.url = std::move(currentBuffer_);
+            RequestTarget target;
+            if (!RequestTarget::parse(currentBuffer_, target))
+                return Error;
+            // the authority of an absolute-form target replaces the Host
+            // header (RFC 7230 section 5.4)
+            absoluteTarget_ = target.form == RequestTarget::Absolute;
+            if (absoluteTarget_)
+                request.host.assign(target.authority.data(), target.authority.size());
+            currentBuffer_.resize(canonicalTarget(&currentBuffer_[0], target));
+            request.url.assign(currentBuffer_.data(), currentBuffer_.size());
             state_ = Space_2;
             currentBuffer_.clear();
         }
@@ -104,14 +110,12 @@ RequestParser::ResultType RequestParser::consume(Request &request, char chr)
                 currentBuffer_.clear();
             }
             else {
-                BOOST_LOG_TRIVIAL(debug) << "error parsing http word";
-                BOOST_LOG_TRIVIAL(debug) << "EXPECTING 'HTTP', got " << currentBuffer_;
+                WIZRD_LOG(Debug, "error parsing http word, expected 'HTTP', got {}", currentBuffer_);
                 return Error;
             }
         }
         else {
-            BOOST_LOG_TRIVIAL(debug) << "error parsing http word";
-            BOOST_LOG_TRIVIAL(debug) << "EXPECTING '/', got " << chr;
+            WIZRD_LOG(Debug, "error parsing http word, expected '/', got {}", chr);
             return Error;
         }
     case Version:
@@ -125,19 +129,21 @@ RequestParser::ResultType RequestParser::consume(Request &request, char chr)
             try{
                 // the only versions of HTTP accepted is \d.\d
                 if (currentBuffer_.length() != 3 || currentBuffer_[1] != '.') {
-                    BOOST_LOG_TRIVIAL(debug) << "expected \\d.\\d for http version, got " << currentHeader_;
+                    WIZRD_LOG(Debug, "expected \\d.\\d for http version, got {}", currentBuffer_);
                     return Error;
                 }
                 request.versionMajor = boost::lexical_cast<int>(currentBuffer_[0]);
                 request.versionMinor = boost::lexical_cast<int>(currentBuffer_[2]);
 
             }
-            catch (boost::bad_lexical_cast)
+            catch (const boost::bad_lexical_cast&)
             {
                 return Error;
             }
 
-            request.versionString = std::move(currentBuffer_);
+            // HTTP/1.1 connections are persistent by default
+            request.keepAlive = request.versionMajor == 1 && request.versionMinor >= 1;
+            request.versionString.assign(currentBuffer_.data(), currentBuffer_.size());
             currentBuffer_.clear();
             currentBuffer_ += chr;
         }
@@ -153,33 +159,24 @@ RequestParser::ResultType RequestParser::consume(Request &request, char chr)
         }
         else {
             currentBuffer_ += chr;
+            // request without headers
+            if (currentBuffer_ == "\r\n\r\n")
+                return headersComplete(request);
         }
         break;
     case Headers:
         return consumeHeaders(request, chr);
     case NewLine2:
-        if(!isNewLine(chr)){
-            if (currentBuffer_ != "\r\n") {
-                return Error;
-            }
-            currentBuffer_.clear();
-            if (request.contentLength != -1)
-                currentBuffer_.reserve(request.contentLength);
-            state_ = Data;
-        }
-        else {
-            currentBuffer_ += chr;
-            break;
-        }
+        if(!isNewLine(chr))
+            return Error;
+        currentBuffer_ += chr;
+        if (currentBuffer_ == "\r\n")
+            return headersComplete(request);
+        break;
     case Data:
-        // there actually two possible workflows here
-        // when you have content lenght (in a possible keep alive connection
-        // or when the connection is closed after the last byte
-        if (request.contentLength == -1 || request.contentLength > consumedContent_++)
-            currentBuffer_ += chr;
-        else if (request.contentLength != -1) {
-            request.data = std::move(currentBuffer_);
-            currentBuffer_.clear();
+        // only reached with a content length, the body ends with its last byte
+        request.data += chr;
+        if (request.contentLength <= ++consumedContent_) {
             consumedContent_ = 0;
             state_ = Start;
             return Ok;
@@ -189,26 +186,39 @@ RequestParser::ResultType RequestParser::consume(Request &request, char chr)
     return Processing;
 }
 
-RequestParser::ResultType RequestParser::consumeHeaders(Request &request, char chr)
+RequestParser::ResultType RequestParser::headersComplete(Request &request)
 {
-    static enum {
-        ContentType,
-        ContentLength,
-        Connection,
-        KeepAlive,
-        Max,
-        Host,
-        None
-    } currentImportantHeader = None;
+    WIZRD_PROBE(headers__complete, connection_, static_cast<int>(request.method),
+                request.headers.size());
+    currentBuffer_.clear();
+    // a request without Content-Length has no body, whatever its version
+    // (RFC 7230 section 3.3.3), anything after the headers is the next request
+    if (request.contentLength > WIZRD_MAX_BODY_SIZE) {
+        state_ = Start;
+        return TooLarge;
+    }
+    if (request.contentLength > 0) {
+        // the length is the client's word, only the first block of the
+        // arena is reserved and the body grows as it arrives
+        request.data.reserve(std::min<size_t>(request.contentLength, Arena::initialSize));
+        state_ = Data;
+        return Processing;
+    }
+    state_ = Start;
+    return Ok;
+}
 
-    static std::unordered_map<std::string,
-                              decltype(currentImportantHeader)>  importantHeaders{{"host", Host},
-                                                                                  {"content-length", ContentLength},
-                                                                                  {"content-type", ContentType},
-                                                                                  {"connection", Connection},
-                                                                                  {"keep-alive", KeepAlive},
-                                                                                  {"max", Max}};
-    static std::string currentHeader;
+RequestParser::ResultType RequestParser::consumeHeaders(Request &request, char chr)
+{
+    // compared in place, without a lowercase copy of every header name
+    static const std::pair<const char*, decltype(currentImportantHeader_)> importantHeaders[] = {
+        {"host", Host},
+        {"content-length", ContentLength},
+        {"content-type", ContentType},
+        {"connection", ConnectionHeader},
+        {"keep-alive", KeepAlive},
+        {"max", Max}
+    };
     switch(headerState_) {
     case HeaderStart:
         if (isNewLine(chr)) {
@@ -220,12 +230,13 @@ RequestParser::ResultType RequestParser::consumeHeaders(Request &request, char c
     case Key:
         if(isCollon(chr))
         {
-            auto lowerData = std::move(boost::algorithm::to_lower_copy(currentBuffer_));
-            const auto& header = importantHeaders.find(lowerData);
-            if (header != importantHeaders.end()) {
-                currentImportantHeader = header->second;
+            for (const auto& header: importantHeaders) {
+                if (boost::iequals(currentBuffer_, header.first)) {
+                    currentImportantHeader_ = header.second;
+                    break;
+                }
             }
-            currentHeader = std::move(currentBuffer_);
+            currentHeader_.swap(currentBuffer_);
             currentBuffer_.clear();
             headerState_ = Space;
         }
@@ -253,25 +264,29 @@ RequestParser::ResultType RequestParser::consumeHeaders(Request &request, char c
     case HeaderNewLine:
         if(!isNewLine(chr))
             return Error;
-        switch (currentImportantHeader) {
+        switch (currentImportantHeader_) {
         case Host:
-            request.host = currentBuffer_;
+            if (!absoluteTarget_)
+                request.host.assign(currentBuffer_.data(), currentBuffer_.size());
             break;
         case ContentType:
             //@TODO: check it if multipart later
-            request.contentType = currentBuffer_;
+            request.contentType.assign(currentBuffer_.data(), currentBuffer_.size());
             break;
         case ContentLength:
             try {
                 request.contentLength = boost::lexical_cast<int>(currentBuffer_);
             }
-            catch(boost::bad_lexical_cast){
+            catch(const boost::bad_lexical_cast&){
                 return Error;
             }
 
             break;
-        case Connection:
-            request.keepAlive = boost::iequals(currentBuffer_, "keep-alive");
+        case ConnectionHeader:
+            if (boost::iequals(currentBuffer_, "keep-alive"))
+                request.keepAlive = true;
+            else if (boost::iequals(currentBuffer_, "close"))
+                request.keepAlive = false;
             break;
         case KeepAlive:
             boost::string_ref timeout(currentBuffer_);
@@ -279,13 +294,13 @@ RequestParser::ResultType RequestParser::consumeHeaders(Request &request, char c
             try {
             request.connectionTimeout = boost::lexical_cast<int>(timeout);
         }
-            catch (boost::bad_lexical_cast) {}
+            catch (const boost::bad_lexical_cast&) {}
             break;
         }
-        currentImportantHeader = None;
+        currentImportantHeader_ = None;
 
-        request.headers.push_back({std::move(currentHeader),
-                                   std::move(currentBuffer_)});
+        appendHeader(request.headers, currentHeader_, currentBuffer_);
+        currentBuffer_.clear();
         headerState_ = HeaderStart;
     }
     return Processing;
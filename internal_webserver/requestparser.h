@@ -30,13 +30,19 @@
 #include <tuple>
 #include <ostream>
 #include <sstream>
+#include "probes.h"
 #include "request.h"
+#include "wizrd_config.h"
 
 #include <unordered_map>
 #include <unordered_set>
 #include <map>
 #include <tuple>
 
+// largest request body, set with -DWIZRD_MAX_BODY_SIZE=<bytes>
+#ifndef WIZRD_MAX_BODY_SIZE
+#define WIZRD_MAX_BODY_SIZE 8388608
+#endif
 
 namespace Wizrd { namespace Server {
 
@@ -45,7 +51,10 @@ class RequestParser
 public:
     RequestParser();
     void reset();
-    enum ResultType {Ok, Error, Processing};
+    /// connection the probes and the requests parsed report
+    inline void setConnection(uint64_t connection) noexcept { connection_ = connection; }
+    /// TooLarge: the Content-Length is over WIZRD_MAX_BODY_SIZE (413)
+    enum ResultType {Ok, Error, Processing, TooLarge};
 
     // this parser works this way because read some has no guarantee to
     // get all available data on request, so, that way the request is parsed partially
@@ -57,21 +66,9 @@ public:
         while ((begin != end) && (result == Processing)) {
             result = consume(request, *begin++);
         }
-        if (result == Processing) {
-            result = Ok;
-            switch (state_) {
-            case Data:
-                request.data = std::move(currentBuffer_);
-                break;
-            case NewLine2:
-                if (currentBuffer_ != "\r\n\r\n")
-                    result = Processing;
-
-                break;
-            default:
-                result = Processing;
-            }
-        }
+        if (result != Processing)
+            WIZRD_PROBE(parse__done, connection_, static_cast<int>(request.method),
+                        request.data.size(), result == Ok);
         return std::make_tuple(begin, result);
     }
     void reset(Request &request);
@@ -79,6 +76,7 @@ public:
 private:
     ResultType consume(Request& request, char chr);
     ResultType consumeHeaders(Request& request, char chr);
+    ResultType headersComplete(Request& request);
     inline bool isLowerAlpha(const char chr) noexcept
     {
         return (chr >= 'a' && chr <= 'z');
@@ -136,9 +134,21 @@ private:
         Value,
         HeaderNewLine
     } headerState_;
+    enum {
+        ContentType,
+        ContentLength,
+        ConnectionHeader,
+        KeepAlive,
+        Max,
+        Host,
+        None
+    } currentImportantHeader_;
     int consumedContent_;
+    bool absoluteTarget_ = false;
+    uint64_t connection_ = 0;
 
-
+    // scratch buffers, copied into the request (its arena) so that they
+    // keep their capacity from one request to the next
     std::string currentBuffer_;
     std::string currentHeader_;
 };
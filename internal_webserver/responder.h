@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <vector>
+#include <boost/asio/any_io_executor.hpp>
+
+namespace Wizrd { namespace Server {
+
+/// the side of a connection that sends a response. A handler that completes
+/// the response after returning (a coroutine) calls defer() before it
+/// returns and complete() from executor() once the response is ready, the
+/// connection keeps the exchange alive and doesn't read the next request
+/// in between. Deferrals nest (an offloaded coroutine defers twice), the
+/// response is sent by the last complete()
+class Responder
+{
+public:
+    virtual ~Responder() = default;
+    /// the executor of the connection, handlers resume on it
+    virtual boost::asio::any_io_executor executor() = 0;
+
+    inline void defer() noexcept { deferred_.fetch_add(1, std::memory_order_relaxed); }
+    inline bool deferred() const noexcept { return deferred_.load(std::memory_order_relaxed) > held_; }
+    /// runs hook when the deferred response completes, before it is sent
+    inline void onComplete(std::function<void()> hook) { hooks_.push_back(std::move(hook)); }
+
+    /// the connection holds the exchange while the handler runs, a
+    /// complete() from another thread can't send before the handler returned
+    inline void hold() noexcept
+    {
+        deferred_.fetch_add(1, std::memory_order_relaxed);
+        held_ = true;
+    }
+    /// ends the hold, sends the response unless the handler deferred it
+    inline void release()
+    {
+        held_ = false;
+        complete();
+    }
+
+    void complete()
+    {
+        if (deferred_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        for (auto& hook: hooks_)
+            hook();
+        hooks_.clear();
+        send();
+    }
+
+protected:
+    /// sends the response of a deferred exchange
+    virtual void send() = 0;
+
+private:
+    std::atomic<unsigned> deferred_{0};
+    // only touched by the thread running the handler
+    bool held_ = false;
+    std::vector<std::function<void()>> hooks_;
+};
+
+}}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "response.h"
+#include "utils/url.h"
+
+namespace Wizrd {
+namespace Server {
+
+const char* Response::reason(int status) noexcept
+{
+    switch (status) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 206: return "Partial Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 303: return "See Other";
+    case 304: return "Not Modified";
+    case 307: return "Temporary Redirect";
+    case 308: return "Permanent Redirect";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 415: return "Unsupported Media Type";
+    case 429: return "Too Many Requests";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 502: return "Bad Gateway";
+    case 503: return "Service Unavailable";
+    case 504: return "Gateway Timeout";
+    default: return "Unknown";
+    }
+}
+
+void Response::redirect(boost::string_ref location, int status)
+{
+    this->status = status;
+    Header& header = headers.emplace_back();
+    header.reserve(2);
+    header.emplace_back("Location");
+    URL::appendQuoted(header.emplace_back(), location, URLSafeChars::uri());
+}
+
+void Response::toHttp(std::string& output, const Request& request) const
+{
+    output.reserve(output.size() + 256 + body.size());
+    toHttpHead(output, request);
+    if (hasBody(request))
+        output += body;
+}
+
+void Response::toHttpHead(std::string& output, const Request& request) const
+{
+    const std::string length = stream ? std::string() : std::to_string(body.size());
+    size_t size = 64 + length.size();
+    for (const Header& header: headers) {
+        for (const String& item: header)
+            size += item.size() + 4;
+    }
+    output.reserve(output.size() + size);
+
+    output += request.versionMinor == 0 ? "HTTP/1.0 " : "HTTP/1.1 ";
+    output += std::to_string(status);
+    output += ' ';
+    output += reason(status);
+    output += "\r\n";
+    for (const Header& header: headers) {
+        output += header[0];
+        output += ": ";
+        if (header.size() > 1)
+            output += header[1];
+        output += "\r\n";
+    }
+    // a stream is chunked or, for HTTP/1.0, ends with the connection
+    if (!stream) {
+        output += "Content-Length: ";
+        output += length;
+        output += "\r\n";
+    }
+    else if (request.versionMinor != 0) {
+        output += "Transfer-Encoding: chunked\r\n";
+    }
+    // HTTP/1.1 connections are persistent unless told otherwise, HTTP/1.0
+    // ones are closed unless told otherwise
+    const bool keepAlive = request.keepAlive && !(stream && request.versionMinor == 0);
+    if (request.versionMinor == 0 && keepAlive)
+        output += "Connection: keep-alive\r\n";
+    else if (request.versionMinor != 0 && !keepAlive)
+        output += "Connection: close\r\n";
+    output += "\r\n";
+}
+
+bool Response::nextChunk(std::string& output, bool chunked) const
+{
+    if (!chunked)
+        return stream(output);
+
+    // the size is written over a fixed width placeholder once the chunk is
+    // in place, chunk sizes may have leading zeros
+    static const char digits[] = "0123456789abcdef";
+    const size_t start = output.size();
+    output.append("00000000\r\n");
+    const bool more = stream(output);
+    size_t size = output.size() - start - 10;
+    if (size == 0) {
+        output.resize(start);
+    }
+    else {
+        for (size_t i = 8; i-- > 0; size >>= 4)
+            output[start + i] = digits[size & 0xF];
+        output += "\r\n";
+    }
+    if (!more)
+        output += "0\r\n\r\n";
+    return more;
+}
+
+void Response::toCgiHeaders(std::string& output) const
+{
+    output += "Status: ";
+    output += std::to_string(status);
+    output += ' ';
+    output += reason(status);
+    output += "\r\n";
+    for (const Header& header: headers) {
+        output += header[0];
+        output += ": ";
+        if (header.size() > 1)
+            output += header[1];
+        output += "\r\n";
+    }
+    if (!stream) {
+        output += "Content-Length: ";
+        output += std::to_string(body.size());
+        output += "\r\n";
+    }
+    output += "\r\n";
+}
+
+} // Server namespace
+} // Wizrd namespace
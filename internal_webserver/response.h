@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "request.h"
+
+namespace Wizrd {
+namespace Server {
+
+class Responder;
+struct CachedResponse;
+
+struct Response {
+    int status = 200;
+    Headers headers;
+    std::string body;
+    /// set by the connections, lets handlers complete the response later
+    Responder* responder = nullptr;
+    /// set on a cache hit, the response to send instead of this one
+    std::shared_ptr<const CachedResponse> cached;
+    /// produces the body chunk by chunk instead of body: appends the next
+    /// chunk to the output buffer of the connection and returns false after
+    /// the last one. Sent chunked to HTTP/1.1 clients and until the
+    /// connection closes to HTTP/1.0 ones
+    std::function<bool(std::string&)> stream;
+
+    inline void addHeader(boost::string_ref key, boost::string_ref value)
+    {
+        appendHeader(headers, key, value);
+    }
+
+    /// answers with a redirection to location, in which the chars that
+    /// may not appear in a URI (spaces, controls, non-ASCII) are escaped
+    void redirect(boost::string_ref location, int status = 302);
+
+    inline void reset()
+    {
+        status = 200;
+        headers.clear();
+        body.clear();
+        cached.reset();
+        stream = nullptr;
+    }
+
+    /// the response to send, this one or the cached one
+    inline const Response& resolved() const noexcept;
+
+    static const char* reason(int status) noexcept;
+
+    // serializes the status line, headers and body as an HTTP/1.x response
+    // into output, framing it with Content-Length and the connection
+    // persistence negotiated by request
+    void toHttp(std::string& output, const Request& request) const;
+    // the same without the body, for a connection that writes the body
+    // from where it is (see hasBody)
+    void toHttpHead(std::string& output, const Request& request) const;
+    // whether the response to request carries body after its head
+    inline bool hasBody(const Request& request) const noexcept
+    {
+        return request.method != Method::HEAD && !stream;
+    }
+    // appends the next chunk of stream to output, framed as an HTTP/1.1
+    // chunk (and followed by the last chunk) when chunked, returns false
+    // once the stream is over
+    bool nextChunk(std::string& output, bool chunked) const;
+    // serializes the header block of a CGI document (a Status header
+    // instead of the status line), the body is framed by the gateway
+    void toCgiHeaders(std::string& output) const;
+};
+
+/// response kept by a ResponseCache, with its bytes as sent to an
+/// HTTP/1.1 keep-alive GET so that a hit is a single write
+struct CachedResponse {
+    Response response;
+    std::string http;
+
+    inline bool sendsAsIs(const Request& request) const noexcept
+    {
+        return request.method == Method::GET && request.versionMinor != 0 && request.keepAlive;
+    }
+};
+
+inline const Response& Response::resolved() const noexcept
+{
+    return cached ? cached->response : *this;
+}
+
+} // Server namespace
+} // Wizrd namespace
@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "responsecache.h"
+#include <algorithm>
+#include <functional>
+#include <mutex>
+
+using namespace Wizrd::Server;
+
+namespace {
+
+// in the order of Method
+const char* const methodNames[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "TRACE",
+                                   "OPTIONS", "CONNECT", "PATCH", "CUSTOM"};
+
+}
+
+ResponseCache::ResponseCache(size_t capacity, size_t shards)
+    : shardCapacity_(capacity / std::max<size_t>(shards, 1)),
+      shards_(new Shard[std::max<size_t>(shards, 1)]),
+      shardCount_(std::max<size_t>(shards, 1))
+{
+}
+
+void ResponseCache::key(std::string& key, const Request& request, const std::vector<std::string>& vary)
+{
+    // HEAD is answered from the GET entry
+    const Method method = request.method == Method::HEAD ? Method::GET : request.method;
+    key += methodNames[static_cast<size_t>(method)];
+    key += ' ';
+    for (char c: request.host)
+        key += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+
+    boost::string_ref url(request.url);
+    url = url.substr(0, url.find('#'));
+    const size_t question = url.find('?');
+    key.append(url.data(), std::min(question, url.size()));
+    if (question != boost::string_ref::npos) {
+        // the same parameters in another order are the same resource, but
+        // the values of a repeated parameter keep their order
+        std::vector<boost::string_ref> parameters;
+        boost::string_ref query = url.substr(question + 1);
+        while (!query.empty()) {
+            const size_t amp = query.find('&');
+            if (amp)
+                parameters.push_back(query.substr(0, amp));
+            query = amp == boost::string_ref::npos ? boost::string_ref() : query.substr(amp + 1);
+        }
+        std::stable_sort(parameters.begin(), parameters.end(), [](boost::string_ref a, boost::string_ref b) {
+            return a.substr(0, a.find('=')) < b.substr(0, b.find('='));
+        });
+        char separator = '?';
+        for (boost::string_ref parameter: parameters) {
+            key += separator;
+            key.append(parameter.data(), parameter.size());
+            separator = '&';
+        }
+    }
+
+    for (const std::string& name: vary) {
+        key += '\n';
+        const boost::string_ref value = headerValue(request.headers, name);
+        key.append(value.data(), value.size());
+    }
+}
+
+ResponseCache::Shard& ResponseCache::shardFor(const std::string& key) const
+{
+    return shards_[std::hash<std::string>()(key) % shardCount_];
+}
+
+std::shared_ptr<const CachedResponse> ResponseCache::find(const std::string& key) const
+{
+    Shard& shard = shardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    const auto found = shard.index.find(key);
+    if (found == shard.index.end())
+        return nullptr;
+    const Entry& entry = *shard.entries[found->second];
+    if (entry.expires <= Clock::now())
+        return nullptr;
+    entry.referenced.store(true, std::memory_order_relaxed);
+    return entry.response;
+}
+
+void ResponseCache::insert(const std::string& key, std::shared_ptr<const CachedResponse> response,
+                           Clock::duration ttl)
+{
+    const size_t bytes = key.size() + response->http.size() + response->response.body.size();
+    if (bytes > shardCapacity_)
+        return;
+
+    Shard& shard = shardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    const auto found = shard.index.find(key);
+    if (found != shard.index.end())
+        evict(shard, found->second);
+    makeRoom(shard, bytes);
+
+    size_t slot;
+    if (!shard.free.empty()) {
+        slot = shard.free.back();
+        shard.free.pop_back();
+    }
+    else {
+        slot = shard.entries.size();
+        shard.entries.emplace_back(new Entry);
+    }
+    Entry& entry = *shard.entries[slot];
+    entry.key = key;
+    entry.response = std::move(response);
+    entry.expires = Clock::now() + ttl;
+    entry.bytes = bytes;
+    entry.referenced.store(false, std::memory_order_relaxed);
+    shard.index.emplace(entry.key, slot);
+    shard.bytes += bytes;
+}
+
+void ResponseCache::evict(Shard& shard, size_t slot)
+{
+    Entry& entry = *shard.entries[slot];
+    shard.index.erase(entry.key);
+    shard.bytes -= entry.bytes;
+    entry.response.reset();
+    entry.key.clear();
+    entry.bytes = 0;
+    shard.free.push_back(slot);
+}
+
+void ResponseCache::makeRoom(Shard& shard, size_t bytes)
+{
+    const auto now = Clock::now();
+    // each referenced entry gets a second chance, two turns of the hand
+    // are enough to find a victim
+    while (shard.bytes + bytes > shardCapacity_ && !shard.index.empty()) {
+        shard.hand = (shard.hand + 1) % shard.entries.size();
+        Entry& entry = *shard.entries[shard.hand];
+        if (!entry.response)
+            continue;
+        if (entry.expires > now && entry.referenced.exchange(false, std::memory_order_relaxed))
+            continue;
+        evict(shard, shard.hand);
+    }
+}
+
+size_t ResponseCache::purge(boost::string_ref path)
+{
+    size_t purged = 0;
+    for (size_t i = 0; i < shardCount_; i++) {
+        Shard& shard = shards_[i];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        for (size_t slot = 0; slot < shard.entries.size(); slot++) {
+            const Entry& entry = *shard.entries[slot];
+            if (!entry.response)
+                continue;
+            // "METHOD host/path[?query][\nvary...]"
+            boost::string_ref key(entry.key);
+            key = key.substr(key.find(' ') + 1);
+            key = key.substr(std::min(key.find('/'), key.size()));
+            key = key.substr(0, std::min(key.find('?'), key.find('\n')));
+            if (key == path) {
+                evict(shard, slot);
+                purged++;
+            }
+        }
+    }
+    return purged;
+}
+
+void ResponseCache::clear()
+{
+    for (size_t i = 0; i < shardCount_; i++) {
+        Shard& shard = shards_[i];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.entries.clear();
+        shard.free.clear();
+        shard.hand = 0;
+        shard.bytes = 0;
+    }
+}
+
+size_t ResponseCache::size() const
+{
+    size_t size = 0;
+    for (size_t i = 0; i < shardCount_; i++) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        size += shards_[i].index.size();
+    }
+    return size;
+}
+
+size_t ResponseCache::bytes() const
+{
+    size_t bytes = 0;
+    for (size_t i = 0; i < shardCount_; i++) {
+        std::shared_lock<std::shared_mutex> lock(shards_[i].mutex);
+        bytes += shards_[i].bytes;
+    }
+    return bytes;
+}
+
+ResponseCache& Wizrd::Server::defaultResponseCache()
+{
+    static ResponseCache cache;
+    return cache;
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+#include "staticroute.h"
+
+namespace Wizrd { namespace Server {
+
+/// cache of complete responses, keyed by method, host, path, query string
+/// (its parameters sorted) and the values of the request headers the
+/// response varies on. Split in shards, each behind a reader/writer lock:
+/// a hit takes the shared lock and only marks the entry as referenced.
+/// Each shard holds capacity / shards bytes and evicts with CLOCK, expired
+/// entries are misses
+class ResponseCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ResponseCache(size_t capacity = 64 * 1024 * 1024, size_t shards = 16);
+    ResponseCache(const ResponseCache&) = delete;
+    ResponseCache& operator=(const ResponseCache&) = delete;
+
+    /// appends the key of request to key, vary are the header names
+    static void key(std::string& key, const Request& request, const std::vector<std::string>& vary);
+
+    std::shared_ptr<const CachedResponse> find(const std::string& key) const;
+    /// entries larger than a shard aren't kept
+    void insert(const std::string& key, std::shared_ptr<const CachedResponse> response,
+                Clock::duration ttl);
+
+    /// removes the entries for path, whatever their host, query or headers
+    size_t purge(boost::string_ref path);
+    void clear();
+
+    size_t size() const;
+    size_t bytes() const;
+
+private:
+    struct Entry {
+        std::string key;
+        std::shared_ptr<const CachedResponse> response;
+        Clock::time_point expires;
+        size_t bytes = 0;
+        mutable std::atomic<bool> referenced{false};
+    };
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        // views into the keys of the entries
+        std::unordered_map<std::string_view, size_t> index;
+        // the clock, free entries have no response
+        std::vector<std::unique_ptr<Entry>> entries;
+        std::vector<size_t> free;
+        size_t hand = 0;
+        size_t bytes = 0;
+    };
+
+    Shard& shardFor(const std::string& key) const;
+    void evict(Shard& shard, size_t slot);
+    void makeRoom(Shard& shard, size_t bytes);
+
+    const size_t shardCapacity_;
+    std::unique_ptr<Shard[]> shards_;
+    const size_t shardCount_;
+};
+
+/// the cache used by Route(...) { request.cache(...); }
+ResponseCache& defaultResponseCache();
+
+/// handler behind a ResponseCache: a hit answers without running it, the
+/// 200 responses it gives are kept for ttl unless they set a cookie. It is
+/// the innermost layer of the route after the middleware, so a hit still
+/// runs the before hooks (a request rejected by them isn't answered from
+/// the cache), while what the after hooks add to the response isn't stored
+template <class Function>
+class Cached
+{
+public:
+    inline Cached(ResponseCache& cache, ResponseCache::Clock::duration ttl,
+                  std::vector<std::string> vary, Function function)
+        : cache_(&cache), ttl_(ttl), vary_(std::move(vary)), function_(std::move(function))
+    {
+    }
+
+    template <class... Captures>
+    void operator()(Request& request, Response& response, Captures&... captures)
+    {
+        thread_local std::string key;
+        key.clear();
+        ResponseCache::key(key, request, vary_);
+        if (auto hit = cache_->find(key)) {
+            response.cached = std::move(hit);
+            return;
+        }
+
+        auto arguments = std::tie(captures...);
+        Detail::invoke(function_, request, response, arguments);
+        // a HEAD handler has no body to share with the GET entry
+        if (request.method == Method::HEAD)
+            return;
+        if (response.responder && response.responder->deferred()) {
+            response.responder->onComplete([this, key = key, &response]() { store(key, response); });
+        }
+        else {
+            store(key, response);
+        }
+    }
+
+private:
+    void store(const std::string& key, const Response& response)
+    {
+        if (response.status != 200 || response.cached || response.stream)
+            return;
+        for (const Header& header: response.headers) {
+            if (header.size() > 1 && header[0] == "Set-Cookie")
+                return;
+        }
+        auto entry = std::make_shared<CachedResponse>();
+        entry->response.status = response.status;
+        entry->response.headers = response.headers;
+        entry->response.body = response.body;
+        Request get;
+        get.method = Method::GET;
+        get.versionMajor = 1;
+        get.versionMinor = 1;
+        get.keepAlive = true;
+        entry->response.toHttp(entry->http, get);
+        cache_->insert(key, std::move(entry), ttl_);
+    }
+
+    ResponseCache* cache_;
+    ResponseCache::Clock::duration ttl_;
+    std::vector<std::string> vary_;
+    Function function_;
+};
+
+}}
@@ -0,0 +1,496 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "router.h"
+#include <algorithm>
+#include <boost/algorithm/string/predicate.hpp>
+#include "metrics.h"
+#include "probes.h"
+
+namespace Wizrd { namespace Server {
+
+struct Router::Node {
+    enum Kind {
+        Static,
+        Capture,
+        CatchAll
+    } kind = Static;
+    enum Converter {
+        String,
+        Int,
+        Float
+    } converter = String;
+    // static text matched by the node, or the capture name
+    std::string prefix;
+    // first character of every static child, in the same order
+    std::string indices;
+    std::vector<std::unique_ptr<Node>> children;
+    std::unique_ptr<Node> capture;
+    std::unique_ptr<Node> catchAll;
+    bool hasHandler = false;
+    RequestHandler handler;
+    // see Metrics::routeId
+    uint32_t route = 0;
+
+    // whether a captured segment is valid for the converter of the capture
+    inline bool converts(boost::string_ref value) const noexcept
+    {
+        switch (converter) {
+        case Int: {
+            int output;
+            return Detail::convert(value, output);
+        }
+        case Float: {
+            double output;
+            return Detail::convert(value, output);
+        }
+        default:
+            return true;
+        }
+    }
+};
+
+namespace {
+
+// strips the query string and fragment from the request target
+inline boost::string_ref routePath(boost::string_ref url) noexcept
+{
+    const size_t end = url.find_first_of("?#");
+    return end == boost::string_ref::npos ? url : url.substr(0, end);
+}
+
+// strips the port from the Host header
+inline boost::string_ref hostName(boost::string_ref host) noexcept
+{
+    // [v6 address]:port
+    const size_t bracket = host.rfind(']');
+    const size_t colon = host.rfind(':');
+    if (colon != boost::string_ref::npos && (bracket == boost::string_ref::npos || colon > bracket))
+        return host.substr(0, colon);
+    return host;
+}
+
+// the pattern without the capture names, two routes with the same shape
+// match the same paths
+std::string routeShape(boost::string_ref pattern)
+{
+    std::string shape;
+    while (!pattern.empty()) {
+        const size_t open = pattern.find('<');
+        shape.append(pattern.data(), std::min(open, pattern.size()));
+        if (open == boost::string_ref::npos)
+            break;
+        pattern.remove_prefix(open + 1);
+        const size_t close = std::min(pattern.find('>'), pattern.size());
+        const boost::string_ref capture = pattern.substr(0, close);
+        const size_t colon = capture.find(':');
+        const boost::string_ref converter = colon == boost::string_ref::npos ? "string" : capture.substr(0, colon);
+        shape += '<';
+        shape.append(converter.data(), converter.size());
+        shape += '>';
+        pattern.remove_prefix(std::min(close + 1, pattern.size()));
+    }
+    return shape;
+}
+
+}
+
+Router::Router()
+{
+    trees_.emplace_back();
+}
+
+Router::~Router()
+{
+}
+
+void Router::add(Method method, boost::string_ref pattern, RequestHandler handler,
+                 boost::string_ref host)
+{
+    if (pattern.empty() || pattern[0] != '/')
+        throw RouteException("Route patterns must start with '/'");
+
+    Routes& routes = treeFor(host)[static_cast<size_t>(method)];
+    if (!routes.root)
+        routes.root.reset(new Node);
+    insert(*routes.root, pattern, handler, 0, Metrics::routeId(pattern));
+    routes.rootPrefix = std::max(routes.rootPrefix, pattern.find('<'));
+}
+
+void Router::add(Method method, size_t literalLength, std::unique_ptr<StaticRoute> route,
+                 boost::string_ref host)
+{
+    const boost::string_ref pattern = route->pattern();
+    route->metricsId = Metrics::routeId(pattern);
+    Routes& routes = treeFor(host)[static_cast<size_t>(method)];
+    const std::string shape = routeShape(pattern);
+    auto registered = [&shape](const StaticRoute& other) {
+        return !shape.empty() && routeShape(other.pattern()) == shape;
+    };
+
+    if (literalLength != boost::string_ref::npos) {
+        if (routes.literals.size() <= literalLength)
+            routes.literals.resize(literalLength + 1);
+        for (const auto& other: routes.literals[literalLength]) {
+            if (registered(*other))
+                throw RouteException("Route already registered");
+        }
+        routes.literals[literalLength].push_back(std::move(route));
+        return;
+    }
+
+    // captures stop at '/', so the other routes only match paths with as
+    // many segments as their pattern
+    std::vector<CaptureRoute>* bucket = &routes.tails;
+    if (pattern.find("<path:") == boost::string_ref::npos) {
+        const size_t segments = std::count(pattern.begin(), pattern.end(), '/');
+        if (routes.captures.size() <= segments)
+            routes.captures.resize(segments + 1);
+        bucket = &routes.captures[segments];
+    }
+    for (const CaptureRoute& other: *bucket) {
+        if (registered(*other.route))
+            throw RouteException("Route already registered");
+    }
+    const size_t prefix = pattern.find('<');
+    // after the routes with the same prefix, the first one registered wins
+    auto position = std::upper_bound(bucket->begin(), bucket->end(), prefix,
+                                     [](size_t prefix, const CaptureRoute& other) {
+        return prefix > other.prefix;
+    });
+    bucket->insert(position, CaptureRoute{prefix, std::move(route)});
+}
+
+Router::Tree& Router::treeFor(boost::string_ref host)
+{
+    auto found = std::find_if(trees_.begin(), trees_.end(), [&host](const std::pair<std::string, Tree>& tree) {
+        return boost::iequals(tree.first, host);
+    });
+    if (found == trees_.end()) {
+        trees_.emplace_back(host.to_string(), Tree());
+        found = trees_.end() - 1;
+    }
+    return found->second;
+}
+
+void Router::insert(Node& node, boost::string_ref pattern, RequestHandler& handler,
+                    size_t captures, uint32_t route)
+{
+    if (pattern.empty()) {
+        if (node.hasHandler)
+            throw RouteException("Route already registered");
+        node.hasHandler = true;
+        node.handler = std::move(handler);
+        node.route = route;
+        return;
+    }
+
+    if (pattern[0] == '<') {
+        const size_t close = pattern.find('>');
+        if (close == boost::string_ref::npos)
+            throw RouteException("Unterminated capture in route pattern");
+        if (++captures > PathParameters::Max)
+            throw RouteException("Too many captures in route pattern");
+        boost::string_ref name = pattern.substr(1, close - 1);
+        const size_t colon = name.find(':');
+        boost::string_ref converter;
+        if (colon != boost::string_ref::npos) {
+            converter = name.substr(0, colon);
+            name.remove_prefix(colon + 1);
+        }
+        pattern.remove_prefix(close + 1);
+
+        const bool catchAll = converter == "path";
+        if (catchAll && !pattern.empty())
+            throw RouteException("<path:...> captures must end the route pattern");
+        Node::Converter type = Node::String;
+        if (converter == "int")
+            type = Node::Int;
+        else if (converter == "float")
+            type = Node::Float;
+        else if (!converter.empty() && converter != "string" && !catchAll)
+            throw RouteException("Unknown converter in route pattern");
+
+        auto& child = catchAll ? node.catchAll : node.capture;
+        if (!child) {
+            child.reset(new Node);
+            child->kind = catchAll ? Node::CatchAll : Node::Capture;
+            child->converter = type;
+            child->prefix = name.to_string();
+        }
+        else if (child->prefix != name || child->converter != type) {
+            throw RouteException("Conflicting captures in route patterns");
+        }
+        insert(*child, pattern, handler, captures, route);
+        return;
+    }
+
+    const boost::string_ref text = pattern.substr(0, pattern.find('<'));
+    const size_t index = node.indices.find(text[0]);
+    if (index == std::string::npos) {
+        node.indices += text[0];
+        node.children.emplace_back(new Node);
+        node.children.back()->prefix = text.to_string();
+        insert(*node.children.back(), pattern.substr(text.size()), handler, captures, route);
+        return;
+    }
+
+    std::unique_ptr<Node>& child = node.children[index];
+    const auto mismatch = std::mismatch(child->prefix.begin(), child->prefix.end(),
+                                        text.begin(), text.end());
+    const size_t common = mismatch.first - child->prefix.begin();
+    if (common < child->prefix.size()) {
+        // split the child at the point where the prefixes differ
+        std::unique_ptr<Node> split(new Node);
+        split->prefix = child->prefix.substr(0, common);
+        child->prefix.erase(0, common);
+        split->indices += child->prefix[0];
+        split->children.push_back(std::move(child));
+        child = std::move(split);
+    }
+    insert(*child, pattern.substr(common), handler, captures, route);
+}
+
+const RequestHandler* Router::match(Method method, boost::string_ref host, boost::string_ref path,
+                                    PathParameters& parameters) const
+{
+    const Node* node = matchNode(method, host, path, parameters);
+    return node ? &node->handler : nullptr;
+}
+
+const Router::Node* Router::matchNode(Method method, boost::string_ref host, boost::string_ref path,
+                                      PathParameters& parameters) const
+{
+    path = routePath(path);
+    parameters.clear();
+    const Tree* trees[] = {trees_.size() > 1 ? tree(hostName(host)) : nullptr, &trees_[0].second};
+    for (const Tree* tree: trees) {
+        if (!tree)
+            continue;
+        if (!(*tree)[static_cast<size_t>(method)].root)
+            continue;
+        const Node* node = match(*(*tree)[static_cast<size_t>(method)].root, path, parameters);
+        if (node)
+            return node;
+    }
+    return nullptr;
+}
+
+const Router::Node* Router::match(const Node& node, boost::string_ref path,
+                                  PathParameters& parameters)
+{
+    if (path.empty())
+        return node.hasHandler ? &node : nullptr;
+
+    const size_t index = node.indices.find(path[0]);
+    if (index != std::string::npos) {
+        const Node& child = *node.children[index];
+        if (path.starts_with(child.prefix)) {
+            const Node* found = match(child, path.substr(child.prefix.size()), parameters);
+            if (found)
+                return found;
+        }
+    }
+
+    if (node.capture) {
+        const size_t end = std::min(path.find('/'), path.size());
+        if (end && node.capture->converts(path.substr(0, end))) {
+            parameters.push(node.capture->prefix, path.substr(0, end));
+            const Node* found = match(*node.capture, path.substr(end), parameters);
+            if (found)
+                return found;
+            parameters.pop();
+        }
+    }
+
+    if (node.catchAll && node.catchAll->hasHandler) {
+        parameters.push(node.catchAll->prefix, path);
+        return node.catchAll.get();
+    }
+    return nullptr;
+}
+
+const Router::Tree* Router::tree(boost::string_ref host) const
+{
+    for (size_t i = 1; i < trees_.size(); i++) {
+        if (boost::iequals(trees_[i].first, host))
+            return &trees_[i].second;
+    }
+    return nullptr;
+}
+
+const StaticRoute* Router::matchStatic(Method method, boost::string_ref host, boost::string_ref path,
+                                       size_t& prefix, StaticCaptures& captures,
+                                       PathParameters& parameters) const
+{
+    path = routePath(path);
+    const Tree* trees[] = {trees_.size() > 1 ? tree(hostName(host)) : nullptr, &trees_[0].second};
+    for (const Tree* tree: trees) {
+        if (!tree)
+            continue;
+        const StaticRoute* route = matchStatic((*tree)[static_cast<size_t>(method)], path, prefix,
+                                               captures, parameters);
+        if (route)
+            return route;
+    }
+    parameters.clear();
+    return nullptr;
+}
+
+const StaticRoute* Router::matchStatic(const Routes& routes, boost::string_ref path, size_t& prefix,
+                                       StaticCaptures& captures, PathParameters& parameters)
+{
+    if (path.size() < routes.literals.size()) {
+        for (const auto& route: routes.literals[path.size()]) {
+            if (route->match(path, captures, parameters)) {
+                prefix = path.size();
+                return route.get();
+            }
+        }
+    }
+
+    const StaticRoute* found = nullptr;
+    if (!routes.captures.empty()) {
+        // counted up to the routes there are
+        size_t segments = 0;
+        for (size_t i = 0; i < path.size() && segments < routes.captures.size(); i++)
+            segments += path[i] == '/';
+        if (segments < routes.captures.size()) {
+            for (const CaptureRoute& route: routes.captures[segments]) {
+                parameters.clear();
+                if (route.route->match(path, captures, parameters)) {
+                    found = route.route.get();
+                    prefix = route.prefix;
+                    break;
+                }
+            }
+        }
+    }
+    // like the catch all of the tree, a <path:...> capture only wins with
+    // more static text before it. It converts into captures of its own,
+    // the ones of found are converted again if it loses
+    for (const CaptureRoute& route: routes.tails) {
+        if (found && route.prefix <= prefix)
+            break;
+        PathParameters tailParameters;
+        StaticCaptures tailCaptures;
+        if (route.route->match(path, tailCaptures, tailParameters)) {
+            prefix = route.prefix;
+            captures = tailCaptures;
+            parameters = tailParameters;
+            return route.route.get();
+        }
+    }
+    return found;
+}
+
+size_t Router::rootPrefix(Method method, boost::string_ref host) const
+{
+    const Tree* hosted = trees_.size() > 1 ? tree(hostName(host)) : nullptr;
+    const size_t prefix = trees_[0].second[static_cast<size_t>(method)].rootPrefix;
+    return hosted ? std::max(prefix, (*hosted)[static_cast<size_t>(method)].rootPrefix) : prefix;
+}
+
+void Router::operator()(Request& request, Response& response) const
+{
+    const Metrics::Clock::time_point start = Metrics::now();
+    const boost::string_ref path = routePath(request.url);
+    Method method = request.method;
+    while (true) {
+        size_t prefix = 0;
+        StaticCaptures captures;
+        const StaticRoute* route = matchStatic(method, request.host, path, prefix, captures,
+                                               request.parameters);
+        // the tree is only walked when one of its routes may have more
+        // static text than the compiled one found, which wins ties
+        PathParameters parameters;
+        const Node* node = route && (prefix == path.size() || prefix >= rootPrefix(method, request.host)) ?
+                nullptr : matchNode(method, request.host, path, parameters);
+        if (route && node) {
+            const size_t nodePrefix = parameters.empty() ? path.size() : parameters.value(0).data() - path.data();
+            if (nodePrefix > prefix)
+                route = nullptr;
+            else
+                node = nullptr;
+        }
+
+        if (route) {
+            request.route = route->metricsId;
+            const Metrics::Clock::time_point matched = Metrics::now();
+            Metrics::record(request.route, Metrics::Route, matched - start);
+            WIZRD_PROBE(handler__enter, request.connection, static_cast<int>(method), request.route);
+            route->dispatch(captures, request, response);
+            Metrics::record(request.route, Metrics::Handler, Metrics::now() - matched);
+            WIZRD_PROBE(handler__exit, request.connection, static_cast<int>(method), request.route,
+                        response.status);
+            return;
+        }
+        if (node) {
+            request.parameters = parameters;
+            request.route = node->route;
+            const Metrics::Clock::time_point matched = Metrics::now();
+            Metrics::record(request.route, Metrics::Route, matched - start);
+            WIZRD_PROBE(handler__enter, request.connection, static_cast<int>(method), request.route);
+            node->handler(request, response);
+            Metrics::record(request.route, Metrics::Handler, Metrics::now() - matched);
+            WIZRD_PROBE(handler__exit, request.connection, static_cast<int>(method), request.route,
+                        response.status);
+            return;
+        }
+        // HEAD falls back to the GET routes once its own are exhausted
+        if (method != Method::HEAD)
+            break;
+        method = Method::GET;
+    }
+
+    // the path may still be there for other methods
+    static const char* methodNames[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "TRACE",
+                                        "OPTIONS", "CONNECT", "PATCH"};
+    request.parameters.clear();
+    std::string allowed;
+    PathParameters parameters;
+    StaticCaptures captures;
+    size_t prefix;
+    for (size_t method = 0; method < MethodCount - 1; method++) {
+        if (matchStatic(static_cast<Method>(method), request.host, request.url, prefix, captures, parameters) ||
+            match(static_cast<Method>(method), request.host, request.url, parameters)) {
+            if (!allowed.empty())
+                allowed += ", ";
+            allowed += methodNames[method];
+        }
+    }
+    if (allowed.empty()) {
+        response.status = 404;
+    }
+    else {
+        response.status = 405;
+        response.addHeader("Allow", allowed);
+    }
+    Metrics::record(0, Metrics::Route, Metrics::now() - start);
+}
+
+}}
@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+#include "utils/exceptions.h"
+#include "requesthandler.h"
+
+namespace Wizrd { namespace Server {
+
+class RouteException: BaseException { using BaseException::BaseException; };
+
+namespace Detail {
+
+// <int:...> and <float:...> captures, shared by the tree and the compiled
+// routes so that a pattern matches the same paths either way
+
+inline bool convert(boost::string_ref value, int& output) noexcept
+{
+    // digits only, in the range of int
+    if (value.empty() || value[0] < '0' || value[0] > '9')
+        return false;
+    const auto result = std::from_chars(value.begin(), value.end(), output);
+    return result.ec == std::errc() && result.ptr == value.end();
+}
+
+inline bool convert(boost::string_ref value, double& output) noexcept
+{
+    // digits and one dot, so no sign, exponent, nan or inf
+    bool dot = false;
+    for (char chr: value) {
+        if (chr == '.' && !dot)
+            dot = true;
+        else if (chr < '0' || chr > '9')
+            return false;
+    }
+    if (value.size() == size_t(dot))
+        return false;
+    const auto result = std::from_chars(value.begin(), value.end(), output, std::chars_format::fixed);
+    return result.ec == std::errc() && result.ptr == value.end();
+}
+
+}
+
+/// the converted captures of a compiled route, kept by the router from the
+/// match of the route to its dispatch
+struct StaticCaptures {
+    static constexpr size_t Size = 128;
+    alignas(std::max_align_t) unsigned char storage[Size];
+};
+
+/// route compiled from a pattern known at compile time, see staticroute.h
+class StaticRoute
+{
+public:
+    virtual ~StaticRoute() = default;
+    /// if path matches, converts the captures into captures and pushes them
+    /// to parameters, which may be left partly filled otherwise
+    virtual bool match(boost::string_ref path, StaticCaptures& captures,
+                       PathParameters& parameters) const = 0;
+    /// runs the handler with the captures converted by match
+    virtual void dispatch(StaticCaptures& captures, Request& request, Response& response) const = 0;
+    /// the pattern of the route, names it in the metrics
+    virtual boost::string_ref pattern() const { return boost::string_ref(); }
+
+    /// set by the Router, see Metrics::routeId
+    uint32_t metricsId = 0;
+};
+
+/// compressed radix tree of routes, one per method and virtual host.
+/// patterns are made of static text, <name> captures (one path segment),
+/// <int:name> and <float:name> captures (one numeric segment) and
+/// <path:name> captures (the rest of the path, only at the end).
+/// static text has precedence over captures.
+/// Routes compiled from patterns (StaticRoute) are kept beside the tree, the
+/// capture free ones by method and path length, the others by method and
+/// number of path segments. Of the routes that match, the one with the
+/// longest static text before its first capture wins, compiled or not
+class Router
+{
+public:
+    Router();
+    ~Router();
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
+
+    /// an empty host matches requests for any host, throws RouteException
+    /// on malformed or conflicting patterns
+    void add(Method method, boost::string_ref pattern, RequestHandler handler,
+             boost::string_ref host = boost::string_ref());
+
+    /// literalLength is the length of the path the route matches when its
+    /// pattern has no captures, npos otherwise
+    void add(Method method, size_t literalLength, std::unique_ptr<StaticRoute> route,
+             boost::string_ref host = boost::string_ref());
+
+    /// finds the handler for path (the query string is ignored), in the
+    /// tree of host first and then in the one for any host, parameters are
+    /// views into pattern and path, nothing is allocated
+    const RequestHandler* match(Method method, boost::string_ref host, boost::string_ref path,
+                                PathParameters& parameters) const;
+
+    /// dispatches request to its route, answers 404 or 405 if there is none
+    void operator()(Request& request, Response& response) const;
+
+private:
+    struct Node;
+    static const size_t MethodCount = static_cast<size_t>(Method::CUSTOM) + 1;
+    struct CaptureRoute {
+        // length of the static text before the first capture
+        size_t prefix;
+        std::unique_ptr<StaticRoute> route;
+    };
+    struct Routes {
+        // literal routes, indexed by the length of the path they match
+        std::vector<std::vector<std::unique_ptr<StaticRoute>>> literals;
+        // routes with captures, indexed by the number of '/' in the paths
+        // they match, longest prefix first
+        std::vector<std::vector<CaptureRoute>> captures;
+        // routes ending with a <path:...> capture, longest prefix first
+        std::vector<CaptureRoute> tails;
+        std::unique_ptr<Node> root;
+        // longest static text before the first capture of the routes of
+        // the tree, npos once a route has none
+        size_t rootPrefix = 0;
+    };
+    using Tree = std::array<Routes, MethodCount>;
+
+    static void insert(Node& node, boost::string_ref pattern, RequestHandler& handler,
+                       size_t captures, uint32_t route);
+    static const Node* match(const Node& node, boost::string_ref path,
+                             PathParameters& parameters);
+    const Node* matchNode(Method method, boost::string_ref host, boost::string_ref path,
+                          PathParameters& parameters) const;
+    const Tree* tree(boost::string_ref host) const;
+    Tree& treeFor(boost::string_ref host);
+    /// prefix is set to the length of the static text before the first
+    /// capture of the route found, captures and parameters to its captures
+    const StaticRoute* matchStatic(Method method, boost::string_ref host, boost::string_ref path,
+                                   size_t& prefix, StaticCaptures& captures,
+                                   PathParameters& parameters) const;
+    static const StaticRoute* matchStatic(const Routes& routes, boost::string_ref path,
+                                          size_t& prefix, StaticCaptures& captures,
+                                          PathParameters& parameters);
+    /// the longest static text a route of the trees of host may match with
+    size_t rootPrefix(Method method, boost::string_ref host) const;
+
+    // few virtual hosts are expected, a linear search is cheaper than hashing
+    std::vector<std::pair<std::string, Tree>> trees_;
+};
+
+}}
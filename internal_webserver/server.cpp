@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "server.h"
+#ifdef USE_FCGI
+#include "fastcgiconnection.h"
+#endif
+#include "uwsgiconnection.h"
+
+using namespace Wizrd::Server;
+
+Server::Server(RequestHandler handler)
+    : handler_(std::move(handler))
+{
+}
+
+Server::~Server()
+{
+    for (auto& listener: listeners_)
+        listener->stop();
+    connectionManager_.stopAll();
+}
+
+Listener& Server::listen(const std::string& address, unsigned short port,
+                         const TcpOptions& options, Transport transport)
+{
+    ip::tcp::endpoint endpoint(ip::make_address(address), port);
+    return addListener(std::make_unique<Listener>(ioContext_, endpoint, options,
+        [this, transport](StreamProtocol::socket socket) { accept(std::move(socket), transport); }));
+}
+
+Listener& Server::listenUnix(const std::string& path, const UnixOptions& options,
+                             Transport transport)
+{
+    return addListener(std::make_unique<Listener>(ioContext_, path, options,
+        [this, transport](StreamProtocol::socket socket) { accept(std::move(socket), transport); }));
+}
+
+void Server::run()
+{
+    ioContext_.run();
+}
+
+void Server::stop()
+{
+    boost::asio::post(ioContext_, [this]() {
+        for (auto& listener: listeners_)
+            listener->stop();
+        connectionManager_.stopAll();
+        ioContext_.stop();
+    });
+}
+
+Listener& Server::addListener(std::unique_ptr<Listener> listener)
+{
+    listener->start();
+    listeners_.push_back(std::move(listener));
+    return *listeners_.back();
+}
+
+void Server::accept(StreamProtocol::socket socket, Transport transport)
+{
+    switch (transport) {
+    case Transport::Http:
+        connectionManager_.start(std::make_shared<Connection>(std::move(socket),
+                                                              connectionManager_, handler_));
+        break;
+#ifdef USE_FCGI
+    case Transport::FastCgi:
+        connectionManager_.start(std::make_shared<FastCgiConnection>(std::move(socket),
+                                                                     connectionManager_, handler_));
+        break;
+#endif
+    case Transport::Uwsgi:
+        connectionManager_.start(std::make_shared<UwsgiConnection>(std::move(socket),
+                                                                   connectionManager_, handler_));
+        break;
+    }
+}
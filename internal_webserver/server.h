@@ -1,11 +1,86 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
 #pragma once
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/asio.hpp>
+#include "wizrd_config.h"
+#include "connectionmanager.h"
+#include "listener.h"
+#include "requesthandler.h"
+
 namespace Wizrd { namespace Server {
 
-#include <boost/asio.hpp>
-#include <string>
+/// protocol spoken on a listener, handlers don't see the difference
+enum class Transport {
+    Http,
+#ifdef USE_FCGI
+    FastCgi,
+#endif
+    Uwsgi
+};
+
+class Server
+{
+public:
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    explicit Server(RequestHandler handler);
+    ~Server();
+
+    /// listens on a tcp address, port 0 picks an ephemeral port
+    Listener& listen(const std::string& address, unsigned short port,
+                     const TcpOptions& options = TcpOptions(),
+                     Transport transport = Transport::Http);
+    /// listens on a unix domain socket at path
+    Listener& listenUnix(const std::string& path,
+                         const UnixOptions& options = UnixOptions(),
+                         Transport transport = Transport::Http);
+
+    /// runs the event loop on the calling thread until stop() is called
+    void run();
+    /// stops the listeners and closes every open connection, thread safe
+    void stop();
+
+    inline boost::asio::io_context& ioContext() { return ioContext_; }
+
+private:
+    Listener& addListener(std::unique_ptr<Listener> listener);
+    void accept(StreamProtocol::socket socket, Transport transport);
 
-class Server {
-}
+    boost::asio::io_context ioContext_;
+    RequestHandler handler_;
+    ConnectionManager connectionManager_;
+    std::vector<std::unique_ptr<Listener>> listeners_;
+};
 
 }}
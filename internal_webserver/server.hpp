@@ -1,11 +0,0 @@
-#pragma once
-
-namespace Wizrd { namespace Server {
-
-#include <boost/asio.hpp>
-#include <string>
-
-class Server {
-}
-
-}}
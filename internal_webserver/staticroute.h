@@ -0,0 +1,371 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <new>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "coroutine.h"
+#include "router.h"
+
+namespace Wizrd { namespace Server {
+
+/// string literal usable as a template argument
+template <size_t N>
+struct FixedString {
+    char value[N] = {};
+
+    constexpr FixedString(const char (&string)[N])
+    {
+        for (size_t i = 0; i < N; i++)
+            value[i] = string[i];
+    }
+    constexpr size_t size() const { return N - 1; }
+    constexpr char operator[](size_t index) const { return value[index]; }
+};
+
+namespace Detail {
+
+template <int N> struct Priority : Priority<N - 1> {};
+template <> struct Priority<0> {};
+
+// handlers take (Request&, Response&), (Request&) or nothing, optionally
+// followed by the converted captures of the route, in order. What they
+// return becomes the response, see setResult (coroutine.h for Task)
+template <class Function, class Captures, size_t... I>
+auto invoke(Function& function, Request& request, Response& response, Captures& captures,
+            std::index_sequence<I...>, Priority<5>)
+    -> decltype(function(request, response, std::get<I>(captures)...), void())
+{
+    using Result = decltype(function(request, response, std::get<I>(captures)...));
+    if constexpr (std::is_void<Result>::value)
+        function(request, response, std::get<I>(captures)...);
+    else
+        setResult(response, function(request, response, std::get<I>(captures)...));
+}
+
+template <class Function, class Captures, size_t... I>
+auto invoke(Function& function, Request& request, Response& response, Captures& captures,
+            std::index_sequence<I...>, Priority<4>)
+    -> decltype(setResult(response, function(request, std::get<I>(captures)...)))
+{
+    setResult(response, function(request, std::get<I>(captures)...));
+}
+
+template <class Function, class Captures, size_t... I>
+auto invoke(Function& function, Request&, Response& response, Captures& captures,
+            std::index_sequence<I...>, Priority<3>)
+    -> decltype(setResult(response, function(std::get<I>(captures)...)))
+{
+    setResult(response, function(std::get<I>(captures)...));
+}
+
+template <class Function, class Captures, size_t... I>
+auto invoke(Function& function, Request& request, Response& response, Captures&,
+            std::index_sequence<I...>, Priority<2>)
+    -> decltype(function(request, response), void())
+{
+    using Result = decltype(function(request, response));
+    if constexpr (std::is_void<Result>::value)
+        function(request, response);
+    else
+        setResult(response, function(request, response));
+}
+
+template <class Function, class Captures, size_t... I>
+auto invoke(Function& function, Request& request, Response& response, Captures&,
+            std::index_sequence<I...>, Priority<1>)
+    -> decltype(setResult(response, function(request)))
+{
+    setResult(response, function(request));
+}
+
+template <class Function, class Captures, size_t... I>
+auto invoke(Function& function, Request&, Response& response, Captures&,
+            std::index_sequence<I...>, Priority<0>)
+    -> decltype(setResult(response, function()))
+{
+    setResult(response, function());
+}
+
+template <class Function, class Captures>
+inline void invoke(Function& function, Request& request, Response& response, Captures& captures)
+{
+    invoke(function, request, response, captures,
+           std::make_index_sequence<std::tuple_size<Captures>::value>(), Priority<5>());
+}
+
+struct Segment {
+    enum Kind {
+        Text,
+        String,
+        Int,
+        Float,
+        Path
+    } kind;
+    // the text, or the name of the capture, in the pattern
+    size_t begin;
+    size_t size;
+};
+
+template <Segment::Kind Kind> struct CaptureType { using type = boost::string_ref; };
+template <> struct CaptureType<Segment::Int> { using type = int; };
+template <> struct CaptureType<Segment::Float> { using type = double; };
+
+inline bool convert(boost::string_ref value, boost::string_ref& output) noexcept
+{
+    output = value;
+    return true;
+}
+
+template <size_t N>
+constexpr bool equals(const FixedString<N>& pattern, size_t begin, size_t size, const char* text)
+{
+    for (size_t i = 0; i < size; i++) {
+        if (!text[i] || pattern[begin + i] != text[i])
+            return false;
+    }
+    return !text[size];
+}
+
+// errors are thrown while evaluating a constant expression, so a malformed
+// pattern doesn't compile
+template <FixedString Pattern>
+constexpr size_t segmentCount()
+{
+    if (Pattern.size() == 0 || Pattern[0] != '/')
+        throw "route patterns must start with '/'";
+    size_t count = 0;
+    bool text = false;
+    for (size_t i = 0; i < Pattern.size(); i++) {
+        if (Pattern[i] == '<') {
+            if (count && !text)
+                throw "captures must be separated by text";
+            while (i < Pattern.size() && Pattern[i] != '>')
+                i++;
+            if (i == Pattern.size())
+                throw "unterminated capture in route pattern";
+            count++;
+            text = false;
+        }
+        else if (!text) {
+            count++;
+            text = true;
+        }
+    }
+    return count;
+}
+
+template <FixedString Pattern>
+constexpr std::array<Segment, segmentCount<Pattern>()> parseSegments()
+{
+    std::array<Segment, segmentCount<Pattern>()> segments{};
+    size_t count = 0;
+    size_t i = 0;
+    while (i < Pattern.size()) {
+        if (Pattern[i] != '<') {
+            size_t end = i;
+            while (end < Pattern.size() && Pattern[end] != '<')
+                end++;
+            segments[count++] = {Segment::Text, i, end - i};
+            i = end;
+            continue;
+        }
+        size_t close = i;
+        while (Pattern[close] != '>')
+            close++;
+        size_t colon = i + 1;
+        while (colon < close && Pattern[colon] != ':')
+            colon++;
+        Segment segment{Segment::String, i + 1, close - i - 1};
+        if (colon < close) {
+            const size_t size = colon - i - 1;
+            if (equals(Pattern, i + 1, size, "int"))
+                segment.kind = Segment::Int;
+            else if (equals(Pattern, i + 1, size, "float"))
+                segment.kind = Segment::Float;
+            else if (equals(Pattern, i + 1, size, "path"))
+                segment.kind = Segment::Path;
+            else if (!equals(Pattern, i + 1, size, "string"))
+                throw "unknown converter in route pattern";
+            segment.begin = colon + 1;
+            segment.size = close - colon - 1;
+        }
+        if (segment.kind == Segment::Path && close + 1 != Pattern.size())
+            throw "<path:...> captures must end the route pattern";
+        segments[count++] = segment;
+        i = close + 1;
+    }
+    return segments;
+}
+
+}
+
+/// matcher generated at compile time for a route pattern: literal patterns
+/// are a length check plus a fixed width compare, the others compare their
+/// text segments in place and convert their captures with from_chars,
+/// without a tree walk or any allocation
+template <FixedString Pattern>
+class CompiledPattern
+{
+public:
+    static constexpr auto segments = Detail::parseSegments<Pattern>();
+    static constexpr size_t captureCount = []() {
+        size_t count = 0;
+        for (const Detail::Segment& segment: segments)
+            count += segment.kind != Detail::Segment::Text;
+        return count;
+    }();
+    static constexpr bool literal = captureCount == 0;
+
+private:
+    static constexpr std::array<size_t, captureCount> captureSegments = []() {
+        std::array<size_t, captureCount> indexes{};
+        size_t count = 0;
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (segments[i].kind != Detail::Segment::Text)
+                indexes[count++] = i;
+        }
+        return indexes;
+    }();
+
+    template <size_t... I>
+    static auto capturesType(std::index_sequence<I...>)
+        -> std::tuple<typename Detail::CaptureType<segments[captureSegments[I]].kind>::type...>;
+
+    static constexpr size_t captureIndex(size_t segment)
+    {
+        size_t index = 0;
+        for (size_t i = 0; i < segment; i++)
+            index += segments[i].kind != Detail::Segment::Text;
+        return index;
+    }
+
+public:
+    using Captures = decltype(capturesType(std::make_index_sequence<captureCount>()));
+
+    /// parameters may be null when only matching
+    static bool match(boost::string_ref path, Captures& captures, PathParameters* parameters)
+    {
+        if constexpr (literal) {
+            return path.size() == Pattern.size() &&
+                   std::memcmp(path.data(), Pattern.value, Pattern.size()) == 0;
+        }
+        else {
+            return matchSegments(path, captures, parameters,
+                                 std::make_index_sequence<segments.size()>()) && path.empty();
+        }
+    }
+
+private:
+    template <size_t... I>
+    static bool matchSegments(boost::string_ref& path, Captures& captures,
+                              PathParameters* parameters, std::index_sequence<I...>)
+    {
+        return (matchSegment<I>(path, captures, parameters) && ...);
+    }
+
+    template <size_t I>
+    static bool matchSegment(boost::string_ref& path, Captures& captures, PathParameters* parameters)
+    {
+        constexpr Detail::Segment segment = segments[I];
+        if constexpr (segment.kind == Detail::Segment::Text) {
+            if (path.size() < segment.size ||
+                std::memcmp(path.data(), Pattern.value + segment.begin, segment.size) != 0)
+                return false;
+            path.remove_prefix(segment.size);
+            return true;
+        }
+        else {
+            size_t end = path.size();
+            if constexpr (segment.kind != Detail::Segment::Path) {
+                // like in the tree, a capture ends at the next '/'
+                end = std::min(path.find('/'), path.size());
+                if (!end)
+                    return false;
+            }
+            const boost::string_ref value = path.substr(0, end);
+            if (!Detail::convert(value, std::get<captureIndex(I)>(captures)))
+                return false;
+            if (parameters)
+                parameters->push(boost::string_ref(Pattern.value + segment.begin, segment.size), value);
+            path.remove_prefix(end);
+            return true;
+        }
+    }
+};
+
+template <FixedString Pattern, class Function>
+class CompiledRoute : public StaticRoute
+{
+public:
+    using Compiled = CompiledPattern<Pattern>;
+
+    using Captures = typename Compiled::Captures;
+    static_assert(sizeof(Captures) <= StaticCaptures::Size && alignof(Captures) <= alignof(std::max_align_t),
+                  "too many captures in the route pattern");
+    static_assert(std::is_trivially_destructible<Captures>::value);
+
+    explicit CompiledRoute(Function function) : function_(std::move(function)) {}
+
+    bool match(boost::string_ref path, StaticCaptures& captures, PathParameters& parameters) const override
+    {
+        return Compiled::match(path, *::new (captures.storage) Captures, &parameters);
+    }
+
+    boost::string_ref pattern() const override
+    {
+        return boost::string_ref(Pattern.value, Pattern.size());
+    }
+
+    void dispatch(StaticCaptures& captures, Request& request, Response& response) const override
+    {
+        Detail::invoke(function_, request, response, *std::launder(reinterpret_cast<Captures*>(captures.storage)));
+    }
+
+private:
+    mutable Function function_;
+};
+
+/// adds a route compiled from Pattern to router
+template <FixedString Pattern, class Function>
+void addCompiled(Router& router, Method method, Function function,
+                 boost::string_ref host = boost::string_ref())
+{
+    using Compiled = CompiledPattern<Pattern>;
+    router.add(method, Compiled::literal ? Pattern.size() : boost::string_ref::npos,
+               std::unique_ptr<StaticRoute>(new CompiledRoute<Pattern, Function>(std::move(function))),
+               host);
+}
+
+}}
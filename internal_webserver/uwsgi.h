@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <boost/utility/string_ref.hpp>
+
+namespace Wizrd { namespace Server { namespace Uwsgi {
+
+// uwsgi binary protocol, see https://uwsgi-docs.readthedocs.io/en/latest/Protocol.html
+// a packet is a 4 bytes header followed by a block of little endian
+// length prefixed key/value pairs, the request body comes right after it
+
+static const size_t HeaderSize = 4;
+/// modifier1 of a request carrying CGI variables (the one nginx sends)
+static const uint8_t Request = 0;
+
+struct PacketHeader {
+    uint8_t modifier1;
+    uint16_t dataSize;
+    uint8_t modifier2;
+};
+
+inline PacketHeader parseHeader(const char* data) noexcept
+{
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    return {bytes[0], static_cast<uint16_t>(bytes[1] | (bytes[2] << 8)), bytes[3]};
+}
+
+// visitor(boost::string_ref key, boost::string_ref value), the views point
+// into vars, returns false if the block is malformed
+template <class Visitor>
+bool decodeVars(boost::string_ref vars, Visitor&& visitor)
+{
+    auto readString = [&vars](boost::string_ref& output) -> bool {
+        if (vars.size() < 2)
+            return false;
+        const size_t size = static_cast<unsigned char>(vars[0]) |
+                            (static_cast<unsigned char>(vars[1]) << 8);
+        if (vars.size() - 2 < size)
+            return false;
+        output = vars.substr(2, size);
+        vars.remove_prefix(2 + size);
+        return true;
+    };
+    while (!vars.empty()) {
+        boost::string_ref key, value;
+        if (!readString(key) || !readString(value))
+            return false;
+        visitor(key, value);
+    }
+    return true;
+}
+
+}}}
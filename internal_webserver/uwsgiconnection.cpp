@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "uwsgiconnection.h"
+#include "cgi.h"
+#include "connectionmanager.h"
+#include <algorithm>
+#include <utility>
+
+using namespace Wizrd::Server;
+
+UwsgiConnection::UwsgiConnection(StreamProtocol::socket socket, ConnectionManager& manager,
+                                 const RequestHandler& handler)
+    : socket_(std::move(socket)),
+      state_(Header),
+      headerSize_(0),
+      varsSize_(0),
+      streaming_(false),
+      connectionManager_(manager),
+      handler_(handler)
+{
+    Cgi::reset(request_);
+    response_.responder = this;
+}
+
+void UwsgiConnection::stop()
+{
+    boost::system::error_code ignored;
+    socket_.close(ignored);
+}
+
+void UwsgiConnection::read()
+{
+    auto self(shared_from_this());
+    socket_.async_read_some(boost::asio::buffer(buffer_),
+    [this, self](boost::system::error_code errorCode, std::size_t bytesTransferred)
+    {
+        if (!errorCode) {
+            if (!consume(buffer_.data(), buffer_.data() + bytesTransferred))
+                connectionManager_.stop(shared_from_this());
+            else if (state_ == Done)
+                respond();
+            else
+                read();
+        }
+        else if (errorCode != boost::asio::error::operation_aborted) {
+            connectionManager_.stop(shared_from_this());
+        }
+    });
+}
+
+bool UwsgiConnection::consume(const char* begin, const char* end)
+{
+    while (begin != end && state_ != Done) {
+        switch (state_) {
+        case Header: {
+            const size_t size = std::min<size_t>(end - begin, Uwsgi::HeaderSize - headerSize_);
+            std::copy(begin, begin + size, header_ + headerSize_);
+            headerSize_ += size;
+            begin += size;
+            if (headerSize_ < Uwsgi::HeaderSize)
+                break;
+            const Uwsgi::PacketHeader header = Uwsgi::parseHeader(header_);
+            if (header.modifier1 != Uwsgi::Request)
+                return false;
+            varsSize_ = header.dataSize;
+            state_ = Vars;
+            break;
+        }
+        case Vars: {
+            // the common case, the whole block is in the buffer
+            if (vars_.empty() && static_cast<size_t>(end - begin) >= varsSize_) {
+                if (!decodeVars(boost::string_ref(begin, varsSize_)))
+                    return false;
+                begin += varsSize_;
+            }
+            else {
+                const size_t size = std::min<size_t>(end - begin, varsSize_ - vars_.size());
+                vars_.append(begin, size);
+                begin += size;
+                if (vars_.size() < varsSize_)
+                    break;
+                if (!decodeVars(vars_))
+                    return false;
+            }
+            if (request_.contentLength > 0) {
+                request_.data.reserve(request_.contentLength);
+                state_ = Body;
+            }
+            else {
+                state_ = Done;
+            }
+            break;
+        }
+        case Body: {
+            const size_t size = std::min<size_t>(end - begin,
+                                                 request_.contentLength - request_.data.size());
+            request_.data.append(begin, size);
+            begin += size;
+            if (request_.data.size() == static_cast<size_t>(request_.contentLength))
+                state_ = Done;
+            break;
+        }
+        case Done:
+            break;
+        }
+    }
+    // a body of zero bytes is complete as soon as the vars are
+    if (state_ == Vars && varsSize_ == 0) {
+        state_ = request_.contentLength > 0 ? Body : Done;
+    }
+    return true;
+}
+
+bool UwsgiConnection::decodeVars(boost::string_ref vars)
+{
+    return Uwsgi::decodeVars(vars, [this](boost::string_ref key, boost::string_ref value) {
+        Cgi::setVariable(request_, key, value);
+    });
+}
+
+void UwsgiConnection::respond()
+{
+    request_.connection = id();
+    // taken before the handler runs, a deferred response can be sent from
+    // another thread before it returns
+    self_ = shared_from_this();
+    hold();
+    handler_(request_, response_);
+    release();
+}
+
+void UwsgiConnection::send()
+{
+    auto self(std::move(self_));
+    request_.keepAlive = false;
+    const Response& response = response_.resolved();
+    response.toHttpHead(output_, request_);
+    // framed as the head announced: chunked for HTTP/1.1, up to the end of
+    // the connection for HTTP/1.0. One chunk per write, so that only a
+    // chunk is buffered at a time
+    streaming_ = response.stream && request_.method != Method::HEAD;
+    if (streaming_)
+        streaming_ = response.nextChunk(output_, request_.versionMinor != 0);
+    // the body is written from the response, not copied after the head
+    write(response.hasBody(request_) ? boost::asio::buffer(response.body) : boost::asio::const_buffer());
+}
+
+void UwsgiConnection::write(boost::asio::const_buffer body)
+{
+    auto self(shared_from_this());
+    const std::array<boost::asio::const_buffer, 2> buffers{boost::asio::buffer(output_), body};
+    boost::asio::async_write(socket_, buffers,
+    [this, self](boost::system::error_code errorCode, std::size_t)
+    {
+        if (!errorCode && streaming_) {
+            output_.clear();
+            streaming_ = response_.nextChunk(output_, request_.versionMinor != 0);
+            write();
+        }
+        else if (errorCode != boost::asio::error::operation_aborted) {
+            boost::system::error_code ignored;
+            socket_.shutdown(StreamProtocol::socket::shutdown_both, ignored);
+            connectionManager_.stop(shared_from_this());
+        }
+    });
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <string>
+#include "connection.h"
+#include "uwsgi.h"
+
+namespace Wizrd { namespace Server {
+
+/// uwsgi protocol connection, the proxy already parsed the request and sends
+/// it as CGI variables, so it goes straight into the Request fields without
+/// going through the RequestParser. The proxy gets a raw HTTP response and
+/// the connection is closed after it, as uwsgi has one request per connection
+class UwsgiConnection : public BasicConnection, public Responder,
+                        public std::enable_shared_from_this<UwsgiConnection>
+{
+public:
+    UwsgiConnection(const UwsgiConnection&) = delete;
+    UwsgiConnection& operator=(const UwsgiConnection&) = delete;
+
+    explicit UwsgiConnection(StreamProtocol::socket socket, ConnectionManager& manager,
+                             const RequestHandler& handler);
+    inline void start() override { read(); }
+    void stop() override;
+    inline boost::asio::any_io_executor executor() override { return socket_.get_executor(); }
+
+private:
+    void read();
+    // returns false on a malformed packet
+    bool consume(const char* begin, const char* end);
+    bool decodeVars(boost::string_ref vars);
+    void respond();
+    void send() override;
+    // writes output_, followed by body
+    void write(boost::asio::const_buffer body = boost::asio::const_buffer());
+
+    StreamProtocol::socket socket_;
+    std::array<char, 16348> buffer_;
+
+    enum {
+        Header,
+        Vars,
+        Body,
+        Done
+    } state_;
+    char header_[Uwsgi::HeaderSize];
+    size_t headerSize_;
+    size_t varsSize_;
+    // only used when the vars block doesn't come in a single read
+    std::string vars_;
+    // the response stream has chunks left
+    bool streaming_;
+
+    Request request_;
+    Response response_;
+    std::string output_;
+
+    ConnectionManager& connectionManager_;
+    const RequestHandler& handler_;
+    // keeps the connection alive while a handler completes the response
+    std::shared_ptr<UwsgiConnection> self_;
+};
+
+}}
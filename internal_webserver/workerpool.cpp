@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "workerpool.h"
+#include <algorithm>
+#include <utility>
+
+using namespace Wizrd::Server;
+
+namespace {
+
+// index of the worker running on this thread, for the jobs submitted by jobs
+thread_local const void* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+
+}
+
+WorkerPool::WorkerPool(size_t threads)
+    : next_(0),
+      queued_(0),
+      sleepers_(0),
+      running_(true)
+{
+    if (!threads)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    for (size_t i = 0; i < threads; i++)
+        workers_.emplace_back(new Worker);
+    for (size_t i = 0; i < threads; i++)
+        workers_[i]->thread = std::thread([this, i]() { run(i); });
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    wakeUp_.notify_all();
+    // the workers drain the queued jobs before they exit, see run
+    for (auto& worker: workers_)
+        worker->thread.join();
+}
+
+void WorkerPool::submit(Job job)
+{
+    Job* item = new Job(std::move(job));
+    queued_.fetch_add(1, std::memory_order_seq_cst);
+    if (currentPool == this) {
+        workers_[currentWorker]->deque.push(item);
+    }
+    else {
+        Worker& worker = *workers_[next_.fetch_add(1, std::memory_order_relaxed) % workers_.size()];
+        std::lock_guard<std::mutex> lock(worker.inboxMutex);
+        worker.inbox.push_back(item);
+    }
+    if (sleepers_.load(std::memory_order_seq_cst)) {
+        // taking the lock orders the notification after the check of a
+        // worker about to wait
+        { std::lock_guard<std::mutex> lock(mutex_); }
+        wakeUp_.notify_one();
+    }
+}
+
+void WorkerPool::run(size_t index)
+{
+    currentPool = this;
+    currentWorker = index;
+    while (true) {
+        Job* job = take(index);
+        if (!job)
+            job = steal(index);
+        if (!job && !running_.load(std::memory_order_relaxed)) {
+            // stopping, the jobs submitted before are still run. One may
+            // only be out of reach for a moment (inbox locked, lost steal)
+            if (!queued_.load(std::memory_order_seq_cst))
+                break;
+            std::this_thread::yield();
+            continue;
+        }
+        if (!job) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            wakeUp_.wait(lock, [this]() {
+                return queued_.load(std::memory_order_seq_cst) || !running_.load(std::memory_order_relaxed);
+            });
+            sleepers_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        queued_.fetch_sub(1, std::memory_order_relaxed);
+        (*job)();
+        delete job;
+    }
+}
+
+WorkerPool::Job* WorkerPool::take(size_t index)
+{
+    Worker& worker = *workers_[index];
+    if (Job* job = worker.deque.pop())
+        return job;
+    {
+        // moved to the deque, so that idle workers can steal them
+        std::lock_guard<std::mutex> lock(worker.inboxMutex);
+        for (Job* job: worker.inbox)
+            worker.deque.push(job);
+        worker.inbox.clear();
+    }
+    return worker.deque.pop();
+}
+
+WorkerPool::Job* WorkerPool::steal(size_t index)
+{
+    for (size_t i = 1; i < workers_.size(); i++) {
+        Worker& victim = *workers_[(index + i) % workers_.size()];
+        if (Job* job = victim.deque.steal())
+            return job;
+        // a busy victim doesn't empty its inbox
+        std::unique_lock<std::mutex> lock(victim.inboxMutex, std::try_to_lock);
+        if (lock && !victim.inbox.empty()) {
+            Job* job = victim.inbox.front();
+            victim.inbox.erase(victim.inbox.begin());
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+WorkerPool& Wizrd::Server::defaultWorkerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
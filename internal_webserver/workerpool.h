@@ -0,0 +1,224 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+#include <boost/asio/post.hpp>
+#include "coroutine.h"
+#include "staticroute.h"
+
+namespace Wizrd { namespace Server {
+
+/// Chase-Lev deque: its owner pushes and pops at the bottom, other threads
+/// steal from the top without locks. Grows when full, the old arrays are
+/// kept until it is destroyed as a thief may still read them
+template <class T>
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(size_t capacity = 256)
+        : top_(0), bottom_(0)
+    {
+        arrays_.emplace_back(new Array(capacity));
+        array_.store(arrays_.back().get(), std::memory_order_relaxed);
+    }
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    /// owner only
+    void push(T* item)
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        const int64_t top = top_.load(std::memory_order_acquire);
+        Array* array = array_.load(std::memory_order_relaxed);
+        if (bottom - top > static_cast<int64_t>(array->mask))
+            array = grow(array, top, bottom);
+        array->put(bottom, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    /// owner only, the last pushed item or null
+    T* pop()
+    {
+        const int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        Array* array = array_.load(std::memory_order_relaxed);
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = array->get(bottom);
+        if (top == bottom) {
+            // last item, races with the thieves
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                              std::memory_order_relaxed))
+                item = nullptr;
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /// any thread, the oldest item or null when empty or lost to another thief
+    T* steal()
+    {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return nullptr;
+        T* item = array_.load(std::memory_order_acquire)->get(top);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                          std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+    inline bool empty() const noexcept
+    {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Array {
+        explicit Array(size_t capacity) : mask(capacity - 1), items(new std::atomic<T*>[capacity]) {}
+        inline T* get(int64_t index) const noexcept { return items[index & mask].load(std::memory_order_relaxed); }
+        inline void put(int64_t index, T* item) noexcept { items[index & mask].store(item, std::memory_order_relaxed); }
+
+        const size_t mask;
+        std::unique_ptr<std::atomic<T*>[]> items;
+    };
+
+    Array* grow(Array* array, int64_t top, int64_t bottom)
+    {
+        arrays_.emplace_back(new Array((array->mask + 1) * 2));
+        Array* grown = arrays_.back().get();
+        for (int64_t i = top; i < bottom; i++)
+            grown->put(i, array->get(i));
+        array_.store(grown, std::memory_order_release);
+        return grown;
+    }
+
+    alignas(64) std::atomic<int64_t> top_;
+    alignas(64) std::atomic<int64_t> bottom_;
+    std::atomic<Array*> array_;
+    std::vector<std::unique_ptr<Array>> arrays_;
+};
+
+/// threads for CPU heavy work, away from the I/O threads. Each worker has a
+/// deque for the jobs submitted by the jobs it runs and an inbox for the
+/// ones submitted by other threads, idle workers steal from the others.
+/// The destructor waits for every job submitted before it, including the
+/// ones those jobs submit
+class WorkerPool
+{
+public:
+    using Job = std::function<void()>;
+
+    /// 0 threads means one per core
+    explicit WorkerPool(size_t threads = 0);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    void submit(Job job);
+    inline size_t size() const noexcept { return workers_.size(); }
+
+private:
+    struct Worker {
+        WorkStealingDeque<Job> deque;
+        std::mutex inboxMutex;
+        std::vector<Job*> inbox;
+        std::thread thread;
+    };
+
+    void run(size_t index);
+    Job* take(size_t index);
+    Job* steal(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_;
+    // jobs submitted and not taken yet, workers sleep when there is none
+    std::atomic<size_t> queued_;
+    std::atomic<size_t> sleepers_;
+    std::atomic<bool> running_;
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+};
+
+/// the pool used by Route(...) { request.offload(); }
+WorkerPool& defaultWorkerPool();
+
+/// handler run on a worker pool: the connection defers the response, its
+/// I/O thread goes on serving the others and the response is sent from it
+/// once the handler returned
+template <class Function>
+class Offload
+{
+public:
+    inline Offload(WorkerPool& pool, Function function) : pool_(&pool), function_(std::move(function)) {}
+
+    /// captures are copied, they are views into the request or numbers
+    template <class... Captures>
+    void operator()(Request& request, Response& response, Captures&... captures)
+    {
+        Responder* responder = response.responder;
+        if (!responder) {
+            auto arguments = std::tie(captures...);
+            Detail::invoke(function_, request, response, arguments);
+            return;
+        }
+        responder->defer();
+        pool_->submit([this, &request, &response, responder, executor = responder->executor(),
+                       arguments = std::make_tuple(captures...)]() mutable {
+            try {
+                Detail::invoke(function_, request, response, arguments);
+            }
+            catch (...) {
+                Detail::fail(response, std::current_exception());
+            }
+            boost::asio::post(executor, [responder]() { responder->complete(); });
+        });
+    }
+
+private:
+    WorkerPool* pool_;
+    Function function_;
+};
+
+}}
@@ -0,0 +1,700 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "loadgen.h"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <boost/asio.hpp>
+#include "../internal_webserver/json.h"
+
+namespace Wizrd { namespace LoadGen {
+
+namespace {
+
+namespace asio = boost::asio;
+using tcp = asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+
+inline bool equalNoCase(std::string_view text, std::string_view lower) noexcept
+{
+    return text.size() == lower.size() &&
+           std::equal(lower.begin(), lower.end(), text.begin(), [](char a, char b) {
+               return a == (b >= 'A' && b <= 'Z' ? b - 'A' + 'a' : b);
+           });
+}
+
+inline std::string_view trim(std::string_view text) noexcept
+{
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+        text.remove_prefix(1);
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t'))
+        text.remove_suffix(1);
+    return text;
+}
+
+void merge(Histogram& into, const Histogram& histogram) noexcept
+{
+    for (size_t i = 0; i < into.counts.size(); i++)
+        into.counts[i] += histogram.counts[i];
+    into.count += histogram.count;
+    into.sum += histogram.sum;
+}
+
+// what the clients of a run share, read only once it starts
+struct Plan
+{
+    tcp::endpoint endpoint;
+    // the requests of the mix as sent, whether they are HEAD ones and the
+    // running total of their weights
+    std::vector<std::string> requests;
+    std::vector<bool> heads;
+    std::vector<unsigned> weights;
+    size_t connections;
+    size_t pipeline;
+    bool openLoop;
+    // between the requests of a connection, in an open loop
+    Clock::duration interval;
+    Clock::time_point start;
+    Clock::time_point end;
+};
+
+// a connection to the server, which it sends requests over until the end of
+// the run. Everything happens on the thread of its io_context
+class Client : public std::enable_shared_from_this<Client>
+{
+public:
+    // done is called once the client is finished
+    Client(asio::io_context& ioContext, const Plan& plan, LoadReport& report, size_t index,
+           std::function<void()> done)
+        : ioContext_(ioContext),
+          socket_(ioContext),
+          timer_(ioContext),
+          plan_(plan),
+          report_(report),
+          done_(std::move(done)),
+          random_(static_cast<unsigned>(index + 1)),
+          // the connections of an open loop take turns
+          next_(plan.start + plan.interval * index / plan.connections)
+    {
+    }
+
+    inline void start() { connect(); }
+
+    // gives up on the responses in flight
+    void finish()
+    {
+        if (finished_)
+            return;
+        report_.errors += inFlight_.size();
+        inFlight_.clear();
+        close();
+        finished_ = true;
+        done_();
+    }
+
+private:
+    struct InFlight
+    {
+        // when it was due, and when it was written
+        Clock::time_point due;
+        Clock::time_point sent;
+        bool head;
+    };
+
+    void connect()
+    {
+        close();
+        socket_ = tcp::socket(ioContext_);
+        auto self(shared_from_this());
+        socket_.async_connect(plan_.endpoint, [this, self, generation = generation_](boost::system::error_code error) {
+            if (generation != generation_ || finished_)
+                return;
+            if (error) {
+                report_.errors++;
+                retry();
+                return;
+            }
+            socket_.set_option(tcp::no_delay(true), error);
+            connected_ = true;
+            fill();
+            if (!finished_)
+                read();
+        });
+    }
+
+    // connects again shortly, if the run is not over
+    void retry()
+    {
+        if (Clock::now() >= plan_.end) {
+            finish();
+            return;
+        }
+        auto self(shared_from_this());
+        timer_.expires_after(std::chrono::milliseconds(10));
+        timer_.async_wait([this, self, generation = generation_](boost::system::error_code error) {
+            if (!error && generation == generation_ && !finished_)
+                connect();
+        });
+    }
+
+    // sends the requests due, or that fit in the pipeline in a closed loop
+    void fill()
+    {
+        const Clock::time_point now = Clock::now();
+        if (plan_.openLoop) {
+            while (inFlight_.size() < plan_.pipeline && next_ <= now && next_ < plan_.end) {
+                send(next_);
+                next_ += plan_.interval;
+            }
+            if (inFlight_.size() < plan_.pipeline && next_ < plan_.end && !waiting_) {
+                // a due request waits for the pipeline instead, and its
+                // latency counts the wait
+                waiting_ = true;
+                auto self(shared_from_this());
+                timer_.expires_at(next_);
+                timer_.async_wait([this, self, generation = generation_](boost::system::error_code error) {
+                    if (generation != generation_)
+                        return;
+                    waiting_ = false;
+                    if (!error && !finished_)
+                        fill();
+                });
+            }
+        }
+        else if (now < plan_.end) {
+            while (inFlight_.size() < plan_.pipeline)
+                send(now);
+        }
+        if (inFlight_.empty() && (now >= plan_.end || (plan_.openLoop && next_ >= plan_.end))) {
+            finish();
+            return;
+        }
+        flush();
+    }
+
+    void send(Clock::time_point due)
+    {
+        const unsigned pick = std::uniform_int_distribution<unsigned>(0, plan_.weights.back() - 1)(random_);
+        const size_t index = std::upper_bound(plan_.weights.begin(), plan_.weights.end(), pick) -
+                             plan_.weights.begin();
+        queued_ += plan_.requests[index];
+        inFlight_.push_back(InFlight{due, Clock::now(), plan_.heads[index]});
+        report_.requests++;
+    }
+
+    // one write at a time, requests queued meanwhile go in the next one
+    void flush()
+    {
+        if (writing_ || queued_.empty())
+            return;
+        writing_ = true;
+        output_.swap(queued_);
+        queued_.clear();
+        auto self(shared_from_this());
+        asio::async_write(socket_, asio::buffer(output_),
+        [this, self, generation = generation_](boost::system::error_code error, std::size_t bytes) {
+            if (generation != generation_ || finished_)
+                return;
+            writing_ = false;
+            if (error) {
+                lost(true);
+                return;
+            }
+            report_.bytesSent += bytes;
+            flush();
+        });
+    }
+
+    void read()
+    {
+        auto self(shared_from_this());
+        socket_.async_read_some(asio::buffer(buffer_),
+        [this, self, generation = generation_](boost::system::error_code error, std::size_t bytes) {
+            if (generation != generation_ || finished_)
+                return;
+            if (error) {
+                // a response delimited by the end of the connection
+                if (error == asio::error::eof && !input_.empty() && !inFlight_.empty()) {
+                    ResponseHead head;
+                    try {
+                        head = parseResponse(input_, inFlight_.front().head);
+                    }
+                    catch (const LoadGenException&) {
+                    }
+                    if (head.status && head.close)
+                        complete(head.status);
+                }
+                lost(error != asio::error::eof);
+                return;
+            }
+            report_.bytesReceived += bytes;
+            input_.append(buffer_.data(), bytes);
+            received();
+        });
+    }
+
+    // takes the complete responses out of input_
+    void received()
+    {
+        size_t offset = 0;
+        bool close = false;
+        while (!inFlight_.empty()) {
+            ResponseHead head;
+            try {
+                head = parseResponse(std::string_view(input_).substr(offset), inFlight_.front().head);
+            }
+            catch (const LoadGenException&) {
+                lost(true);
+                return;
+            }
+            if (!head.size)
+                break;
+            offset += head.size;
+            complete(head.status);
+            if (head.close) {
+                close = true;
+                break;
+            }
+        }
+        input_.erase(0, offset);
+        if (close || (inFlight_.empty() && !input_.empty())) {
+            // what is sent after a response that closes the connection (or
+            // that answers nothing) is never answered
+            lost(!close);
+            return;
+        }
+        fill();
+        if (!finished_)
+            read();
+    }
+
+    void complete(int status)
+    {
+        const Clock::time_point now = Clock::now();
+        const InFlight& request = inFlight_.front();
+        report_.responses++;
+        report_.statuses[status >= 100 && status < 600 ? status / 100 : 0]++;
+        report_.uncorrected.record(nanoseconds(now - request.sent));
+        if (plan_.openLoop)
+            report_.latency.record(nanoseconds(now - request.due));
+        inFlight_.pop_front();
+    }
+
+    // the connection is gone, requests in flight go unanswered
+    void lost(bool error)
+    {
+        report_.errors += inFlight_.size() + (error && inFlight_.empty() ? 1 : 0);
+        inFlight_.clear();
+        if (Clock::now() >= plan_.end) {
+            finish();
+            return;
+        }
+        report_.reconnects++;
+        connect();
+    }
+
+    void close()
+    {
+        // callbacks of the operations pending on the socket are ignored
+        generation_++;
+        boost::system::error_code ignored;
+        timer_.cancel();
+        socket_.close(ignored);
+        connected_ = false;
+        writing_ = false;
+        waiting_ = false;
+        queued_.clear();
+        input_.clear();
+    }
+
+    static inline uint64_t nanoseconds(Clock::duration elapsed) noexcept
+    {
+        const auto count = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        return count > 0 ? static_cast<uint64_t>(count) : 0;
+    }
+
+    asio::io_context& ioContext_;
+    tcp::socket socket_;
+    asio::steady_timer timer_;
+    const Plan& plan_;
+    LoadReport& report_;
+    std::function<void()> done_;
+    std::minstd_rand random_;
+    std::deque<InFlight> inFlight_;
+    std::string queued_;
+    std::string output_;
+    std::string input_;
+    std::array<char, 16384> buffer_;
+    // when the next request is due, in an open loop
+    Clock::time_point next_;
+    unsigned generation_ = 0;
+    bool connected_ = false;
+    bool writing_ = false;
+    // the timer waits for the next request due
+    bool waiting_ = false;
+    bool finished_ = false;
+};
+
+void writeLatency(Server::JsonWriter& json, const Histogram& histogram)
+{
+    json.beginObject();
+    json.key("count").value(histogram.count);
+    json.key("mean").value(histogram.count ? histogram.sum / 1e3 / histogram.count : 0.0);
+    json.key("p50").value(histogram.quantile(0.5) / 1e3);
+    json.key("p90").value(histogram.quantile(0.9) / 1e3);
+    json.key("p99").value(histogram.quantile(0.99) / 1e3);
+    json.key("p999").value(histogram.quantile(0.999) / 1e3);
+    json.key("max").value(histogram.quantile(1.0) / 1e3);
+    // [upper bound, count] of the buckets with samples
+    json.key("buckets").beginArray();
+    for (size_t i = 0; i < histogram.counts.size(); i++) {
+        if (histogram.counts[i]) {
+            json.beginArray();
+            json.value(Server::LatencyHistogram::upperBound(i) / 1e3).value(histogram.counts[i]);
+            json.endArray();
+        }
+    }
+    json.endArray();
+    json.endObject();
+}
+
+void writeLatency(std::string& output, const char* name, const Histogram& histogram)
+{
+    char line[256];
+    const int size = std::snprintf(line, sizeof(line),
+        "%-12s mean %10.1f  p50 %10.1f  p90 %10.1f  p99 %10.1f  p99.9 %10.1f  max %10.1f us\n", name,
+        histogram.count ? histogram.sum / 1e3 / histogram.count : 0.0, histogram.quantile(0.5) / 1e3,
+        histogram.quantile(0.9) / 1e3, histogram.quantile(0.99) / 1e3, histogram.quantile(0.999) / 1e3,
+        histogram.quantile(1.0) / 1e3);
+    output.append(line, size);
+}
+
+}
+
+std::vector<RequestTemplate> parseMix(std::istream& input)
+{
+    std::vector<RequestTemplate> mix;
+    std::string line;
+    for (size_t number = 1; std::getline(input, line); number++) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#')
+            continue;
+        const std::string where = "line " + std::to_string(number) + " of the mix: ";
+        RequestTemplate request;
+        if (std::all_of(first.begin(), first.end(), [](char chr) { return chr >= '0' && chr <= '9'; })) {
+            const auto parsed = std::from_chars(first.data(), first.data() + first.size(), request.weight);
+            if (parsed.ec != std::errc() || request.weight == 0)
+                throw LoadGenException(where + "bad weight " + first);
+            fields >> request.method;
+        }
+        else {
+            request.method = first;
+        }
+        if (!(fields >> request.target))
+            throw LoadGenException(where + "expected [weight] METHOD target [body]");
+        if (!std::all_of(request.method.begin(), request.method.end(), [](char chr) { return chr >= 'A' && chr <= 'Z'; }))
+            throw LoadGenException(where + "bad method " + request.method);
+        std::getline(fields >> std::ws, request.body);
+        mix.push_back(std::move(request));
+    }
+    if (mix.empty())
+        throw LoadGenException("the mix has no request");
+    return mix;
+}
+
+ResponseHead parseResponse(std::string_view data, bool head)
+{
+    ResponseHead response;
+    const size_t prefix = std::min<size_t>(data.size(), 5);
+    if (data.substr(0, prefix) != std::string_view("HTTP/", prefix))
+        throw LoadGenException("not an HTTP response");
+    const size_t headEnd = data.find("\r\n\r\n");
+    if (headEnd == std::string_view::npos)
+        return response;
+
+    // HTTP/1.1 200 OK
+    const size_t lineEnd = data.find("\r\n");
+    const size_t space = data.find(' ');
+    if (space == std::string_view::npos || space + 4 > lineEnd ||
+        std::from_chars(data.data() + space + 1, data.data() + space + 4, response.status).ptr != data.data() + space + 4)
+        throw LoadGenException("bad HTTP status line");
+    bool keepAlive = data.compare(0, 8, "HTTP/1.0") != 0;
+
+    long long contentLength = -1;
+    bool chunked = false;
+    for (size_t start = lineEnd + 2; start < headEnd;) {
+        const size_t end = data.find("\r\n", start);
+        const std::string_view header = data.substr(start, end - start);
+        start = end + 2;
+        const size_t colon = header.find(':');
+        if (colon == std::string_view::npos)
+            continue;
+        const std::string_view name = trim(header.substr(0, colon));
+        const std::string_view value = trim(header.substr(colon + 1));
+        if (equalNoCase(name, "content-length")) {
+            if (std::from_chars(value.data(), value.data() + value.size(), contentLength).ptr !=
+                    value.data() + value.size() || contentLength < 0)
+                throw LoadGenException("bad Content-Length");
+        }
+        else if (equalNoCase(name, "transfer-encoding")) {
+            chunked = value.size() >= 7 && equalNoCase(value.substr(value.size() - 7), "chunked");
+        }
+        else if (equalNoCase(name, "connection")) {
+            if (equalNoCase(value, "close"))
+                keepAlive = false;
+            else if (equalNoCase(value, "keep-alive"))
+                keepAlive = true;
+        }
+    }
+    response.close = !keepAlive;
+
+    size_t end = headEnd + 4;
+    if (head || response.status / 100 == 1 || response.status == 204 || response.status == 304) {
+        response.size = end;
+    }
+    else if (chunked) {
+        for (;;) {
+            const size_t sizeEnd = data.find("\r\n", end);
+            if (sizeEnd == std::string_view::npos)
+                return response;
+            size_t chunkSize = 0;
+            if (std::from_chars(data.data() + end, data.data() + sizeEnd, chunkSize, 16).ec != std::errc())
+                throw LoadGenException("bad chunk size");
+            end = sizeEnd + 2;
+            if (!chunkSize)
+                break;
+            end += chunkSize + 2;
+            if (end > data.size())
+                return response;
+        }
+        // trailers, up to an empty line
+        for (;;) {
+            const size_t trailerEnd = data.find("\r\n", end);
+            if (trailerEnd == std::string_view::npos)
+                return response;
+            const bool last = trailerEnd == end;
+            end = trailerEnd + 2;
+            if (last)
+                break;
+        }
+        response.size = end;
+    }
+    else if (contentLength >= 0) {
+        if (data.size() >= end + contentLength)
+            response.size = end + contentLength;
+    }
+    else {
+        // the body is whatever comes until the connection is closed
+        response.close = true;
+    }
+    return response;
+}
+
+Histogram correctedForOmission(const Histogram& histogram, uint64_t interval)
+{
+    Histogram corrected = histogram;
+    if (!interval)
+        return corrected;
+    for (size_t i = 0; i < histogram.counts.size(); i++) {
+        if (!histogram.counts[i])
+            continue;
+        const uint64_t value = Server::LatencyHistogram::upperBound(i);
+        for (uint64_t missing = value > interval ? value - interval : 0; missing >= interval; missing -= interval)
+            corrected.record(missing, histogram.counts[i]);
+    }
+    return corrected;
+}
+
+LoadReport run(const LoadOptions& options)
+{
+    if (!options.connections || !options.pipeline || options.rate < 0)
+        throw LoadGenException("connections and pipeline must be positive, rate not negative");
+
+    Plan plan;
+    try {
+        asio::io_context ioContext;
+        tcp::resolver resolver(ioContext);
+        plan.endpoint = *resolver.resolve(options.host, std::to_string(options.port)).begin();
+    }
+    catch (const boost::system::system_error& error) {
+        throw LoadGenException("cannot resolve " + options.host + ": " + error.what());
+    }
+    const std::vector<RequestTemplate> defaultMix(1);
+    const std::string& host = options.hostHeader.empty() ? options.host : options.hostHeader;
+    unsigned weights = 0;
+    for (const RequestTemplate& request: options.mix.empty() ? defaultMix : options.mix) {
+        std::string http = request.method + ' ' + request.target + " HTTP/1.1\r\nHost: " + host + "\r\n";
+        if (!request.body.empty())
+            http += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+        http += "\r\n";
+        http += request.body;
+        plan.requests.push_back(std::move(http));
+        plan.heads.push_back(request.method == "HEAD");
+        plan.weights.push_back(weights += request.weight);
+    }
+    plan.connections = options.connections;
+    plan.pipeline = options.pipeline;
+    plan.openLoop = options.rate > 0;
+    plan.interval = plan.openLoop
+        ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.connections / options.rate))
+        : Clock::duration(0);
+
+    // each thread runs its clients on an io_context of its own, they share
+    // nothing but the plan
+    struct Worker
+    {
+        asio::io_context ioContext;
+        LoadReport report;
+        std::vector<std::shared_ptr<Client>> clients;
+        size_t running = 0;
+        // responses still missing a second after the end are given up on
+        asio::steady_timer deadline{ioContext};
+    };
+    const size_t threadCount = std::clamp<size_t>(options.threads, 1, options.connections);
+    std::vector<std::unique_ptr<Worker>> workers;
+    plan.start = Clock::now();
+    plan.end = plan.start + options.duration;
+    for (size_t thread = 0; thread < threadCount; thread++) {
+        workers.push_back(std::make_unique<Worker>());
+        Worker& worker = *workers.back();
+        for (size_t index = thread; index < options.connections; index += threadCount) {
+            worker.clients.push_back(std::make_shared<Client>(worker.ioContext, plan, worker.report, index,
+                [&worker] {
+                    if (!--worker.running)
+                        worker.deadline.cancel();
+                }));
+            worker.running++;
+        }
+        worker.deadline.expires_at(plan.end + std::chrono::seconds(1));
+        worker.deadline.async_wait([&worker](boost::system::error_code error) {
+            if (!error) {
+                for (auto& client: worker.clients)
+                    client->finish();
+            }
+        });
+        for (auto& client: worker.clients)
+            client->start();
+    }
+
+    std::vector<std::thread> threads;
+    for (auto& worker: workers)
+        threads.emplace_back([&worker] { worker->ioContext.run(); });
+    for (auto& thread: threads)
+        thread.join();
+
+    LoadReport report;
+    report.options = options;
+    report.seconds = std::chrono::duration<double>(options.duration).count();
+    for (const auto& worker: workers) {
+        const LoadReport& part = worker->report;
+        report.requests += part.requests;
+        report.responses += part.responses;
+        report.errors += part.errors;
+        report.reconnects += part.reconnects;
+        for (size_t i = 0; i < 6; i++)
+            report.statuses[i] += part.statuses[i];
+        report.bytesSent += part.bytesSent;
+        report.bytesReceived += part.bytesReceived;
+        merge(report.latency, part.latency);
+        merge(report.uncorrected, part.uncorrected);
+    }
+    if (!plan.openLoop) {
+        uint64_t interval = options.expectedInterval;
+        if (!interval && report.uncorrected.count)
+            interval = report.uncorrected.sum / report.uncorrected.count;
+        report.latency = correctedForOmission(report.uncorrected, interval);
+    }
+    return report;
+}
+
+void LoadReport::writeJson(std::string& output) const
+{
+    Server::JsonWriter json(output);
+    json.beginObject();
+    json.key("mode").value(options.rate > 0 ? "open" : "closed");
+    json.key("host").value(options.host);
+    json.key("port").value(options.port);
+    json.key("connections").value(options.connections);
+    json.key("pipeline").value(options.pipeline);
+    json.key("threads").value(options.threads);
+    json.key("rate").value(options.rate);
+    json.key("seconds").value(seconds);
+    json.key("requests").value(requests);
+    json.key("responses").value(responses);
+    json.key("errors").value(errors);
+    json.key("reconnects").value(reconnects);
+    json.key("status").beginObject();
+    static const char* const classes[] = {"other", "1xx", "2xx", "3xx", "4xx", "5xx"};
+    for (size_t i = 0; i < 6; i++)
+        json.key(classes[i]).value(statuses[i]);
+    json.endObject();
+    json.key("bytes_sent").value(bytesSent);
+    json.key("bytes_received").value(bytesReceived);
+    json.key("throughput").value(seconds > 0 ? responses / seconds : 0.0);
+    // microseconds
+    json.key("latency_us");
+    writeLatency(json, latency);
+    json.key("uncorrected_latency_us");
+    writeLatency(json, uncorrected);
+    json.endObject();
+    output += '\n';
+}
+
+void LoadReport::writeText(std::string& output) const
+{
+    char line[256];
+    int size = std::snprintf(line, sizeof(line),
+        "%s loop, %zu connections, pipeline %zu, %.1f s against %s:%u\n",
+        options.rate > 0 ? "open" : "closed", options.connections, options.pipeline, seconds,
+        options.host.c_str(), static_cast<unsigned>(options.port));
+    output.append(line, size);
+    size = std::snprintf(line, sizeof(line),
+        "%llu requests, %llu responses (%.1f/s), %llu errors, %llu reconnects\n"
+        "status 2xx %llu, 3xx %llu, 4xx %llu, 5xx %llu, other %llu\n",
+        static_cast<unsigned long long>(requests), static_cast<unsigned long long>(responses),
+        seconds > 0 ? responses / seconds : 0.0, static_cast<unsigned long long>(errors),
+        static_cast<unsigned long long>(reconnects), static_cast<unsigned long long>(statuses[2]),
+        static_cast<unsigned long long>(statuses[3]), static_cast<unsigned long long>(statuses[4]),
+        static_cast<unsigned long long>(statuses[5]),
+        static_cast<unsigned long long>(statuses[0] + statuses[1]));
+    output.append(line, size);
+    writeLatency(output, "latency", latency);
+    writeLatency(output, "uncorrected", uncorrected);
+}
+
+}}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "utils/exceptions.h"
+#include "../internal_webserver/metrics.h"
+
+namespace Wizrd { namespace LoadGen {
+
+class LoadGenException: public BaseException { using BaseException::BaseException; };
+
+/// a request of the mix, picked weight times out of the total weight
+struct RequestTemplate
+{
+    std::string method = "GET";
+    std::string target = "/";
+    std::string body;
+    unsigned weight = 1;
+};
+
+/// reads a request mix, one request per line: "[weight] METHOD target
+/// [body]", blank lines and lines starting with '#' are skipped. Throws
+/// LoadGenException on a malformed line
+std::vector<RequestTemplate> parseMix(std::istream& input);
+
+/// the first HTTP/1.x response at the start of data
+struct ResponseHead
+{
+    /// bytes of the response, head and body, 0 while incomplete
+    size_t size = 0;
+    int status = 0;
+    /// Connection: close, or a body delimited by the end of the connection
+    bool close = false;
+};
+
+/// parses the response to a request (head tells a HEAD one), throws
+/// LoadGenException when data is not a response
+ResponseHead parseResponse(std::string_view data, bool head);
+
+using Histogram = Server::LatencyHistogram::Snapshot;
+
+/// histogram as recorded by a client that waits interval nanoseconds
+/// between requests but couldn't send the ones due while it waited on a
+/// slow response: each value v adds the missing samples v - interval,
+/// v - 2 interval and so on (coordinated omission)
+Histogram correctedForOmission(const Histogram& histogram, uint64_t interval);
+
+struct LoadOptions
+{
+    std::string host = "127.0.0.1";
+    unsigned short port = 8080;
+    /// sent as the Host header, host when empty
+    std::string hostHeader;
+    size_t connections = 16;
+    /// requests in flight per connection
+    size_t pipeline = 1;
+    /// each runs its share of the connections on an io_context of its own
+    size_t threads = 1;
+    /// requests per second over all connections, sent when due whether
+    /// the responses came or not (open loop). 0 sends the next request as
+    /// soon as a response comes (closed loop)
+    double rate = 0;
+    std::chrono::milliseconds duration{10000};
+    /// closed loop only, the interval of correctedForOmission in
+    /// nanoseconds, 0 takes the mean latency
+    uint64_t expectedInterval = 0;
+    /// a GET / when empty
+    std::vector<RequestTemplate> mix;
+};
+
+struct LoadReport
+{
+    LoadOptions options;
+    double seconds = 0;
+    uint64_t requests = 0;
+    uint64_t responses = 0;
+    /// connect, read and write failures and requests left unanswered
+    uint64_t errors = 0;
+    uint64_t reconnects = 0;
+    /// responses by status class, 1xx to 5xx, [0] for anything else
+    uint64_t statuses[6] = {};
+    uint64_t bytesSent = 0;
+    uint64_t bytesReceived = 0;
+    /// nanoseconds from when each request was due: when it was scheduled
+    /// in an open loop, corrected for omission in a closed one
+    Histogram latency;
+    /// nanoseconds from when each request was written
+    Histogram uncorrected;
+
+    void writeJson(std::string& output) const;
+    void writeText(std::string& output) const;
+};
+
+/// HTTP/1.1 load over the connections of options, until its duration is
+/// over and the responses in flight are in (or a second more passed)
+LoadReport run(const LoadOptions& options);
+
+}}
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "loadgen.h"
+#include "utils/uri.h"
+#include "../internal_webserver/router.h"
+#include "../internal_webserver/server.h"
+
+using namespace Wizrd;
+using namespace Wizrd::LoadGen;
+
+namespace {
+
+const char usage[] =
+    "usage: wizrd_loadgen [options] [http://host[:port]]\n"
+    "  -c, --connections N     connections (16)\n"
+    "  -p, --pipeline N        requests in flight per connection (1)\n"
+    "  -t, --threads N         client threads (1)\n"
+    "  -r, --rate R            requests per second over all connections, an open\n"
+    "                          loop; 0 for a closed loop (0)\n"
+    "  -d, --duration S        seconds (10)\n"
+    "  -m, --mix FILE          requests, one per line: [weight] METHOD target [body]\n"
+    "  -i, --expected-interval US\n"
+    "                          closed loop interval for the coordinated omission\n"
+    "                          correction, the mean latency by default\n"
+    "  -f, --format json|text  report format (json)\n"
+    "  --in-process            targets a server started in the process, on\n"
+    "                          loopback, that answers GET / and POST /echo\n"
+    "  --server-threads N      threads of that server (1)\n";
+
+[[noreturn]] void fail(const std::string& message)
+{
+    std::cerr << "wizrd_loadgen: " << message << '\n' << usage;
+    std::exit(2);
+}
+
+double number(const char* text, const char* option)
+{
+    char* end;
+    const double value = std::strtod(text, &end);
+    if (end == text || *end || value < 0)
+        fail(std::string("bad value for ") + option + ": " + text);
+    return value;
+}
+
+// a whole number of at least 1, for counts and ports
+size_t count(const char* text, const char* option)
+{
+    char* end;
+    const unsigned long long value = std::strtoull(text, &end, 10);
+    if (end == text || *end || *text < '0' || *text > '9')
+        fail(std::string("bad value for ") + option + ", expected a whole number: " + text);
+    if (!value)
+        fail(std::string("bad value for ") + option + ", it must be at least 1");
+    return static_cast<size_t>(value);
+}
+
+// host and port of an http:// url
+void target(const std::string& url, LoadOptions& options)
+{
+    RequestTarget parts;
+    if (!RequestTarget::parse(url, parts) || parts.form != RequestTarget::Absolute || parts.scheme != "http")
+        fail("expected an http:// url, got " + url);
+    const std::string authority = parts.authority.to_string();
+    // the colons of an [ipv6] address are not the port
+    const size_t bracket = authority.rfind(']');
+    size_t colon = authority.rfind(':');
+    if (bracket != std::string::npos && colon < bracket)
+        colon = std::string::npos;
+    options.host = authority.substr(0, colon);
+    if (colon != std::string::npos) {
+        const size_t port = count(authority.c_str() + colon + 1, "port");
+        if (port > 65535)
+            fail("bad port in " + url);
+        options.port = static_cast<unsigned short>(port);
+    }
+    if (options.host.size() > 2 && options.host.front() == '[' && options.host.back() == ']')
+        options.host = options.host.substr(1, options.host.size() - 2);
+    options.hostHeader = authority;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    bool json = true;
+    bool inProcess = false;
+    size_t serverThreads = 1;
+    for (int i = 1; i < argc; i++) {
+        const std::string option = argv[i];
+        auto value = [&]() -> const char* {
+            if (i + 1 == argc)
+                fail(option + " needs a value");
+            return argv[++i];
+        };
+        if (option == "-h" || option == "--help") {
+            std::cout << usage;
+            return 0;
+        }
+        else if (option == "-c" || option == "--connections")
+            options.connections = count(value(), "connections");
+        else if (option == "-p" || option == "--pipeline")
+            options.pipeline = count(value(), "pipeline");
+        else if (option == "-t" || option == "--threads")
+            options.threads = count(value(), "threads");
+        else if (option == "-r" || option == "--rate")
+            options.rate = number(value(), "rate");
+        else if (option == "-d" || option == "--duration")
+            options.duration = std::chrono::milliseconds(static_cast<long long>(number(value(), "duration") * 1000));
+        else if (option == "-i" || option == "--expected-interval")
+            options.expectedInterval = static_cast<uint64_t>(number(value(), "expected interval") * 1000);
+        else if (option == "-f" || option == "--format") {
+            const std::string format = value();
+            if (format != "json" && format != "text")
+                fail("unknown format " + format);
+            json = format == "json";
+        }
+        else if (option == "-m" || option == "--mix") {
+            const char* path = value();
+            std::ifstream file(path);
+            if (!file)
+                fail(std::string("cannot open ") + path);
+            try {
+                options.mix = parseMix(file);
+            }
+            catch (const LoadGenException& error) {
+                fail(error.what());
+            }
+        }
+        else if (option == "--in-process")
+            inProcess = true;
+        else if (option == "--server-threads")
+            serverThreads = count(value(), "server threads");
+        else if (!option.empty() && option[0] != '-')
+            target(option, options);
+        else
+            fail("unknown option " + option);
+    }
+
+    // a server on loopback, for runs that only depend on this build
+    Server::Router router;
+    std::unique_ptr<Server::Server> server;
+    std::vector<std::thread> serverThreadPool;
+    if (inProcess) {
+        router.add(Server::Method::GET, "/", [](Server::Request&, Server::Response& response) {
+            response.body = "hello world!";
+        });
+        router.add(Server::Method::POST, "/echo", [](Server::Request& request, Server::Response& response) {
+            response.body.assign(request.data.data(), request.data.size());
+        });
+        server = std::make_unique<Server::Server>([&router](Server::Request& request, Server::Response& response) {
+            router(request, response);
+        });
+        Server::Listener& listener = server->listen("127.0.0.1", 0);
+        options.host = "127.0.0.1";
+        options.port = listener.port();
+        options.hostHeader.clear();
+        for (size_t i = 0; i < serverThreads; i++)
+            serverThreadPool.emplace_back([&server] { server->run(); });
+    }
+
+    int status = 0;
+    try {
+        const LoadReport report = run(options);
+        std::string output;
+        if (json)
+            report.writeJson(output);
+        else
+            report.writeText(output);
+        std::cout << output << std::flush;
+    }
+    catch (const LoadGenException& error) {
+        std::cerr << "wizrd_loadgen: " << error.what() << '\n';
+        status = 1;
+    }
+
+    if (server) {
+        server->stop();
+        for (auto& thread: serverThreadPool)
+            thread.join();
+    }
+    return status;
+}
@@ -25,182 +25,387 @@
  */
 
 #include "base64.h"
-#include <vector>
-#include <boost/config.hpp>
 #include <algorithm>
-#include <memory>
-#include <sstream>
-#include <streambuf>
-#include <iostream>
-#include <type_traits>
+#include <atomic>
+#include <boost/config.hpp>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BASE64_X86 1
+#endif
 
 namespace Wizrd {
 
-enum {
-    Whitespace = 64,
-    Equals,
-    Invalid
+namespace {
+
+// a kernel converts whole blocks from the start of its input and returns
+// how much it consumed (bytes for encode, chars for decode), the rest is
+// left to the scalar code. A decode kernel stops at the first block with
+// anything else than the 64 chars of the alphabet in it
+struct Kernels
+{
+    Base64::Kernel kind;
+    size_t (*encode)(const uint8_t* data, size_t size, char* output, char char62, char char63);
+    size_t (*decode)(const char* data, size_t size, uint8_t* output);
 };
 
+size_t encodeNone(const uint8_t*, size_t, char*, char, char) { return 0; }
+size_t decodeNone(const char*, size_t, uint8_t*) { return 0; }
 
-const std::vector<char> Base64::encodeTable_{'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H',
-                                             'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
-                                             'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X',
-                                             'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
-                                             'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n',
-                                             'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
-                                             'w', 'x', 'y', 'z', '0', '1', '2', '3',
-                                             '4', '5', '6', '7', '8', '9', '+', '/'};
-
-const std::vector<char> Base64::decodeTable_{66,66,66,66,66,66,66,66,66,64,64,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
-                                             66,66,66,66,66,66,66,64,66,66,66,66,66,66,66,66,66,66,62,66,66,66,63,52,53,
-                                             54,55,56,57,58,59,60,61,66,66,66,65,66,66,66, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9,
-                                             10,11,12,13,14,15,16,17,18,19,20,21,22,23,24,25,66,66,66,66,66,66,26,27,28,
-                                             29,30,31,32,33,34,35,36,37,38,39,40,41,42,43,44,45,46,47,48,49,50,51,66,66,
-                                             66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
-                                             66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
-                                             66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
-                                             66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
-                                             66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,66,
-                                             66,66,66,66,66,66};
+#ifdef BASE64_X86
 
-std::string Base64::encode(const std::string& data, bool breakLine)
+// the vector code follows W. Mula and D. Lemire, "Faster Base64 Encoding
+// and Decoding Using AVX2 Instructions": bytes are spread over 6 bits
+// lanes with shuffles and multiplies, the chars come from a 16 entries
+// table indexed by the range of the value (and back when decoding)
+
+__attribute__((target("ssse3")))
+inline __m128i encodeLanes(__m128i bytes, __m128i offsets)
 {
-    std::vector<char> output;
-    if (data.length() == 0)
-        return "";
-    size_t outputSize = (((data.length() / 3) + (data.length() % 3 > 0)) * 4L);
-
-    if (BOOST_UNLIKELY(breakLine))
-        outputSize += outputSize % BASE64_BREAK_LINE + 1;
-
-    output.reserve(outputSize);
-    std::stringbuf pdata{data};
-    size_t current = 0;
-    size_t group24;
-    auto append = [&output, &breakLine, &current](char v) {
-        output.push_back(v);
-        if (BOOST_UNLIKELY(breakLine) && !(++current % BASE64_BREAK_LINE))
-            output.push_back('\n');
-    };
-
-    while (pdata.in_avail() > 2) {
-
-        auto d1 = pdata.sbumpc(),
-             d2 = pdata.sbumpc(),
-             d3 = pdata.sbumpc();
-
-        group24 = (d1 << 16) | (d2 << 8) | d3;
-        const int foo = group24 & 0x00FC0000;
-        append(encodeTable_[group24 >> 18 & 0x3f]);
-        append(encodeTable_[group24 >> 12 & 0x3f]);
-        append(encodeTable_[group24 >> 6 & 0x3f]);
-        append(encodeTable_[group24 & 0x3f]);
+    // 12 bytes to 16 chars: each 3 bytes become 4 indices of 6 bits
+    const __m128i in = _mm_shuffle_epi8(bytes, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    const __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)),
+                                         _mm_set1_epi32(0x04000040));
+    const __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)),
+                                        _mm_set1_epi32(0x01000010));
+    const __m128i indices = _mm_or_si128(high, low);
+
+    // offset from the index to its char, by range of the index
+    __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+    return _mm_add_epi8(_mm_shuffle_epi8(offsets, range), indices);
+}
+
+// 16 chars to 12 bytes (in the first 12 bytes), false if one of the chars
+// isn't in the alphabet
+__attribute__((target("ssse3")))
+inline bool decodeLanes(__m128i chars, __m128i& bytes)
+{
+    const __m128i nibbleMask = _mm_set1_epi8(0x0f);
+    const __m128i highNibbles = _mm_and_si128(_mm_srli_epi32(chars, 4), nibbleMask);
+    const __m128i lowNibbles = _mm_and_si128(chars, nibbleMask);
+    // a char is valid when the bits of its low and high nibbles don't meet
+    const __m128i lowBits = _mm_shuffle_epi8(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                           0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A),
+                                             lowNibbles);
+    const __m128i highBits = _mm_shuffle_epi8(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10),
+                                              highNibbles);
+    const __m128i invalid = _mm_and_si128(lowBits, highBits);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF)
+        return false;
+
+    const __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+    const __m128i offsets = _mm_shuffle_epi8(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                                           0, 0, 0, 0, 0, 0, 0, 0),
+                                             _mm_add_epi8(slash, highNibbles));
+    const __m128i values = _mm_add_epi8(chars, offsets);
+    // packs 4 values of 6 bits per 32 bits lane into 3 bytes
+    const __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i groups = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+    bytes = _mm_shuffle_epi8(groups, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    return true;
+}
+
+__attribute__((target("ssse3")))
+size_t encodeSsse3(const uint8_t* data, size_t size, char* output, char char62, char char63)
+{
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, char62 - 62,
+                                          char63 - 63, 'A', 0, 0);
+    // each load reads 16 bytes for the 12 it converts
+    size_t done = 0;
+    for (; size - done >= 16; done += 12, output += 16) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + done));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), encodeLanes(bytes, offsets));
     }
-    switch (pdata.in_avail() % 3) {
-    case 1:
-        group24 = (pdata.sbumpc() << 16);
-        append(encodeTable_[(group24 >> 18) & 0x3f]);
-        append(encodeTable_[(group24 >> 12) & 0x3f]);
-        append('=');
-        append('=');
-        break;
-    case 2:
-        group24 = pdata.sbumpc() << 16 |
-                  pdata.sbumpc() << 8;
-        append(encodeTable_[(group24 & 0x00FC0000) >> 18]);
-        append(encodeTable_[(group24 & 0x0003F000) >> 12]);
-        append(encodeTable_[(group24 & 0x00000FC0) >> 6]);
-        append('=');
-        break;
+    return done;
+}
+
+__attribute__((target("ssse3")))
+size_t decodeSsse3(const char* data, size_t size, uint8_t* output)
+{
+    size_t done = 0;
+    for (; size - done >= 16; done += 16, output += 12) {
+        __m128i bytes;
+        if (!decodeLanes(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + done)), bytes))
+            break;
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output), bytes);
+        const uint32_t last = _mm_cvtsi128_si32(_mm_srli_si128(bytes, 8));
+        std::memcpy(output + 8, &last, 4);
     }
-    if (BOOST_UNLIKELY(breakLine && output[output.size() - 1] != '\n') )
-        output.push_back('\n');
+    return done;
+}
 
-    return std::string(output.begin(), output.end());
+// the AVX2 versions run the same steps on both 128 bits lanes, shuffles
+// don't cross lanes
+
+__attribute__((target("avx2")))
+size_t encodeAvx2(const uint8_t* data, size_t size, char* output, char char62, char char63)
+{
+    const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, char62 - 62,
+                                             char63 - 63, 'A', 0, 0,
+                                             'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                             '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, char62 - 62,
+                                             char63 - 63, 'A', 0, 0);
+    size_t done = 0;
+    for (; size - done >= 28; done += 24, output += 32) {
+        const __m256i bytes = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + done))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + done + 12)), 1);
+        const __m256i in = _mm256_shuffle_epi8(bytes, _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+                                                                      10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+        const __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)),
+                                                _mm256_set1_epi32(0x04000040));
+        const __m256i low = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)),
+                                               _mm256_set1_epi32(0x01000010));
+        const __m256i indices = _mm256_or_si256(high, low);
+
+        __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices),
+                                                        _mm256_set1_epi8(13)));
+        const __m256i chars = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, range), indices);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output), chars);
+    }
+    return done;
 }
 
-std::string Base64::encode(const char* data, int size, bool breakLine)
+__attribute__((target("avx2")))
+size_t decodeAvx2(const char* data, size_t size, uint8_t* output)
 {
-    return encode(std::string(data, size), breakLine);
-}
-
-std::string Base64::decode(std::string data) throw(Base64DecodeException)
-{
-
-    std::vector<char> output;
-    output.reserve(((data.length() / 4) * 3));
-    size_t group24 = 0;
-    size_t count = 0;
-    size_t padding = 0;
-    auto i = data.begin();
-    while (i < data.end()) {
-        // for speed using a pre computed decode table
-        for (int qpos = 0; qpos < 4; qpos++) {
-            char c;
-            if (i >= data.end())
-                break;
-            c = decodeTable_[*i++];
-            if (output.size() > 2048)
-            {
-                char bar = ' ';
-            }
-
-            switch (c) {
-
-            case Whitespace:
-                qpos--;
-                if (i >= data.end())
-                    goto out;
-                continue;
-            case Invalid:
-                throw Base64DecodeException("Non Valid character in Base64");
-                break;
-            case Equals:
-                padding++;
-                count++;
-                if (i >= data.end())
-                    goto out;
-                break;
-
-            default:
-                if(padding)
-                    throw Base64DecodeException("Invalid Padding in Base64");
-
-                count++;
-                group24 = (group24 << 6) | c;
-
-            }
-        }
-        output.push_back((group24 >> 16) & 0xFF);
-        output.push_back((group24 >> 8) & 0xFF);
-        output.push_back((group24) & 0xFF);
+    const __m256i nibbleMask = _mm256_set1_epi8(0x0f);
+    const __m256i lowTable = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                              0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                              0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i highTable = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                               0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                               0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i offsetTable = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    size_t done = 0;
+    for (; size - done >= 32; done += 32, output += 24) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + done));
+        const __m256i highNibbles = _mm256_and_si256(_mm256_srli_epi32(chars, 4), nibbleMask);
+        const __m256i lowNibbles = _mm256_and_si256(chars, nibbleMask);
+        const __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lowTable, lowNibbles),
+                                                 _mm256_shuffle_epi8(highTable, highNibbles));
+        if (!_mm256_testz_si256(invalid, invalid))
+            break;
 
+        const __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+        const __m256i values = _mm256_add_epi8(chars, _mm256_shuffle_epi8(offsetTable,
+                                                                          _mm256_add_epi8(slash, highNibbles)));
+        const __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        const __m256i groups = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+        __m256i bytes = _mm256_shuffle_epi8(groups, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                                                     2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+        // the 12 bytes of each lane next to each other
+        bytes = _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm256_castsi256_si128(bytes));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(output + 16), _mm256_extracti128_si256(bytes, 1));
     }
-    out:
-    if (count % 4)
-        throw Base64DecodeException("Invalid Base64 length");
-    switch (padding) {
-    case 0:
-        break;
-    case 1:
-        output.push_back((group24 >> 10) & 0xFF);
-        output.push_back((group24 >> 2) & 0xFF);
-        break;
-    case 2:
-        output.push_back((group24 >> 4) & 0xff);
-        break;
+    return done;
+}
+
+#endif
+
+const Kernels scalarKernels{Base64::Kernel::Scalar, encodeNone, decodeNone};
+#ifdef BASE64_X86
+const Kernels ssse3Kernels{Base64::Kernel::Ssse3, encodeSsse3, decodeSsse3};
+const Kernels avx2Kernels{Base64::Kernel::Avx2, encodeAvx2, decodeAvx2};
+#endif
+
+bool supported(Base64::Kernel kernel) noexcept
+{
+    switch (kernel) {
+    case Base64::Kernel::Scalar:
+        return true;
+#ifdef BASE64_X86
+    case Base64::Kernel::Ssse3:
+        // may run before the constructors, which initialize the CPU model
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+    case Base64::Kernel::Avx2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const Kernels* kernelsOf(Base64::Kernel kernel) noexcept
+{
+    switch (kernel) {
+#ifdef BASE64_X86
+    case Base64::Kernel::Ssse3:
+        return &ssse3Kernels;
+    case Base64::Kernel::Avx2:
+        return &avx2Kernels;
+#endif
     default:
-        throw Base64DecodeException("Invalid Padding in Base64");
+        return &scalarKernels;
+    }
+}
+
+Base64::Kernel bestKernel() noexcept
+{
+    if (supported(Base64::Kernel::Avx2))
+        return Base64::Kernel::Avx2;
+    if (supported(Base64::Kernel::Ssse3))
+        return Base64::Kernel::Ssse3;
+    return Base64::Kernel::Scalar;
+}
+
+// picked on first use rather than by a static constructor, so that it is
+// set whatever the order other libraries are initialized in
+std::atomic<const Kernels*> kernels{nullptr};
+
+const Kernels& activeKernels() noexcept
+{
+    const Kernels* active = kernels.load(std::memory_order_relaxed);
+    if (BOOST_UNLIKELY(!active)) {
+        active = kernelsOf(bestKernel());
+        kernels.store(active, std::memory_order_relaxed);
+    }
+    return *active;
+}
+
+} // anonymous namespace
+
+size_t Detail::base64EncodeBlocks(const uint8_t* data, size_t size, char* output,
+                                  char char62, char char63) noexcept
+{
+    return activeKernels().encode(data, size, output, char62, char63);
+}
+
+size_t Detail::base64DecodeBlocks(const char* data, size_t size, uint8_t* output) noexcept
+{
+    return activeKernels().decode(data, size, output);
+}
+
+size_t Base64::encodedSize(size_t size, bool breakLine) noexcept
+{
+    return breakLine ? Base64Mime::encodedSize(size) : Base64Standard::encodedSize(size);
+}
+
+void Base64::encodeInto(const char* data, size_t size, char* output, bool breakLine)
+{
+    if (breakLine)
+        Base64Mime::encodeInto(data, size, output);
+    else
+        Base64Standard::encodeInto(data, size, output);
+}
+
+std::string Base64::encode(const std::string& data, bool breakLine)
+{
+    return breakLine ? Base64Mime::encode(data) : Base64Standard::encode(data);
+}
+
+std::string Base64::encode(const char* data, int size, bool breakLine)
+{
+    const std::string_view view(data, size);
+    return breakLine ? Base64Mime::encode(view) : Base64Standard::encode(view);
+}
+
+size_t Base64::decodeInto(const char* data, size_t size, char* output)
+{
+    return Base64Standard::decodeInto(data, size, output);
+}
+
+std::string Base64::decode(std::string data)
+{
+    return Base64Standard::decode(data);
+}
+
+std::string Base64::decode(const char* const data, int size)
+{
+    return Base64Standard::decode(std::string_view(data, size));
+}
+
+size_t Base64Encoder::update(const char* data, size_t size, char* output) noexcept
+{
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    char* const start = output;
+    if (carried_ && carried_ + size >= 3) {
+        uint8_t group[3] = {carry_[0], carried_ == 2 ? carry_[1] : bytes[0], bytes[2 - carried_]};
+        const size_t taken = 3 - carried_;
+        output = Base64Standard::encodeRun(group, 3, output);
+        column_ += 4;
+        output = endLine(output);
+        bytes += taken;
+        size -= taken;
+        carried_ = 0;
     }
 
-    ret:
-    return std::string(output.begin(), output.end());
+    const size_t whole = carried_ ? 0 : size / 3 * 3;
+    for (size_t done = 0; done < whole;) {
+        // up to the end of the line, column_ is always a multiple of 4
+        const size_t length = breakLine_ ? std::min(whole - done, (BASE64_BREAK_LINE - column_) / 4 * 3)
+                                         : whole - done;
+        char* const next = Base64Standard::encodeRun(bytes + done, length, output);
+        column_ += next - output;
+        output = endLine(next);
+        done += length;
+    }
+    bytes += whole;
+    size -= whole;
+
+    std::copy_n(bytes, size, carry_ + carried_);
+    carried_ += size;
+    return output - start;
 }
 
-std::string Base64::decode(const char* const data, int size) throw(Base64DecodeException)
+size_t Base64Encoder::finish(char* output) noexcept
 {
+    char* const start = output;
+    if (carried_) {
+        output = Base64Standard::encodeRun(carry_, carried_, output);
+        column_ += 4;
+    }
+    if (breakLine_ && column_)
+        *output++ = '\n';
+    carried_ = 0;
+    column_ = 0;
+    return output - start;
+}
 
+char* Base64Encoder::endLine(char* output) noexcept
+{
+    if (!breakLine_ || column_ < BASE64_BREAK_LINE)
+        return output;
+    column_ = 0;
+    *output++ = '\n';
+    return output;
+}
+
+size_t Base64Decoder::update(const char* data, size_t size, char* output)
+{
+    uint8_t* const bytes = reinterpret_cast<uint8_t*>(output);
+    return Base64Standard::decodeRun(data, data + size, bytes, state_) - bytes;
+}
+
+void Base64Decoder::finish()
+{
+    uint8_t unused[2];
+    Base64Standard::decodeFinish(unused, state_);
+}
+
+Base64::Kernel Base64::kernel() noexcept
+{
+    return activeKernels().kind;
+}
+
+bool Base64::setKernel(Kernel kernel) noexcept
+{
+    if (!supported(kernel))
+        return false;
+    kernels.store(kernelsOf(kernel), std::memory_order_relaxed);
+    return true;
 }
 
 }
@@ -27,25 +27,350 @@
 #pragma once
 #include "exceptions.h"
 #include <string>
-#include <vector>
+#include <string_view>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 
 namespace Wizrd {
 
 #define BASE64_BREAK_LINE 76
 class Base64DecodeException: BaseException { using BaseException::BaseException;};
 
+/// the 64 chars of base64 and of base64url (RFC 4648), the chars 0 to 61
+/// of an alphabet are always A-Z, a-z and 0-9
+struct Base64Alphabet {
+    static constexpr char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+};
+struct Base64UrlAlphabet {
+    static constexpr char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+};
+
+namespace Detail {
+
+/// a group of 4 chars being decoded, padding is the number of '=' in it
+struct Base64DecodeState {
+    uint32_t group24 = 0;
+    int count = 0;
+    int padding = 0;
+};
+
+enum : uint8_t {
+    Base64Whitespace = 64,
+    Base64Equals,
+    Base64Invalid
+};
+
+/// value of each char in the alphabet, or what else it is
+template <class Alphabet>
+struct Base64DecodeTable {
+    uint8_t values[256] = {};
+
+    constexpr Base64DecodeTable()
+    {
+        for (int i = 0; i < 256; i++)
+            values[i] = Base64Invalid;
+        for (int i = 0; i < 64; i++)
+            values[static_cast<unsigned char>(Alphabet::chars[i])] = i;
+        values[static_cast<int>(' ')] = Base64Whitespace;
+        values[static_cast<int>('\t')] = Base64Whitespace;
+        values[static_cast<int>('\n')] = Base64Whitespace;
+        values[static_cast<int>('\r')] = Base64Whitespace;
+        values[static_cast<int>('=')] = Base64Equals;
+    }
+};
+
+/// the vector kernels of the CPU, they convert whole blocks from the start
+/// of data and return how much they consumed (bytes for encode, chars for
+/// decode). Encoding takes the last two chars of the alphabet, decoding is
+/// for Base64Alphabet only and stops at the first block with anything else
+/// than its 64 chars in it
+size_t base64EncodeBlocks(const uint8_t* data, size_t size, char* output, char char62, char char63) noexcept;
+size_t base64DecodeBlocks(const char* data, size_t size, uint8_t* output) noexcept;
+
+}
+
+/// a Base64 codec fixed at compile time: the alphabet, whether the last
+/// group is padded with '=' and the length of the lines, broken with '\n'
+/// (0 for a single line). Decoding skips whitespace and, when the codec
+/// doesn't pad, takes input with or without padding
+template <class Alphabet, bool Padding = true, size_t LineLength = 0>
+class BasicBase64 {
+    static_assert(LineLength % 4 == 0, "lines hold whole groups");
+
+public:
+    static constexpr size_t encodedSize(size_t size) noexcept
+    {
+        const size_t chars = Padding ? (size + 2) / 3 * 4 : (size * 4 + 2) / 3;
+        if constexpr (LineLength != 0)
+            return chars + (chars + LineLength - 1) / LineLength;
+        return chars;
+    }
+    /// bytes decoded from size chars at most
+    static constexpr size_t decodedSize(size_t size) noexcept
+    {
+        return Padding ? size / 4 * 3 : size / 4 * 3 + size % 4 * 3 / 4;
+    }
+
+    /// encodes size bytes of data into output, which holds
+    /// encodedSize(size) chars. Nothing is allocated
+    static void encodeInto(const char* data, size_t size, char* output) noexcept
+    {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+        if constexpr (LineLength == 0) {
+            encodeRun(bytes, size, output);
+        }
+        else {
+            // the last line ends with a break too
+            const size_t lineBytes = LineLength / 4 * 3;
+            for (; size > lineBytes; bytes += lineBytes, size -= lineBytes) {
+                output = encodeRun(bytes, lineBytes, output);
+                *output++ = '\n';
+            }
+            if (size) {
+                output = encodeRun(bytes, size, output);
+                *output++ = '\n';
+            }
+        }
+    }
+    static std::string encode(std::string_view data)
+    {
+        std::string output(encodedSize(data.size()), '\0');
+        encodeInto(data.data(), data.size(), output.data());
+        return output;
+    }
+
+    /// decodes data into output, which holds decodedSize(size) bytes, and
+    /// returns the number of bytes written. Nothing is allocated
+    static size_t decodeInto(const char* data, size_t size, char* output)
+    {
+        Detail::Base64DecodeState state;
+        uint8_t* const bytes = reinterpret_cast<uint8_t*>(output);
+        uint8_t* const end = decodeRun(data, data + size, bytes, state);
+        return decodeFinish(end, state) - bytes;
+    }
+    static std::string decode(std::string_view data)
+    {
+        std::string output(decodedSize(data.size()), '\0');
+        output.resize(decodeInto(data.data(), data.size(), output.data()));
+        return output;
+    }
+
+    /// encodes a single line of size bytes, the last group padded
+    static char* encodeRun(const uint8_t* data, size_t size, char* output) noexcept
+    {
+        const size_t done = Detail::base64EncodeBlocks(data, size, output, Alphabet::chars[62], Alphabet::chars[63]);
+        data += done;
+        size -= done;
+        output += done / 3 * 4;
+        for (; size >= 3; data += 3, size -= 3) {
+            const uint32_t group24 = uint32_t(data[0]) << 16 | uint32_t(data[1]) << 8 | data[2];
+            *output++ = Alphabet::chars[group24 >> 18];
+            *output++ = Alphabet::chars[(group24 >> 12) & 0x3f];
+            *output++ = Alphabet::chars[(group24 >> 6) & 0x3f];
+            *output++ = Alphabet::chars[group24 & 0x3f];
+        }
+        if (size) {
+            const uint32_t group24 = uint32_t(data[0]) << 16 | (size == 2 ? uint32_t(data[1]) << 8 : 0);
+            *output++ = Alphabet::chars[group24 >> 18];
+            *output++ = Alphabet::chars[(group24 >> 12) & 0x3f];
+            if (size == 2)
+                *output++ = Alphabet::chars[(group24 >> 6) & 0x3f];
+            if constexpr (Padding) {
+                if (size == 1)
+                    *output++ = '=';
+                *output++ = '=';
+            }
+        }
+        return output;
+    }
+
+    /// decodes [data, end) on from state: the kernel takes the runs of
+    /// whole groups, the scalar code whatever stops it (whitespace,
+    /// padding, errors) up to the end of a group
+    static uint8_t* decodeRun(const char* data, const char* const end, uint8_t* output,
+                              Detail::Base64DecodeState& state)
+    {
+        while (data != end) {
+            if constexpr (Alphabet::chars[62] == '+' && Alphabet::chars[63] == '/') {
+                if (state.count == 0 && state.padding == 0) {
+                    const size_t done = Detail::base64DecodeBlocks(data, end - data, output);
+                    data += done;
+                    output += done / 4 * 3;
+                    if (data == end)
+                        break;
+                }
+            }
+            data = decodeGroup(data, end, output, state);
+        }
+        return output;
+    }
+    /// ends the input, where a group may be left short when the codec
+    /// doesn't pad
+    static uint8_t* decodeFinish(uint8_t* output, Detail::Base64DecodeState& state)
+    {
+        const Detail::Base64DecodeState last = state;
+        state = Detail::Base64DecodeState();
+        if (last.count == 0)
+            return output;
+        if (Padding || last.count == 1 || last.padding)
+            throw Base64DecodeException("Invalid Base64 length");
+        *output++ = (last.group24 >> (last.count == 2 ? 4 : 10)) & 0xFF;
+        if (last.count == 3)
+            *output++ = (last.group24 >> 2) & 0xFF;
+        return output;
+    }
+
+private:
+    static constexpr Detail::Base64DecodeTable<Alphabet> decodeTable_{};
+
+    // decodes chars until a group is complete, returns where it stopped
+    static const char* decodeGroup(const char* data, const char* const end, uint8_t*& output,
+                                   Detail::Base64DecodeState& state)
+    {
+        while (data != end) {
+            const uint8_t value = decodeTable_.values[static_cast<unsigned char>(*data++)];
+            switch (value) {
+            case Detail::Base64Whitespace:
+                continue;
+            case Detail::Base64Invalid:
+                throw Base64DecodeException("Non Valid character in Base64");
+            case Detail::Base64Equals:
+                if (++state.padding > 2 || state.count < 2)
+                    throw Base64DecodeException("Invalid Padding in Base64");
+                state.group24 <<= 6;
+                break;
+            default:
+                if (state.padding)
+                    throw Base64DecodeException("Invalid Padding in Base64");
+                state.group24 = (state.group24 << 6) | value;
+            }
+            if (++state.count < 4)
+                continue;
+            *output++ = (state.group24 >> 16) & 0xFF;
+            if (state.padding < 2)
+                *output++ = (state.group24 >> 8) & 0xFF;
+            if (state.padding < 1)
+                *output++ = state.group24 & 0xFF;
+            state.group24 = 0;
+            state.count = 0;
+            break;
+        }
+        return data;
+    }
+};
+
+/// base64 as in MIME and PEM, base64url for JWTs and URLs
+using Base64Standard = BasicBase64<Base64Alphabet>;
+using Base64Mime = BasicBase64<Base64Alphabet, true, BASE64_BREAK_LINE>;
+using Base64Url = BasicBase64<Base64UrlAlphabet, false>;
+
 class Base64 {
 public:
+    /// the vector instructions the codec runs on, picked for the CPU at
+    /// start up; Scalar everywhere else
+    enum class Kernel {
+        Scalar,
+        Ssse3,
+        Avx2
+    };
+
     static std::string encode(const std::string& data, bool breakLine = false);
     static std::string encode(const char* data, int size, bool breakLine = false);
-    static std::string decode(std::string data) throw(Base64DecodeException);
-    static std::string decode(const char* const data, int size) throw(Base64DecodeException);
+    static std::string decode(std::string data);
+    static std::string decode(const char* const data, int size);
+    /// decodes data into output, which holds at least size / 4 * 3 bytes,
+    /// and returns the number of bytes written. Nothing is allocated
+    static size_t decodeInto(const char* data, size_t size, char* output);
+    /// encodes size bytes of data into output, which holds encodedSize(size)
+    /// chars. Nothing is allocated
+    static void encodeInto(const char* data, size_t size, char* output, bool breakLine = false);
+    static size_t encodedSize(size_t size, bool breakLine = false) noexcept;
+
+    static Kernel kernel() noexcept;
+    /// runs on kernel from now on, false if the CPU doesn't support it
+    static bool setKernel(Kernel kernel) noexcept;
 
 private:
-    static const std::vector<char> encodeTable_;
-    static const std::vector<char> decodeTable_;
     Base64() = delete;
 };
 
+/// encodes a stream given in chunks of any size, the 0 to 2 bytes left
+/// over by a chunk are carried to the next one and lines are broken at
+/// BASE64_BREAK_LINE chars across chunks
+class Base64Encoder {
+public:
+    explicit Base64Encoder(bool breakLine = false) noexcept : breakLine_(breakLine) {}
+
+    /// chars that update(size bytes) or finish() may write at most
+    inline size_t outputSize(size_t size) const noexcept { return Base64::encodedSize(size + 2, breakLine_); }
+    /// encodes data into output, which holds outputSize(size) chars, and
+    /// returns the number of chars written
+    size_t update(const char* data, size_t size, char* output) noexcept;
+    /// writes the last group, padded, and the last line break; the encoder
+    /// can be used again after it
+    size_t finish(char* output) noexcept;
+
+    template <class OutputIterator>
+    OutputIterator update(const char* data, size_t size, OutputIterator output)
+    {
+        char buffer[1024];
+        while (size) {
+            const size_t taken = std::min<size_t>(size, 576);
+            output = std::copy_n(buffer, update(data, taken, buffer), output);
+            data += taken;
+            size -= taken;
+        }
+        return output;
+    }
+    template <class OutputIterator>
+    OutputIterator finish(OutputIterator output)
+    {
+        char buffer[8];
+        return std::copy_n(buffer, finish(buffer), output);
+    }
+
+private:
+    // breaks the line once it is full
+    char* endLine(char* output) noexcept;
+
+    bool breakLine_;
+    uint8_t carry_[2];
+    size_t carried_ = 0;
+    // chars on the current line
+    size_t column_ = 0;
+};
+
+/// decodes a stream given in chunks of any size, the 0 to 3 chars of a
+/// group split between chunks are carried to the next one. Whitespace and
+/// line breaks are skipped wherever they are
+class Base64Decoder {
+public:
+    /// bytes that update(size chars) may write at most
+    inline size_t outputSize(size_t size) const noexcept { return (state_.count + size) / 4 * 3; }
+    /// decodes data into output, which holds outputSize(size) bytes, and
+    /// returns the number of bytes written
+    size_t update(const char* data, size_t size, char* output);
+    /// throws if the stream ends inside a group; the decoder can be used
+    /// again after it
+    void finish();
+
+    template <class OutputIterator>
+    OutputIterator update(const char* data, size_t size, OutputIterator output)
+    {
+        char buffer[1024];
+        while (size) {
+            const size_t taken = std::min<size_t>(size, 1020);
+            output = std::copy_n(buffer, update(data, taken, buffer), output);
+            data += taken;
+            size -= taken;
+        }
+        return output;
+    }
+
+private:
+    Detail::Base64DecodeState state_;
+};
+
 
 }
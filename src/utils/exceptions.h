@@ -8,14 +8,14 @@ namespace Wizrd {
     {
     public:
         inline BaseException(const std::string what)
-            :what_(what.c_str())
+            :what_(what)
         {
         }
-        inline const char* what() noexcept
+        inline const char* what() const noexcept override
         {
-            return what_;
+            return what_.c_str();
         }
     private:
-        const char* what_;
+        std::string what_;
     };
 }
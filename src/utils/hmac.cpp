@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "hmac.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Wizrd {
+
+namespace {
+
+const uint32_t roundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline uint32_t rotate(uint32_t value, int bits) noexcept
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+}
+
+Sha256::Sha256() noexcept
+    : state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      blockSize_(0),
+      length_(0)
+{
+}
+
+void Sha256::compress(const uint8_t* block) noexcept
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = uint32_t(block[i * 4]) << 24 | uint32_t(block[i * 4 + 1]) << 16 |
+               uint32_t(block[i * 4 + 2]) << 8 | uint32_t(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        const uint32_t s0 = rotate(w[i - 15], 7) ^ rotate(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = rotate(w[i - 2], 17) ^ rotate(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = state_[0], b = state_[1], c = state_[2], d = state_[3],
+             e = state_[4], f = state_[5], g = state_[6], h = state_[7];
+    for (int i = 0; i < 64; i++) {
+        const uint32_t t1 = h + (rotate(e, 6) ^ rotate(e, 11) ^ rotate(e, 25)) +
+                            ((e & f) ^ (~e & g)) + roundConstants[i] + w[i];
+        const uint32_t t2 = (rotate(a, 2) ^ rotate(a, 13) ^ rotate(a, 22)) +
+                            ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state_[0] += a;
+    state_[1] += b;
+    state_[2] += c;
+    state_[3] += d;
+    state_[4] += e;
+    state_[5] += f;
+    state_[6] += g;
+    state_[7] += h;
+}
+
+void Sha256::update(const void* data, size_t size) noexcept
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    length_ += size;
+    if (blockSize_) {
+        const size_t taken = std::min(size, BlockSize - blockSize_);
+        std::memcpy(block_ + blockSize_, bytes, taken);
+        blockSize_ += taken;
+        bytes += taken;
+        size -= taken;
+        if (blockSize_ < BlockSize)
+            return;
+        compress(block_);
+        blockSize_ = 0;
+    }
+    for (; size >= BlockSize; bytes += BlockSize, size -= BlockSize)
+        compress(bytes);
+    std::memcpy(block_, bytes, size);
+    blockSize_ = size;
+}
+
+Sha256::Digest Sha256::finish() noexcept
+{
+    const uint64_t bits = length_ * 8;
+    const uint8_t padding[BlockSize] = {0x80};
+    update(padding, blockSize_ < 56 ? 56 - blockSize_ : 120 - blockSize_);
+    uint8_t length[8];
+    for (int i = 0; i < 8; i++)
+        length[i] = uint8_t(bits >> (56 - i * 8));
+    update(length, sizeof(length));
+
+    Digest digest;
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = uint8_t(state_[i] >> 24);
+        digest[i * 4 + 1] = uint8_t(state_[i] >> 16);
+        digest[i * 4 + 2] = uint8_t(state_[i] >> 8);
+        digest[i * 4 + 3] = uint8_t(state_[i]);
+    }
+    return digest;
+}
+
+HmacSha256::HmacSha256(boost::string_ref key) noexcept
+{
+    // keys longer than a block are hashed first
+    uint8_t block[Sha256::BlockSize] = {};
+    if (key.size() > Sha256::BlockSize) {
+        Sha256 hash;
+        hash.update(key);
+        const Digest digest = hash.finish();
+        std::memcpy(block, digest.data(), digest.size());
+    }
+    else {
+        std::memcpy(block, key.data(), key.size());
+    }
+
+    uint8_t innerKey[Sha256::BlockSize];
+    for (size_t i = 0; i < Sha256::BlockSize; i++) {
+        innerKey[i] = block[i] ^ 0x36;
+        outerKey_[i] = block[i] ^ 0x5c;
+    }
+    inner_.update(innerKey, sizeof(innerKey));
+}
+
+HmacSha256::Digest HmacSha256::finish() noexcept
+{
+    const Digest innerDigest = inner_.finish();
+    Sha256 outer;
+    outer.update(outerKey_, sizeof(outerKey_));
+    outer.update(innerDigest.data(), innerDigest.size());
+    return outer.finish();
+}
+
+HmacSha256::Digest HmacSha256::digest(boost::string_ref key, boost::string_ref message) noexcept
+{
+    HmacSha256 hmac(key);
+    hmac.update(message);
+    return hmac.finish();
+}
+
+bool HmacSha256::equal(const void* a, const void* b, size_t size) noexcept
+{
+    const volatile uint8_t* left = static_cast<const uint8_t*>(a);
+    const volatile uint8_t* right = static_cast<const uint8_t*>(b);
+    uint8_t difference = 0;
+    for (size_t i = 0; i < size; i++)
+        difference |= left[i] ^ right[i];
+    return difference == 0;
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <boost/utility/string_ref.hpp>
+
+namespace Wizrd {
+
+/// SHA-256 (FIPS 180-4) of data given in any number of pieces, nothing is
+/// allocated
+class Sha256 {
+public:
+    static const size_t DigestSize = 32;
+    static const size_t BlockSize = 64;
+    typedef std::array<uint8_t, DigestSize> Digest;
+
+    Sha256() noexcept;
+    void update(const void* data, size_t size) noexcept;
+    inline void update(boost::string_ref data) noexcept { update(data.data(), data.size()); }
+    Digest finish() noexcept;
+
+private:
+    void compress(const uint8_t* block) noexcept;
+
+    uint32_t state_[8];
+    uint8_t block_[BlockSize];
+    size_t blockSize_;
+    uint64_t length_;
+};
+
+/// HMAC-SHA256 (RFC 2104) of a message given in any number of pieces
+class HmacSha256 {
+public:
+    typedef Sha256::Digest Digest;
+
+    explicit HmacSha256(boost::string_ref key) noexcept;
+    inline void update(boost::string_ref data) noexcept { inner_.update(data); }
+    Digest finish() noexcept;
+
+    static Digest digest(boost::string_ref key, boost::string_ref message) noexcept;
+    /// compares in a time independent of where a and b differ
+    static bool equal(const void* a, const void* b, size_t size) noexcept;
+
+private:
+    Sha256 inner_;
+    uint8_t outerKey_[Sha256::BlockSize];
+};
+
+}
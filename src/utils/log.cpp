@@ -0,0 +1,383 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include "log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Wizrd {
+
+namespace {
+
+// records are a 4 byte size followed by the record, 8 byte aligned. A
+// record never wraps around, the end of the ring is skipped instead
+const uint32_t SkipToStart = 0xffffffff;
+
+inline size_t aligned(size_t size) noexcept
+{
+    return (size + 7) & ~size_t(7);
+}
+
+// single producer (its thread), single consumer (whoever holds the
+// backend's mutex). head and tail only grow, positions are taken modulo
+// the size
+struct Ring
+{
+    std::unique_ptr<char[]> data{new char[Log::RingSize]};
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+    // set once its thread exits, the ring is dropped when drained
+    std::atomic<bool> closed{false};
+    // the record being written, producer only
+    size_t reserved = 0;
+    size_t reservedSize = 0;
+};
+
+const char* const levelNames[] = {"trace", "debug", "info", "warning", "error", "fatal"};
+
+void writeStderr(LogLevel, boost::string_ref line)
+{
+    std::string text(line.data(), line.size());
+    text += '\n';
+    std::fwrite(text.data(), 1, text.size(), stderr);
+}
+
+template <class T>
+inline const char* get(const char* in, T& value) noexcept
+{
+    std::memcpy(&value, in, sizeof(value));
+    return in + sizeof(value);
+}
+
+}
+
+// formats the records of every ring, on a thread of its own
+class LogBackend
+{
+public:
+    static LogBackend& instance()
+    {
+        // never destroyed, threads may log while the statics are torn down
+        static LogBackend* backend = new LogBackend;
+        return *backend;
+    }
+
+    Ring* add()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        rings_.push_back(std::make_unique<Ring>());
+        if (!thread_.joinable() && !stopping_)
+            thread_ = std::thread([this] { run(); });
+        return rings_.back().get();
+    }
+
+    void setSink(Log::Sink sink)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sink_ = sink ? std::move(sink) : Log::Sink(writeStderr);
+    }
+
+    void flush()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        drain();
+    }
+
+    // writes what is left and stops the thread, later records are written
+    // by flush() only
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_one();
+        if (thread_.joinable())
+            thread_.join();
+        flush();
+    }
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> accessLog{false};
+
+private:
+    LogBackend() : sink_(writeStderr) {}
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            // polled, a producer never has to wake the thread up
+            if (!drain())
+                wake_.wait_for(lock, std::chrono::milliseconds(5));
+        }
+    }
+
+    // formats every record available, returns whether there was any
+    bool drain()
+    {
+        bool any = false;
+        for (size_t i = 0; i < rings_.size();) {
+            Ring& ring = *rings_[i];
+            const bool closed = ring.closed.load(std::memory_order_acquire);
+            size_t tail = ring.tail.load(std::memory_order_relaxed);
+            const size_t head = ring.head.load(std::memory_order_acquire);
+            any = any || tail != head;
+            while (tail != head) {
+                const size_t position = tail % Log::RingSize;
+                uint32_t size;
+                get(ring.data.get() + position, size);
+                if (size == SkipToStart) {
+                    tail += Log::RingSize - position;
+                    continue;
+                }
+                format(ring.data.get() + position + sizeof(size));
+                tail += aligned(sizeof(size) + size);
+            }
+            ring.tail.store(tail, std::memory_order_release);
+            if (closed)
+                rings_.erase(rings_.begin() + i);
+            else
+                i++;
+        }
+        return any;
+    }
+
+    void format(const char* in)
+    {
+        uint8_t level, arguments;
+        const char* format;
+        int64_t timestamp;
+        in = get(in, level);
+        in = get(in, arguments);
+        in = get(in, format);
+        in = get(in, timestamp);
+
+        line_.clear();
+        const std::time_t seconds = timestamp / 1000000000;
+        std::tm utc;
+        gmtime_r(&seconds, &utc);
+        char prefix[64];
+        const size_t length = std::strftime(prefix, sizeof(prefix), "%Y-%m-%dT%H:%M:%S", &utc);
+        line_.append(prefix, length);
+        const int size = std::snprintf(prefix, sizeof(prefix), ".%06dZ [%s] ",
+                                       static_cast<int>(timestamp % 1000000000 / 1000),
+                                       levelNames[level]);
+        line_.append(prefix, size);
+
+        for (const char* chr = format; *chr; chr++) {
+            if (chr[0] == '{' && chr[1] == '}' && arguments) {
+                in = append(in);
+                arguments--;
+                chr++;
+            }
+            else {
+                line_ += *chr;
+            }
+        }
+        sink_(static_cast<LogLevel>(level), line_);
+    }
+
+    const char* append(const char* in)
+    {
+        Log::Type type;
+        in = get(in, type);
+        char number[32];
+        int size = 0;
+        switch (type) {
+        case Log::Bool: {
+            char value;
+            in = get(in, value);
+            line_ += value ? "true" : "false";
+            break;
+        }
+        case Log::Char: {
+            char value;
+            in = get(in, value);
+            line_ += value;
+            break;
+        }
+        case Log::Int: {
+            int64_t value;
+            in = get(in, value);
+            size = std::snprintf(number, sizeof(number), "%lld", static_cast<long long>(value));
+            break;
+        }
+        case Log::UInt: {
+            uint64_t value;
+            in = get(in, value);
+            size = std::snprintf(number, sizeof(number), "%llu", static_cast<unsigned long long>(value));
+            break;
+        }
+        case Log::Double: {
+            double value;
+            in = get(in, value);
+            size = std::snprintf(number, sizeof(number), "%g", value);
+            break;
+        }
+        case Log::Text: {
+            uint32_t length;
+            in = get(in, length);
+            line_.append(in, length);
+            in += length;
+            break;
+        }
+        }
+        line_.append(number, size);
+        return in;
+    }
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    Log::Sink sink_;
+    std::string line_;
+    std::thread thread_;
+    bool stopping_ = false;
+};
+
+namespace {
+
+// the ring of the thread, plain thread locals so that they stay usable
+// from the destructors of the other ones
+thread_local Ring* localRing = nullptr;
+thread_local bool exited = false;
+
+// the backend frees a closed ring once drained
+void closeLocalRing() noexcept
+{
+    if (localRing)
+        localRing->closed.store(true, std::memory_order_release);
+    localRing = nullptr;
+}
+
+// closes the ring of the thread when it exits
+struct RingCloser
+{
+    ~RingCloser()
+    {
+        closeLocalRing();
+        exited = true;
+    }
+};
+
+// writes what is left in the rings at exit
+struct Shutdown
+{
+    ~Shutdown() { LogBackend::instance().stop(); }
+} shutdown;
+
+}
+
+std::atomic<LogLevel> Log::level_{LogLevel::Trace};
+
+void Log::setSink(Sink sink)
+{
+    LogBackend::instance().setSink(std::move(sink));
+}
+
+void Log::flush()
+{
+    LogBackend::instance().flush();
+}
+
+uint64_t Log::dropped() noexcept
+{
+    return LogBackend::instance().dropped.load(std::memory_order_relaxed);
+}
+
+bool Log::accessLog() noexcept
+{
+    return LogBackend::instance().accessLog.load(std::memory_order_relaxed);
+}
+
+void Log::setAccessLog(bool enabled) noexcept
+{
+    LogBackend::instance().accessLog.store(enabled, std::memory_order_relaxed);
+}
+
+char* Log::reserve(size_t size) noexcept
+{
+    Ring* ring = localRing;
+    if (!ring) {
+        try {
+            ring = localRing = LogBackend::instance().add();
+        }
+        catch (...) {
+            return nullptr;
+        }
+        // what is logged by the destructors of other thread locals, after
+        // the ring was closed, goes to a ring closed by commit()
+        if (!exited) {
+            thread_local RingCloser closer;
+            (void)closer;
+        }
+    }
+    const size_t total = aligned(sizeof(uint32_t) + size);
+    const size_t head = ring->head.load(std::memory_order_relaxed);
+    const size_t position = head % RingSize;
+    // the end of the ring is skipped when the record does not fit before it
+    const size_t skip = RingSize - position < total ? RingSize - position : 0;
+    if (total > RingSize / 2 ||
+        head + skip + total - ring->tail.load(std::memory_order_acquire) > RingSize) {
+        LogBackend::instance().dropped.fetch_add(1, std::memory_order_relaxed);
+        if (exited)
+            closeLocalRing();
+        return nullptr;
+    }
+    if (skip)
+        std::memcpy(ring->data.get() + position, &SkipToStart, sizeof(SkipToStart));
+    ring->reserved = head + skip;
+    ring->reservedSize = total;
+    char* record = ring->data.get() + ring->reserved % RingSize;
+    const auto recordSize = static_cast<uint32_t>(size);
+    std::memcpy(record, &recordSize, sizeof(recordSize));
+    return record + sizeof(recordSize);
+}
+
+void Log::commit() noexcept
+{
+    Ring* ring = localRing;
+    ring->head.store(ring->reserved + ring->reservedSize, std::memory_order_release);
+    if (exited)
+        closeLocalRing();
+}
+
+int64_t Log::timestamp() noexcept
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <boost/utility/string_ref.hpp>
+#include "wizrd_config.h"
+
+// lowest level compiled in, set with -DWIZRD_LOG_LEVEL=<name>
+#ifndef WIZRD_LOG_MIN_LEVEL
+#define WIZRD_LOG_MIN_LEVEL 0
+#endif
+
+namespace Wizrd {
+
+enum class LogLevel : uint8_t {
+    Trace,
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Fatal
+};
+
+/// asynchronous log. A call copies its format and arguments as they are
+/// into a ring of the calling thread, a background thread turns them into
+/// text and hands the lines to the sink, so logging never waits on I/O or
+/// on another thread. A record that does not fit in the ring is dropped.
+/// Use WIZRD_LOG, which also compiles calls below WIZRD_LOG_MIN_LEVEL away
+class Log
+{
+public:
+    /// receives each line, without the new line, on the background thread
+    typedef std::function<void(LogLevel level, boost::string_ref line)> Sink;
+
+    /// bytes of the ring of each thread
+    static const size_t RingSize = 1 << 16;
+
+    /// everything compiled in is written by default
+    static inline bool enabled(LogLevel level) noexcept
+    {
+        return level >= level_.load(std::memory_order_relaxed);
+    }
+    static inline void setLevel(LogLevel level) noexcept
+    {
+        level_.store(level, std::memory_order_relaxed);
+    }
+
+    /// lines go to stderr by default
+    static void setSink(Sink sink);
+    /// returns once every record logged before the call is written
+    static void flush();
+    /// records dropped so far because a ring was full
+    static uint64_t dropped() noexcept;
+
+    /// whether the HTTP connections log a line per response, at info
+    /// level. Off by default
+    static bool accessLog() noexcept;
+    static void setAccessLog(bool enabled) noexcept;
+
+    /// format is kept as a pointer, it has to be a literal. Each "{}" in it
+    /// is replaced by the next argument: a number, a char, a bool or text
+    template <class... Args>
+    static void write(LogLevel level, const char* format, const Args&... args) noexcept
+    {
+        const size_t size = HeaderSize + (0 + ... + encodedSize(args));
+        char* out = reserve(size);
+        if (!out)
+            return;
+        out = put(out, static_cast<uint8_t>(level));
+        out = put(out, static_cast<uint8_t>(sizeof...(Args)));
+        out = put(out, format);
+        out = put(out, timestamp());
+        ((out = encode(out, args)), ...);
+        commit();
+    }
+
+private:
+    friend class LogBackend;
+
+    enum Type : uint8_t { Bool, Char, Int, UInt, Double, Text };
+
+    static const size_t HeaderSize = 2 + sizeof(const char*) + sizeof(int64_t);
+
+    template <class T>
+    static constexpr Type typeOf() noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            return Bool;
+        else if constexpr (std::is_same_v<T, char>)
+            return Char;
+        else if constexpr (std::is_enum_v<T>)
+            return std::is_signed_v<std::underlying_type_t<T>> ? Int : UInt;
+        else if constexpr (std::is_integral_v<T>)
+            return std::is_signed_v<T> ? Int : UInt;
+        else if constexpr (std::is_floating_point_v<T>)
+            return Double;
+        else {
+            static_assert(std::is_same_v<T, boost::string_ref> ||
+                          std::is_convertible_v<const T&, std::string_view>,
+                          "log arguments are numbers, chars, bools or text");
+            return Text;
+        }
+    }
+
+    template <class T>
+    static inline std::string_view text(const T& value) noexcept
+    {
+        if constexpr (std::is_same_v<T, boost::string_ref>)
+            return std::string_view(value.data(), value.size());
+        else
+            return std::string_view(value);
+    }
+
+    template <class T>
+    static inline size_t encodedSize(const T& value) noexcept
+    {
+        constexpr Type type = typeOf<T>();
+        if constexpr (type == Bool || type == Char)
+            return 2;
+        else if constexpr (type == Text)
+            return 1 + sizeof(uint32_t) + text(value).size();
+        else
+            return 1 + 8;
+    }
+
+    template <class T>
+    static inline char* put(char* out, const T& value) noexcept
+    {
+        std::memcpy(out, &value, sizeof(value));
+        return out + sizeof(value);
+    }
+
+    template <class T>
+    static inline char* encode(char* out, const T& value) noexcept
+    {
+        constexpr Type type = typeOf<T>();
+        out = put(out, type);
+        if constexpr (type == Bool || type == Char)
+            return put(out, static_cast<char>(value));
+        else if constexpr (type == Int)
+            return put(out, static_cast<int64_t>(value));
+        else if constexpr (type == UInt)
+            return put(out, static_cast<uint64_t>(value));
+        else if constexpr (type == Double)
+            return put(out, static_cast<double>(value));
+        else {
+            const std::string_view view = text(value);
+            out = put(out, static_cast<uint32_t>(view.size()));
+            std::memcpy(out, view.data(), view.size());
+            return out + view.size();
+        }
+    }
+
+    // room for a record of size bytes in the ring of the thread, null if
+    // it is full; commit() publishes it
+    static char* reserve(size_t size) noexcept;
+    static void commit() noexcept;
+    // nanoseconds since the epoch
+    static int64_t timestamp() noexcept;
+
+    static std::atomic<LogLevel> level_;
+};
+
+}
+
+/// logs at level (Trace, Debug, Info, Warning, Error or Fatal) unless it is
+/// below WIZRD_LOG_MIN_LEVEL, in which case nothing is compiled, arguments
+/// included, or below Log::setLevel
+#define WIZRD_LOG(level, format, ...) \
+    do { \
+        if constexpr (::Wizrd::LogLevel::level >= static_cast<::Wizrd::LogLevel>(WIZRD_LOG_MIN_LEVEL)) { \
+            if (::Wizrd::Log::enabled(::Wizrd::LogLevel::level)) \
+                ::Wizrd::Log::write(::Wizrd::LogLevel::level, "" format __VA_OPT__(,) __VA_ARGS__); \
+        } \
+    } while (false)
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "parammap.h"
+#include <functional>
+#include <string_view>
+
+namespace Wizrd {
+
+namespace {
+
+inline size_t hashOf(boost::string_ref name) noexcept
+{
+    return std::hash<std::string_view>()(std::string_view(name.data(), name.size()));
+}
+
+}
+
+ParamMap::ParamMap(std::initializer_list<value_type> items)
+{
+    reserve(items.size());
+    for (const value_type& item: items)
+        add(item.first, item.second);
+}
+
+void ParamMap::add(std::string name, std::string value)
+{
+    const size_t hash = hashOf(name);
+    const uint32_t head = first(name, hash);
+    const auto item = static_cast<uint32_t>(items_.size());
+    items_.emplace_back(std::move(name), std::move(value));
+    links_.push_back(Link{hash, None, None});
+    if (head != None) {
+        links_[links_[head].last].next = item;
+        links_[head].last = item;
+        return;
+    }
+
+    links_[item].last = item;
+    names_++;
+    if (!slots_.empty() && names_ * 2 <= slots_.size())
+        index(item);
+    else if (names_ > IndexedNames)
+        rehash(slots_.empty() ? 32 : slots_.size() * 2);
+}
+
+void ParamMap::reserve(size_t size)
+{
+    items_.reserve(size);
+    links_.reserve(size);
+}
+
+void ParamMap::clear() noexcept
+{
+    items_.clear();
+    links_.clear();
+    slots_.clear();
+    names_ = 0;
+}
+
+const std::string* ParamMap::find(boost::string_ref name) const noexcept
+{
+    const uint32_t item = first(name, hashOf(name));
+    return item != None ? &items_[item].second : nullptr;
+}
+
+ParamMap::Values ParamMap::all(boost::string_ref name) const noexcept
+{
+    return Values(this, first(name, hashOf(name)));
+}
+
+size_t ParamMap::count(boost::string_ref name) const noexcept
+{
+    size_t count = 0;
+    for (uint32_t item = first(name, hashOf(name)); item != None; item = links_[item].next)
+        count++;
+    return count;
+}
+
+uint32_t ParamMap::first(boost::string_ref name, size_t hash) const noexcept
+{
+    if (slots_.empty()) {
+        for (size_t item = 0; item < items_.size(); item++) {
+            if (links_[item].hash == hash && items_[item].first == name)
+                return static_cast<uint32_t>(item);
+        }
+        return None;
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = hash & mask; slots_[slot]; slot = (slot + 1) & mask) {
+        const uint32_t item = slots_[slot] - 1;
+        if (links_[item].hash == hash && items_[item].first == name)
+            return item;
+    }
+    return None;
+}
+
+void ParamMap::index(uint32_t item) noexcept
+{
+    const size_t mask = slots_.size() - 1;
+    size_t slot = links_[item].hash & mask;
+    while (slots_[slot])
+        slot = (slot + 1) & mask;
+    slots_[slot] = item + 1;
+}
+
+void ParamMap::rehash(size_t slots)
+{
+    slots_.assign(slots, 0);
+    for (size_t item = 0; item < items_.size(); item++) {
+        // only the first item of a name has its last one set
+        if (links_[item].last != None)
+            index(static_cast<uint32_t>(item));
+    }
+}
+
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+#include <boost/utility/string_ref.hpp>
+
+namespace Wizrd {
+
+/// insertion ordered multimap of parameters kept in one vector, repeated
+/// names (?id=1&id=2) keep every value. Past a few names, an open
+/// addressing index finds the first value of a name and the values of a
+/// name are linked to each other, so that lookups do not walk the vector
+class ParamMap
+{
+public:
+    using value_type = std::pair<std::string, std::string>;
+    using const_iterator = std::vector<value_type>::const_iterator;
+    using iterator = const_iterator;
+
+    /// values of one name, in order
+    class Values
+    {
+    public:
+        class iterator
+        {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::string;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const std::string*;
+            using reference = const std::string&;
+
+            inline iterator(const ParamMap* map, uint32_t index) noexcept : map_(map), index_(index) {}
+            inline reference operator*() const noexcept { return map_->items_[index_].second; }
+            inline pointer operator->() const noexcept { return &map_->items_[index_].second; }
+            inline iterator& operator++() noexcept
+            {
+                index_ = map_->links_[index_].next;
+                return *this;
+            }
+            inline bool operator==(const iterator& other) const noexcept { return index_ == other.index_; }
+            inline bool operator!=(const iterator& other) const noexcept { return index_ != other.index_; }
+
+        private:
+            const ParamMap* map_;
+            uint32_t index_;
+        };
+
+        inline iterator begin() const noexcept { return iterator(map_, first_); }
+        inline iterator end() const noexcept { return iterator(map_, None); }
+        inline bool empty() const noexcept { return first_ == None; }
+
+    private:
+        friend class ParamMap;
+        inline Values(const ParamMap* map, uint32_t first) noexcept : map_(map), first_(first) {}
+
+        const ParamMap* map_;
+        uint32_t first_;
+    };
+
+    ParamMap() = default;
+    ParamMap(std::initializer_list<value_type> items);
+
+    /// appends a value for name, after the ones it already has
+    void add(std::string name, std::string value);
+    void reserve(size_t size);
+    void clear() noexcept;
+
+    inline size_t size() const noexcept { return items_.size(); }
+    inline bool empty() const noexcept { return items_.empty(); }
+    inline const_iterator begin() const noexcept { return items_.begin(); }
+    inline const_iterator end() const noexcept { return items_.end(); }
+
+    /// first value of name, nullptr if there is none
+    const std::string* find(boost::string_ref name) const noexcept;
+    inline bool contains(boost::string_ref name) const noexcept { return find(name) != nullptr; }
+    /// first value of name, empty if there is none
+    inline boost::string_ref get(boost::string_ref name) const noexcept
+    {
+        const std::string* value = find(name);
+        return value ? boost::string_ref(*value) : boost::string_ref();
+    }
+    /// every value of name, in order, nothing is allocated
+    Values all(boost::string_ref name) const noexcept;
+    size_t count(boost::string_ref name) const noexcept;
+
+    /// same items in the same order
+    inline bool operator==(const ParamMap& other) const { return items_ == other.items_; }
+    inline bool operator!=(const ParamMap& other) const { return items_ != other.items_; }
+
+private:
+    static const uint32_t None = ~uint32_t(0);
+    // below this many names a linear search is faster than hashing
+    static const size_t IndexedNames = 8;
+
+    struct Link {
+        size_t hash;
+        // next value of the same name
+        uint32_t next;
+        // last value of the name, set on its first item only
+        uint32_t last;
+    };
+
+    uint32_t first(boost::string_ref name, size_t hash) const noexcept;
+    void index(uint32_t item) noexcept;
+    void rehash(size_t slots);
+
+    std::vector<value_type> items_;
+    std::vector<Link> links_;
+    // first item of each name (plus one, zero for an empty slot), sized to
+    // a power of two, empty while there are few names
+    std::vector<uint32_t> slots_;
+    size_t names_ = 0;
+};
+
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "query.h"
+#include "url.h"
+
+namespace Wizrd {
+
+boost::string_ref QueryParameter::name(std::string& scratch) const
+{
+    return unquoted(name_, nameQuoted_, scratch);
+}
+
+boost::string_ref QueryParameter::value(std::string& scratch) const
+{
+    return unquoted(value_, valueQuoted_, scratch);
+}
+
+std::string QueryParameter::name() const
+{
+    return nameQuoted_ ? URL::unquotePlus(name_) : name_.to_string();
+}
+
+std::string QueryParameter::value() const
+{
+    return valueQuoted_ ? URL::unquotePlus(value_) : value_.to_string();
+}
+
+boost::string_ref QueryParameter::unquoted(boost::string_ref raw, bool quoted, std::string& scratch)
+{
+    if (!quoted)
+        return raw;
+    scratch.resize(raw.size());
+    scratch.resize(URL::unquoteInto(raw, &scratch[0], true));
+    return scratch;
+}
+
+bool QueryParameter::unquotedEquals(boost::string_ref raw, boost::string_ref text) noexcept
+{
+    return URL::unquotedEquals(raw, text, true);
+}
+
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <boost/utility/string_ref.hpp>
+
+namespace Wizrd {
+
+/// name=value pair of a query string, as views into it. Name and value
+/// are kept quoted and unquoted (with '+' as a space) on demand, which
+/// only allocates when they do contain an escape
+class QueryParameter
+{
+public:
+    inline boost::string_ref rawName() const noexcept { return name_; }
+    inline boost::string_ref rawValue() const noexcept { return value_; }
+    /// false for a lone name, without '='
+    inline bool hasValue() const noexcept { return hasValue_; }
+
+    /// name unquoted: a view into the query string when there is nothing to
+    /// unquote, into scratch otherwise
+    boost::string_ref name(std::string& scratch) const;
+    boost::string_ref value(std::string& scratch) const;
+    std::string name() const;
+    std::string value() const;
+
+    /// whether the unquoted name is name, nothing is allocated
+    inline bool is(boost::string_ref name) const noexcept
+    {
+        return nameQuoted_ ? unquotedEquals(name_, name) : name_ == name;
+    }
+
+private:
+    friend class QueryString;
+
+    static boost::string_ref unquoted(boost::string_ref raw, bool quoted, std::string& scratch);
+    static bool unquotedEquals(boost::string_ref raw, boost::string_ref text) noexcept;
+
+    boost::string_ref name_;
+    boost::string_ref value_;
+    bool hasValue_ = false;
+    bool nameQuoted_ = false;
+    bool valueQuoted_ = false;
+};
+
+/// query string (without the '?') split lazily into QueryParameters, one
+/// per '&' separated part, empty parts are skipped. Nothing is allocated,
+/// looking a name up stops at the first parameter called so
+class QueryString
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = QueryParameter;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const QueryParameter*;
+        using reference = const QueryParameter&;
+
+        iterator() = default;
+
+        inline reference operator*() const noexcept { return parameter_; }
+        inline pointer operator->() const noexcept { return &parameter_; }
+        inline iterator& operator++() noexcept
+        {
+            next();
+            return *this;
+        }
+        inline iterator operator++(int) noexcept
+        {
+            iterator previous = *this;
+            next();
+            return previous;
+        }
+        inline bool operator==(const iterator& other) const noexcept { return position_ == other.position_; }
+        inline bool operator!=(const iterator& other) const noexcept { return position_ != other.position_; }
+
+    private:
+        friend class QueryString;
+
+        inline iterator(boost::string_ref query, size_t position) noexcept
+            : query_(query), position_(position), next_(position)
+        {
+            next();
+        }
+
+        // splits the next non empty part in a single pass over its chars
+        inline void next() noexcept
+        {
+            const char* data = query_.data();
+            const size_t size = query_.size();
+            while (next_ < size && data[next_] == '&')
+                next_++;
+            position_ = next_;
+            if (position_ >= size) {
+                position_ = next_ = boost::string_ref::npos;
+                return;
+            }
+            size_t equals = boost::string_ref::npos;
+            bool quoted[2] = {false, false};
+            for (; next_ < size && data[next_] != '&'; next_++) {
+                const char c = data[next_];
+                if (c == '=' && equals == boost::string_ref::npos)
+                    equals = next_;
+                else if (c == '%' || c == '+')
+                    quoted[equals != boost::string_ref::npos] = true;
+            }
+            parameter_.hasValue_ = equals != boost::string_ref::npos;
+            const size_t nameEnd = parameter_.hasValue_ ? equals : next_;
+            parameter_.name_ = query_.substr(position_, nameEnd - position_);
+            parameter_.value_ = parameter_.hasValue_ ? query_.substr(equals + 1, next_ - equals - 1)
+                                                     : boost::string_ref();
+            parameter_.nameQuoted_ = quoted[0];
+            parameter_.valueQuoted_ = quoted[1];
+        }
+
+        boost::string_ref query_;
+        // offset of the current part, npos at the end
+        size_t position_ = boost::string_ref::npos;
+        size_t next_ = boost::string_ref::npos;
+        QueryParameter parameter_;
+    };
+    using const_iterator = iterator;
+
+    QueryString() = default;
+    inline explicit QueryString(boost::string_ref query) noexcept : query_(query) {}
+
+    inline boost::string_ref raw() const noexcept { return query_; }
+    inline bool empty() const noexcept { return begin() == end(); }
+    inline iterator begin() const noexcept { return iterator(query_, 0); }
+    inline iterator end() const noexcept { return iterator(); }
+
+    /// first parameter called name (unquoted), end() if there is none
+    inline iterator find(boost::string_ref name) const noexcept
+    {
+        iterator it = begin();
+        while (it != end() && !it->is(name))
+            ++it;
+        return it;
+    }
+    inline bool contains(boost::string_ref name) const noexcept { return find(name) != end(); }
+    /// unquoted value of the first parameter called name, empty if there is
+    /// none: a view into the query string, or into scratch if it had escapes
+    inline boost::string_ref get(boost::string_ref name, std::string& scratch) const
+    {
+        const iterator found = find(name);
+        return found != end() ? found->value(scratch) : boost::string_ref();
+    }
+
+private:
+    boost::string_ref query_;
+};
+
+}
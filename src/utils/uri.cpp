@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include "uri.h"
+#include <cstring>
+#include "url.h"
+
+namespace Wizrd {
+
+namespace {
+
+inline bool isSchemeChar(char c) noexcept
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+           c == '+' || c == '-' || c == '.';
+}
+
+inline int hexValue(char c) noexcept
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+constexpr URLSafeChars unreserved = URLSafeChars::unreserved();
+
+}
+
+bool RequestTarget::parse(boost::string_ref target, RequestTarget& parts) noexcept
+{
+    parts = RequestTarget();
+    const size_t size = target.size();
+    if (target.empty())
+        return false;
+    if (target == "*") {
+        parts.form = Asterisk;
+        return true;
+    }
+
+    size_t i = 0;
+    if (target[0] != '/') {
+        while (i < size && isSchemeChar(target[i]))
+            i++;
+        const bool scheme = i > 0 && i + 2 < size && target[i] == ':' &&
+                            target[i + 1] == '/' && target[i + 2] == '/';
+        if (!scheme) {
+            // host:port and nothing else
+            if (target.find_first_of("/?#") != boost::string_ref::npos)
+                return false;
+            parts.form = Authority;
+            parts.authority = target;
+            return true;
+        }
+        parts.form = Absolute;
+        parts.scheme = target.substr(0, i);
+        const size_t start = i + 3;
+        for (i = start; i < size && target[i] != '/' && target[i] != '?' && target[i] != '#'; i++)
+            ;
+        if (i == start)
+            return false;
+        parts.authority = target.substr(start, i - start);
+    }
+
+    const size_t pathStart = i;
+    while (i < size && target[i] != '?' && target[i] != '#')
+        i++;
+    parts.path = target.substr(pathStart, i - pathStart);
+    if (i < size && target[i] == '?') {
+        const size_t queryStart = ++i;
+        while (i < size && target[i] != '#')
+            i++;
+        parts.hasQuery = true;
+        parts.query = target.substr(queryStart, i - queryStart);
+    }
+    if (i < size) {
+        parts.hasFragment = true;
+        parts.fragment = target.substr(i + 1);
+    }
+    return true;
+}
+
+size_t normalizePath(char* path, size_t size) noexcept
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    if (size == 0 || path[0] != '/')
+        return size;
+
+    // the output never outgrows the input, so it is written over the
+    // chars already read: w <= r all along
+    size_t r = 0, w = 0;
+    while (r < size) {
+        // path[r] is a '/', those following it are merged into it
+        while (r < size && path[r] == '/')
+            r++;
+        path[w++] = '/';
+        const size_t segment = w;
+        while (r < size && path[r] != '/') {
+            const char c = path[r];
+            const int high = c == '%' && r + 2 < size ? hexValue(path[r + 1]) : -1;
+            const int low = high >= 0 ? hexValue(path[r + 2]) : -1;
+            if (low < 0) {
+                path[w++] = c;
+                r++;
+                continue;
+            }
+            const char decoded = static_cast<char>((high << 4) | low);
+            if (unreserved.contains(decoded)) {
+                path[w++] = decoded;
+            }
+            else {
+                path[w++] = '%';
+                path[w++] = hexDigits[high];
+                path[w++] = hexDigits[low];
+            }
+            r += 3;
+        }
+
+        const size_t length = w - segment;
+        const bool last = r == size;
+        if (length == 1 && path[segment] == '.') {
+            // "/a/./b" -> "/a/b", "/a/." -> "/a/"
+            w = last ? segment : segment - 1;
+        }
+        else if (length == 2 && path[segment] == '.' && path[segment + 1] == '.') {
+            // "/a/b/../c" -> "/a/c", back to the slash before "b"
+            w = segment - 1;
+            while (w > 0 && path[w - 1] != '/')
+                w--;
+            w = w > 0 ? w - 1 : 0;
+            if (last)
+                path[w++] = '/';
+        }
+    }
+    return w;
+}
+
+size_t canonicalTarget(char* target, const RequestTarget& parts) noexcept
+{
+    if (parts.form == RequestTarget::Asterisk)
+        return 1;
+    if (parts.form == RequestTarget::Authority)
+        return parts.authority.size();
+
+    size_t size;
+    if (parts.path.empty()) {
+        // the empty path of an absolute-form target is "/", which fits in
+        // place of its "://"
+        target[0] = '/';
+        size = 1;
+    }
+    else {
+        std::memmove(target, parts.path.data(), parts.path.size());
+        size = normalizePath(target, parts.path.size());
+    }
+    if (parts.hasQuery) {
+        target[size++] = '?';
+        std::memmove(target + size, parts.query.data(), parts.query.size());
+        size += parts.query.size();
+    }
+    return size;
+}
+
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+#include <cstddef>
+#include <boost/utility/string_ref.hpp>
+
+namespace Wizrd {
+
+/// request target (RFC 7230 section 5.3) split into views of its parts,
+/// query and fragment without their '?' and '#'
+struct RequestTarget
+{
+    enum Form {
+        /// /path?query
+        Origin,
+        /// scheme://authority/path?query, sent to proxies
+        Absolute,
+        /// host:port, for CONNECT
+        Authority,
+        /// *, for a server wide OPTIONS
+        Asterisk
+    } form = Origin;
+    boost::string_ref scheme;
+    boost::string_ref authority;
+    boost::string_ref path;
+    boost::string_ref query;
+    boost::string_ref fragment;
+    bool hasQuery = false;
+    bool hasFragment = false;
+
+    /// splits target in a single pass over it, returns false if it fits
+    /// none of the forms
+    static bool parse(boost::string_ref target, RequestTarget& parts) noexcept;
+};
+
+/// normalizes the path of size chars at path in place (RFC 3986 section
+/// 6.2.2) and returns its new size: escapes of unreserved chars are decoded
+/// and the hex digits of the other ones uppercased, runs of slashes are
+/// merged and "." and ".." segments removed, never above the root
+size_t normalizePath(char* path, size_t size) noexcept;
+
+/// rewrites the target parts were parsed from, starting at target, in
+/// place into the key the router and the response cache use: the origin
+/// form with its path normalized, without fragment. Authority and asterisk
+/// forms are kept as they are. Returns the new size
+size_t canonicalTarget(char* target, const RequestTarget& parts) noexcept;
+
+}
@@ -25,17 +25,198 @@
  */
 
 #include "url.h"
+#include "query.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
-#include <sstream>
 #include <string>
 #include <boost/algorithm/string.hpp>
-#include <boost/log/trivial.hpp>
+#include <boost/config.hpp>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define URL_X86 1
+#endif
 
 namespace Wizrd {
 
+namespace {
 
+constexpr URLSafeChars defaultSafe = URLSafeChars::quoteDefault();
 
-std::string URL::encode(const Wizrd::params data) throw(URLEncodeError)
+// "%XX" for every byte
+constexpr std::array<std::array<char, 3>, 256> escapes = [] {
+    constexpr char hexDigits[] = "0123456789ABCDEF";
+    std::array<std::array<char, 3>, 256> values{};
+    for (int i = 0; i < 256; i++)
+        values[i] = {'%', hexDigits[i >> 4], hexDigits[i & 15]};
+    return values;
+}();
+
+// value of a hex digit, -1 for anything else
+constexpr std::array<int8_t, 256> hexValues = [] {
+    std::array<int8_t, 256> values{};
+    for (auto& value: values)
+        value = -1;
+    for (int i = 0; i < 10; i++)
+        values['0' + i] = i;
+    for (int i = 0; i < 6; i++)
+        values['A' + i] = values['a' + i] = 10 + i;
+    return values;
+}();
+
+// a scanner flags the chars of a 64 bytes block that need work, bit i of
+// the mask stands for block[i]: '%' (and '+' for the plus variant) when
+// unquoting, the chars outside of the safe set when quoting. The quoting
+// one only knows the ASCII part of the set, from its rows (see
+// URLSafeChars::add), and flags every byte from 0x80
+struct Scanners
+{
+    uint64_t (*unsafe)(const char* block, const uint8_t* rows);
+    uint64_t (*escapes)(const char* block, bool plus);
+};
+
+uint64_t unsafeScalar(const char* block, const uint8_t* rows)
+{
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i++) {
+        const auto u = static_cast<uint8_t>(block[i]);
+        mask |= static_cast<uint64_t>(!((rows[u & 15] >> (u >> 4)) & 1)) << i;
+    }
+    return mask;
+}
+
+uint64_t escapesScalar(const char* block, bool plus)
+{
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i++)
+        mask |= static_cast<uint64_t>(block[i] == '%' || (plus && block[i] == '+')) << i;
+    return mask;
+}
+
+#ifdef URL_X86
+
+__attribute__((target("ssse3")))
+uint64_t unsafeSsse3(const char* block, const uint8_t* safeRows)
+{
+    const __m128i rows = _mm_loadu_si128(reinterpret_cast<const __m128i*>(safeRows));
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 16) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        const __m128i row = _mm_shuffle_epi8(rows, _mm_and_si128(chars, nibble));
+        const __m128i bit = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(chars, 4), nibble));
+        const __m128i unsafe = _mm_cmpeq_epi8(_mm_and_si128(row, bit), _mm_setzero_si128());
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(unsafe))) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("sse2")))
+uint64_t escapesSse2(const char* block, bool plus)
+{
+    const __m128i percent = _mm_set1_epi8('%');
+    const __m128i other = _mm_set1_epi8(plus ? '+' : '%');
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 16) {
+        const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        const __m128i found = _mm_or_si128(_mm_cmpeq_epi8(chars, percent),
+                                           _mm_cmpeq_epi8(chars, other));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm_movemask_epi8(found))) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint64_t unsafeAvx2(const char* block, const uint8_t* safeRows)
+{
+    const __m256i rows = _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(safeRows)));
+    const __m256i bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+                                          1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 32) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        const __m256i row = _mm256_shuffle_epi8(rows, _mm256_and_si256(chars, nibble));
+        const __m256i bit = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(chars, 4), nibble));
+        const __m256i unsafe = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), _mm256_setzero_si256());
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(unsafe))) << i;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+uint64_t escapesAvx2(const char* block, bool plus)
+{
+    const __m256i percent = _mm256_set1_epi8('%');
+    const __m256i other = _mm256_set1_epi8(plus ? '+' : '%');
+    uint64_t mask = 0;
+    for (int i = 0; i < 64; i += 32) {
+        const __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        const __m256i found = _mm256_or_si256(_mm256_cmpeq_epi8(chars, percent),
+                                              _mm256_cmpeq_epi8(chars, other));
+        mask |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(found))) << i;
+    }
+    return mask;
+}
+
+#endif
+
+const Scanners scalarScanners{unsafeScalar, escapesScalar};
+#ifdef URL_X86
+const Scanners ssse3Scanners{unsafeSsse3, escapesSse2};
+const Scanners avx2Scanners{unsafeAvx2, escapesAvx2};
+#endif
+
+const Scanners* bestScanners() noexcept
+{
+#ifdef URL_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return &avx2Scanners;
+    if (__builtin_cpu_supports("ssse3"))
+        return &ssse3Scanners;
+#endif
+    return &scalarScanners;
+}
+
+// picked on first use, like the Base64 kernels
+std::atomic<const Scanners*> scanners{nullptr};
+
+const Scanners& activeScanners() noexcept
+{
+    const Scanners* active = scanners.load(std::memory_order_relaxed);
+    if (BOOST_UNLIKELY(!active)) {
+        active = bestScanners();
+        scanners.store(active, std::memory_order_relaxed);
+    }
+    return *active;
+}
+
+// calls function with the offset of every char of data that needs work,
+// whole blocks go through scan and the tail through flag one char at a time
+template <class Scan, class Flag, class Function>
+void forEachFlagged(const char* data, size_t size, Scan scan, Flag flag, Function function)
+{
+    size_t i = 0;
+    for (; i + 64 <= size; i += 64) {
+        for (uint64_t mask = scan(data + i); mask; mask &= mask - 1)
+            function(i + __builtin_ctzll(mask));
+    }
+    for (; i < size; i++) {
+        if (flag(data[i]))
+            function(i);
+    }
+}
+
+} // anonymous namespace
+
+
+
+std::string URL::encode(const Wizrd::params data)
 {
     std::string output;
     int size = 0;
@@ -59,9 +240,9 @@ std::string URL::encode(const Wizrd::params data) throw(URLEncodeError)
         else
             first = false;
         if (pair.size() == 1)
-            output += quotePlus(pair[0]);
+            appendQuoted(output, pair[0], defaultSafe, true);
         else if (pair.size() == 2) {
-            output += encodePair(pair[0], pair[1]);
+            appendPair(output, pair[0], pair[1]);
         }
         else {
             throw URLEncodeError("Data content item should only have 1 or 2"
@@ -72,81 +253,106 @@ std::string URL::encode(const Wizrd::params data) throw(URLEncodeError)
     return output;
 }
 
-std::string URL::encode(paramsMap data)
+std::string URL::encode(const paramsMap& data)
 {
-    int size = 0;
+    // sized exactly, the pairs are quoted straight into the output
+    size_t size = data.empty() ? 0 : data.size() * 2 - 1;
+    for (const auto& kv: data)
+        size += quotedSize(kv.first, defaultSafe, true) + quotedSize(kv.second, defaultSafe, true);
     std::string output;
-    if (!data.size()) {
-        return std::string();
-    }
-
-    for (auto& kv: data) {
-        size += kv.first.length() + kv.second.length();
-    }
-    output.reserve(size * 2);
+    output.reserve(size);
 
     bool first = true;
-
-    for(auto& kv: data) {
+    for (const auto& kv: data) {
         if (!first)
             output += '&';
         else
             first = false;
 
-        output += encodePair(kv.first, kv.second);
+        appendPair(output, kv.first, kv.second);
     }
-    output.shrink_to_fit();
     return output;
 }
 
 params URL::decode(boost::string_ref url)
 {
-    using namespace boost;
-    auto current{url.begin()};
-    int current_n = 0;
     params ret;
-
-    if (url.empty())
-        return ret;
-    size_t n = 0;
-    boost::string_ref url_fragment;
-    for (auto i: url) {
-        if (i == '&') {
-            url_fragment = url.substr(current_n, n);
-            ret.push_back(std::move(decodePair(url_fragment)));
-            current_n = (n + 1);
-        }
-        n++;
+    for (const QueryParameter& parameter: QueryString(url)) {
+        if (parameter.hasValue())
+            ret.push_back({parameter.name(), parameter.value()});
+        else
+            ret.push_back({parameter.name()});
     }
-    url_fragment = url.substr(current_n, n);
-    ret.push_back(std::move(decodePair(url_fragment)));
     return ret;
 }
 
-std::map<std::string, std::string> URL::decodeMap(boost::string_ref url)
+paramsMap URL::decodeMap(boost::string_ref url)
 {
-    params data{std::move(decode(url))};
-    std::map<std::string, std::string> output;
-
-    for(auto item: data) {
-        if (item.size() == 1) {
-            output[item[0]] = "";
-        }
-        else {
-            output[item[0]] = item[1];
-        }
-    }
+    paramsMap output;
+    for (const QueryParameter& parameter: QueryString(url))
+        output.add(parameter.name(), parameter.value());
     return output;
 }
 
 
 std::string URL::quote(boost::string_ref url, boost::string_ref safe)
 {
-    return std::move(quote_(url, safe, false));
+    return quote_(url, defaultSafe.with(std::string_view(safe.data(), safe.size())), false);
+}
+
+std::string URL::quote(boost::string_ref url, const URLSafeChars& safe)
+{
+    return quote_(url, safe, false);
 }
+
 std::string URL::quotePlus(boost::string_ref url, boost::string_ref safe)
 {
-    return std::move(quote_(url, safe, true));
+    return quote_(url, defaultSafe.with(std::string_view(safe.data(), safe.size())), true);
+}
+
+std::string URL::quotePlus(boost::string_ref url, const URLSafeChars& safe)
+{
+    return quote_(url, safe, true);
+}
+
+size_t URL::quotedSize(boost::string_ref url, const URLSafeChars& safe, bool plus) noexcept
+{
+    const Scanners& active = activeScanners();
+    const char* data = url.data();
+    size_t size = url.size();
+    forEachFlagged(data, url.size(),
+                   [&](const char* block) { return active.unsafe(block, safe.rows_.data()); },
+                   [&](char c) { return !safe.contains(c); },
+                   [&](size_t i) {
+        // safe bytes from 0x80 are flagged by the scanners too
+        if (!safe.contains(data[i]) && !(plus && data[i] == ' '))
+            size += 2;
+    });
+    return size;
+}
+
+void URL::quoteInto(boost::string_ref url, char* output, const URLSafeChars& safe, bool plus) noexcept
+{
+    const Scanners& active = activeScanners();
+    const char* data = url.data();
+    size_t copied = 0;
+    forEachFlagged(data, url.size(),
+                   [&](const char* block) { return active.unsafe(block, safe.rows_.data()); },
+                   [&](char c) { return !safe.contains(c); },
+                   [&](size_t i) {
+        if (safe.contains(data[i]))
+            return;
+        output = std::copy(data + copied, data + i, output);
+        if (plus && data[i] == ' ') {
+            *output++ = '+';
+        }
+        else {
+            const auto& escape = escapes[static_cast<uint8_t>(data[i])];
+            output = std::copy(escape.begin(), escape.end(), output);
+        }
+        copied = i + 1;
+    });
+    std::copy(data + copied, data + url.size(), output);
 }
 
 std::string URL::unquote(boost::string_ref url)
@@ -160,107 +366,88 @@ std::string URL::unquotePlus(boost::string_ref url)
 }
 
 
-// === private ===
-
-std::string URL::encodePair(boost::string_ref first, boost::string_ref second)
+size_t URL::unquoteInto(boost::string_ref url, char* output, bool plus) noexcept
 {
-    std::string out{std::move(quotePlus(first))};
-    out += '=';
-    out += quotePlus(second);
-    return out;
+    const Scanners& active = activeScanners();
+    const char* data = url.data();
+    const size_t size = url.size();
+    char* out = output;
+    size_t copied = 0;
+    // the digits of an escape are never flagged themselves, so every
+    // offset comes after the end of the previous escape
+    forEachFlagged(data, size,
+                   [&](const char* block) { return active.escapes(block, plus); },
+                   [&](char c) { return c == '%' || (plus && c == '+'); },
+                   [&](size_t i) {
+        out = std::copy(data + copied, data + i, out);
+        copied = i + 1;
+        if (data[i] == '+') {
+            *out++ = ' ';
+            return;
+        }
+        if (i + 2 < size) {
+            const int high = hexValues[static_cast<uint8_t>(data[i + 1])];
+            const int low = hexValues[static_cast<uint8_t>(data[i + 2])];
+            if ((high | low) >= 0) {
+                *out++ = static_cast<char>((high << 4) | low);
+                copied = i + 3;
+                return;
+            }
+        }
+        // a malformed escape is kept as it is
+        *out++ = '%';
+    });
+    out = std::copy(data + copied, data + size, out);
+    return out - output;
 }
 
-std::vector<std::string> URL::decodePair(boost::string_ref url)
+bool URL::unquotedEquals(boost::string_ref url, boost::string_ref text, bool plus) noexcept
 {
-    std::vector<std::string> out;
-    out.reserve(2);
-    size_t i = url.find_first_of('=');
-    if (i == EOF)
-    {
-        out.push_back(std::move(unquotePlus(url)));
-    }
-    else {
-        auto first{url.substr(0, i)};
-        auto second{url.substr(i + 1, url.size())};
-        out.push_back(unquotePlus(first));
-        out.push_back(unquotePlus(second));
+    // an escape is three chars for one, so url can't be shorter than text
+    if (url.size() < text.size())
+        return false;
+    size_t i = 0, j = 0;
+    for (; i < url.size() && j < text.size(); j++) {
+        char c = url[i++];
+        if (plus && c == '+') {
+            c = ' ';
+        }
+        else if (c == '%' && i + 1 < url.size()) {
+            const int high = hexValues[static_cast<uint8_t>(url[i])];
+            const int low = hexValues[static_cast<uint8_t>(url[i + 1])];
+            if ((high | low) >= 0) {
+                c = static_cast<char>((high << 4) | low);
+                i += 2;
+            }
+        }
+        if (c != text[j])
+            return false;
     }
-    return out;
+    return i == url.size() && j == text.size();
 }
 
 
-std::string URL::quote_(boost::string_ref url, boost::string_ref safe, bool plus)
+// === private ===
+
+void URL::appendPair(std::string& output, boost::string_ref first, boost::string_ref second)
+{
+    appendQuoted(output, first, defaultSafe, true);
+    output += '=';
+    appendQuoted(output, second, defaultSafe, true);
+}
+
+std::string URL::quote_(boost::string_ref url, const URLSafeChars& safe, bool plus)
 {
     std::string output;
-    output.reserve(url.length() * 2);
-    for(auto i: url) {
-        if(plus && i == ' ') {
-            output += '+';
-        }
-        else if (validQuoteChar(i) || ((!safe.empty()) && i == safe[0])) {
-            output += i;
-        }
-        else {
-            output += '%';
-            auto ret{std::move(quoteChar(i))};
-            output += ret[0];
-            output += ret[1];
-        }
-    }
-    output.shrink_to_fit();
+    appendQuoted(output, url, safe, plus);
     return output;
 }
 
 std::string URL::unquote_(boost::string_ref url, bool plus)
 {
-    std::string output;
-    output.reserve(url.length());
-
-    for (auto i = url.begin(); i != url.end(); i++) {
-        if (plus && (*i == '+')) {
-            output += ' ';
-        }
-        else if (*i != '%') {
-            output += *i;
-        }
-        else {
-            char out, digit1, digit2;
-            if (++i != url.end()) {
-                digit1 = *i;
-            }
-            else {
-                --i;
-                output += '%';
-                continue;
-            }
-            if (++i != url.end()) {
-                digit2 = *i;
-            }
-            else {
-                --i;
-                --i;
-                output += '%';
-                continue;
-            }
-            if (isHexDigit(digit1))
-            {
-                if(isHexDigit(digit2)) {
-                    out = (toHexNibble(digit1) << 4) | toHexNibble(digit2);
-                    output += out;
-                }
-                else {
-                    output += '%';
-                    output += digit1;
-                    i--;
-                    continue;
-                }
-            }
-            else {
-                output += '%';
-                i -= 2;
-            }
-        }
-    }
+    // unquoting never makes a string longer
+    std::string output(url.size(), '\0');
+    output.resize(unquoteInto(url, output.data(), plus));
     return output;
 }
 
@@ -25,16 +25,19 @@
  */
 
 #pragma once
+#include <array>
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <tuple>
 #include <vector>
 #include <initializer_list>
 #include <map>
-#include <iomanip>
 #include <sstream>
 #include <cstdio>
 #include <boost/utility/string_ref.hpp>
 #include "exceptions.h"
+#include "parammap.h"
 
 
 #ifndef EOF
@@ -44,7 +47,7 @@
 namespace Wizrd {
 
 typedef std::vector<std::vector<std::string>> params;
-typedef std::map<std::string, std::string> paramsMap;
+typedef ParamMap paramsMap;
 
 static const std::string empty = std::string();
 
@@ -52,55 +55,108 @@ class URLEncodeError: BaseException {
     using BaseException::BaseException;
 };
 
+/// the chars URL::quote leaves as they are, a 256 bits map so that
+/// checking a char is a single lookup. Sets are built at compile time:
+///     constexpr auto segment = URLSafeChars::unreserved().with(":@");
+class URLSafeChars
+{
+public:
+    /// the empty set
+    constexpr URLSafeChars() noexcept = default;
+    /// exactly the chars of chars
+    constexpr explicit URLSafeChars(std::string_view chars) noexcept { add(chars); }
+
+    /// this set and the chars of chars
+    constexpr URLSafeChars with(std::string_view chars) const noexcept
+    {
+        URLSafeChars set = *this;
+        set.add(chars);
+        return set;
+    }
+
+    constexpr bool contains(char c) const noexcept
+    {
+        const auto u = static_cast<uint8_t>(c);
+        return (bits_[u >> 6] >> (u & 63)) & 1;
+    }
+
+    /// letters and digits
+    static constexpr URLSafeChars alphanumeric() noexcept
+    {
+        return URLSafeChars("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789");
+    }
+    /// what quote keeps by default: letters, digits and "-_./"
+    static constexpr URLSafeChars quoteDefault() noexcept { return alphanumeric().with("-_./"); }
+    /// RFC 3986 unreserved chars, the ones a URI never needs to escape
+    static constexpr URLSafeChars unreserved() noexcept { return alphanumeric().with("-._~"); }
+    /// chars of a path segment (RFC 3986 pchar)
+    static constexpr URLSafeChars pathSegment() noexcept { return unreserved().with("!$&'()*+,;=:@"); }
+    /// chars of a whole URI reference, escapes included: quoting with it
+    /// only escapes what may not appear in a URI, such as spaces, controls
+    /// and non-ASCII bytes, which makes it fit for the Location header
+    static constexpr URLSafeChars uri() noexcept { return unreserved().with(":/?#[]@!$&'()*+,;=%"); }
+
+private:
+    friend class URL;
+
+    constexpr void add(std::string_view chars) noexcept
+    {
+        for (char c: chars) {
+            const auto u = static_cast<uint8_t>(c);
+            bits_[u >> 6] |= uint64_t(1) << (u & 63);
+            // bit h of rows_[l] stands for the ASCII char (h << 4) | l, the
+            // layout the vector code looks up 16 chars at a time with
+            if (u < 0x80)
+                rows_[u & 15] |= static_cast<uint8_t>(1u << (u >> 4));
+        }
+    }
+
+    std::array<uint64_t, 4> bits_{};
+    std::array<uint8_t, 16> rows_{};
+};
+
 class URL {
 public:
 
-    static std::string encode(const params data) throw(URLEncodeError);
-    static std::string encode(paramsMap data);
+    static std::string encode(const params data);
+    static std::string encode(const paramsMap& data);
     static params decode(boost::string_ref url);
-    static std::map<std::string, std::string> decodeMap(boost::string_ref url);
+    /// decodes every pair of the query string url, repeated names included
+    static paramsMap decodeMap(boost::string_ref url);
+    /// escapes url, leaving letters, digits, "-_./" and the chars of safe
     static std::string quote(boost::string_ref url, boost::string_ref safe = empty);
+    static std::string quote(boost::string_ref url, const URLSafeChars& safe);
+    /// like quote, with spaces replaced by '+' instead of escaped
     static std::string quotePlus(boost::string_ref url, boost::string_ref safe = empty);
+    static std::string quotePlus(boost::string_ref url, const URLSafeChars& safe);
+    /// size of url once quoted
+    static size_t quotedSize(boost::string_ref url, const URLSafeChars& safe, bool plus = false) noexcept;
+    /// quotes url into output, which must hold quotedSize(url, safe, plus) chars
+    static void quoteInto(boost::string_ref url, char* output, const URLSafeChars& safe,
+                          bool plus = false) noexcept;
+    /// appends url quoted to output, a std::string or a std::pmr::string
+    template <class String>
+    static void appendQuoted(String& output, boost::string_ref url, const URLSafeChars& safe,
+                             bool plus = false)
+    {
+        const size_t offset = output.size();
+        output.resize(offset + quotedSize(url, safe, plus));
+        quoteInto(url, &output[offset], safe, plus);
+    }
     static std::string unquote(boost::string_ref url);
     static std::string unquotePlus(boost::string_ref url);
+    /// unquotes url into output, which must hold url.size() chars, and
+    /// returns the size of the result
+    static size_t unquoteInto(boost::string_ref url, char* output, bool plus = false) noexcept;
+    /// whether url unquoted is text, without unquoting it
+    static bool unquotedEquals(boost::string_ref url, boost::string_ref text, bool plus = false) noexcept;
 
 private:
     URL() = delete;
-    static std::string encodePair(boost::string_ref first, boost::string_ref second);
-    static std::vector<std::string> decodePair(boost::string_ref url);
-    static std::string quote_(boost::string_ref url, boost::string_ref safe, bool plus);
+    static void appendPair(std::string& output, boost::string_ref first, boost::string_ref second);
+    static std::string quote_(boost::string_ref url, const URLSafeChars& safe, bool plus);
     static std::string unquote_(boost::string_ref url, bool plus);
 
-    static inline bool validQuoteChar(char value) noexcept {
-        return  ((value >= 'A' && value <= 'Z') ||
-                 (value >= 'a' && value <= 'z') ||
-                 (value >= '0' && value <= '9') ||
-                 (value == '-') || (value == '_') ||
-                 (value == '.') || (value == '/'));
-    }
-    static inline const std::string quoteChar(char c) noexcept {
-        std::ostringstream sret;
-            sret << std::hex
-                 << std::uppercase
-                 << std::setfill('0')
-                 << std::setw(2)
-                 << static_cast<int>(c);
-
-            return sret.str();
-    }
-    static inline bool isHexDigit(char c) noexcept {
-        char upperC = c & ~0x20;
-        return ((upperC >= 'A' && upperC <= 'F') ||
-                (c >= '0' && c <= '9'));
-    }
-    static inline char toHexNibble(char c) noexcept {
-        char upperC = c & ~0x20;
-        if (upperC >= 'A' && upperC <= 'F')
-            return (upperC - 'A') + 0x0A;
-        else
-            return (c - '0');
-    }
-
 };
 
 }
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include "gtest/gtest.h"
+#include "../internal_webserver/arena.h"
+#include "../internal_webserver/requestparser.h"
+
+using namespace Wizrd::Server;
+
+namespace {
+
+std::atomic<size_t> allocations(0);
+
+const std::string message = "POST /catalog/items?page=2 HTTP/1.1\r\n"
+                            "Host: shop.example.com\r\n"
+                            "User-Agent: arena_test\r\n"
+                            "Accept: application/json\r\n"
+                            "Accept-Language: en-US,en;q=0.8\r\n"
+                            "Content-Type: application/json\r\n"
+                            "Content-Length: 13\r\n"
+                            "\r\n"
+                            "{\"id\": 12345}";
+
+}
+
+void* operator new(size_t size)
+{
+    allocations++;
+    if (void* memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+TEST(arena_test, parsed_requests_do_not_allocate)
+{
+    Arena arena;
+    RequestParser parser;
+    Request request(arena.resource());
+
+    for (int i = 0; i < 3; i++) {
+        const size_t before = allocations;
+        auto result = parser.parse(request, message.data(), message.data() + message.size());
+        ASSERT_EQ(std::get<1>(result), RequestParser::Ok);
+        // the scratch buffers of the parser grow on the first request only
+        if (i > 0) {
+            EXPECT_EQ(allocations - before, 0u);
+        }
+
+        EXPECT_EQ(request.url, "/catalog/items?page=2");
+        EXPECT_EQ(request.host, "shop.example.com");
+        EXPECT_EQ(request.headers.size(), 6u);
+        EXPECT_EQ(headerValue(request.headers, "accept-language"), "en-US,en;q=0.8");
+        EXPECT_EQ(request.data, "{\"id\": 12345}");
+        EXPECT_EQ(request.arena(), arena.resource());
+
+        // handler scratch memory comes from the same arena
+        std::pmr::string scratch(request.arena());
+        scratch.assign(200, 'x');
+
+        std::destroy_at(&request);
+        arena.reset();
+        std::construct_at(&request, arena.resource());
+    }
+}
+
+TEST(arena_test, large_requests_spill_to_the_heap)
+{
+    Arena arena(256);
+    RequestParser parser;
+    Request request(arena.resource());
+    const std::string body(4096, 'b');
+    const std::string large = "PUT /blob HTTP/1.1\r\nContent-Length: 4096\r\n\r\n" + body;
+
+    for (int i = 0; i < 2; i++) {
+        auto result = parser.parse(request, large.data(), large.data() + large.size());
+        ASSERT_EQ(std::get<1>(result), RequestParser::Ok);
+        EXPECT_EQ(std::string_view(request.data), body);
+        std::destroy_at(&request);
+        arena.reset();
+        std::construct_at(&request, arena.resource());
+    }
+}
+
+TEST(arena_test, announced_lengths_are_not_reserved)
+{
+    Arena arena;
+    RequestParser parser;
+    Request request(arena.resource());
+    const std::string large = "PUT /blob HTTP/1.1\r\nContent-Length: " + std::to_string(WIZRD_MAX_BODY_SIZE) +
+                              "\r\n\r\nbody";
+    auto result = parser.parse(request, large.data(), large.data() + large.size());
+    EXPECT_EQ(std::get<1>(result), RequestParser::Processing);
+    EXPECT_LE(request.data.capacity(), Arena::initialSize);
+    EXPECT_EQ(std::string_view(request.data), "body");
+
+    RequestParser other;
+    Request tooLarge(arena.resource());
+    const std::string over = "PUT /blob HTTP/1.1\r\nContent-Length: " + std::to_string(WIZRD_MAX_BODY_SIZE + 1) +
+                             "\r\n\r\n";
+    result = other.parse(tooLarge, over.data(), over.data() + over.size());
+    EXPECT_EQ(std::get<1>(result), RequestParser::TooLarge);
+    EXPECT_TRUE(tooLarge.data.empty());
+}
+
+TEST(arena_test, query_lookups_do_not_allocate)
+{
+    Request request;
+    request.url = "/search?q=wizrd&page=2&sort=name+asc&tag=a&tag=b#results";
+    std::string scratch;
+    scratch.reserve(64);
+
+    const size_t before = allocations;
+    const auto query = request.query();
+    EXPECT_EQ(query.raw(), "q=wizrd&page=2&sort=name+asc&tag=a&tag=b");
+    EXPECT_EQ(query.get("page", scratch), "2");
+    EXPECT_EQ(query.get("sort", scratch), "name asc");
+    EXPECT_EQ(query.get("tag", scratch), "a");
+    EXPECT_FALSE(query.contains("results"));
+    EXPECT_EQ(allocations - before, 0u);
+}
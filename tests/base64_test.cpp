@@ -29,6 +29,8 @@
 #include "gmock/gmock.h"
 #include "utils/base64.h"
 #include "cstring"
+#include <algorithm>
+#include <vector>
 
 using namespace std::string_literals;
 using namespace Wizrd;
@@ -116,3 +118,207 @@ TEST(base64_decode, decode_test_with_invalid_base64)
     EXPECT_THROW(Base64::decode(data), Base64DecodeException);
 }
 
+
+namespace {
+
+std::vector<Base64::Kernel> supportedKernels()
+{
+    std::vector<Base64::Kernel> kernels;
+    const Base64::Kernel best = Base64::kernel();
+    for (auto kernel: {Base64::Kernel::Scalar, Base64::Kernel::Ssse3, Base64::Kernel::Avx2}) {
+        if (Base64::setKernel(kernel))
+            kernels.push_back(kernel);
+    }
+    Base64::setKernel(best);
+    return kernels;
+}
+
+std::string randomBytes(size_t size, unsigned seed)
+{
+    std::string bytes(size, '\0');
+    for (char& byte: bytes) {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<char>(seed >> 16);
+    }
+    return bytes;
+}
+
+}
+
+TEST(base64_kernels, kernels_agree_with_scalar)
+{
+    const Base64::Kernel best = Base64::kernel();
+    EXPECT_TRUE(Base64::setKernel(Base64::Kernel::Scalar));
+    std::vector<std::string> inputs, encoded, mime;
+    for (size_t size = 0; size < 300; size++) {
+        inputs.push_back(randomBytes(size, size));
+        encoded.push_back(Base64::encode(inputs.back()));
+        mime.push_back(Base64::encode(inputs.back(), true));
+    }
+
+    for (auto kernel: supportedKernels()) {
+        ASSERT_TRUE(Base64::setKernel(kernel));
+        for (size_t i = 0; i < inputs.size(); i++) {
+            EXPECT_EQ(Base64::encode(inputs[i]), encoded[i]) << int(kernel) << ' ' << i;
+            EXPECT_EQ(Base64::encode(inputs[i], true), mime[i]) << int(kernel) << ' ' << i;
+            EXPECT_EQ(Base64::decode(encoded[i]), inputs[i]) << int(kernel) << ' ' << i;
+            EXPECT_EQ(Base64::decode(mime[i]), inputs[i]) << int(kernel) << ' ' << i;
+        }
+        // CRLF line breaks and stray whitespace anywhere
+        std::string spaced;
+        for (size_t i = 0; i < encoded.back().size(); i++) {
+            spaced += encoded.back()[i];
+            if (i % 37 == 5)
+                spaced += "\r\n";
+        }
+        EXPECT_EQ(Base64::decode(spaced), inputs.back());
+    }
+    Base64::setKernel(best);
+}
+
+TEST(base64_kernels, kernels_reject_invalid_chars)
+{
+    const Base64::Kernel best = Base64::kernel();
+    const std::string valid = Base64::encode(randomBytes(96, 7));
+    for (auto kernel: supportedKernels()) {
+        ASSERT_TRUE(Base64::setKernel(kernel));
+        for (size_t at = 0; at < valid.size(); at += 5) {
+            for (char invalid: {'*', '-', '_', '\x80', '\0', '='}) {
+                std::string data = valid;
+                data[at] = invalid;
+                EXPECT_THROW(Base64::decode(data), Base64DecodeException) << int(kernel) << ' ' << at;
+            }
+        }
+    }
+    Base64::setKernel(best);
+}
+
+TEST(base64_kernels, decodes_into_buffers)
+{
+    const std::string data = randomBytes(100, 3);
+    const std::string encoded = Base64::encode(data);
+    EXPECT_EQ(Base64::encodedSize(data.size()), encoded.size());
+    EXPECT_EQ(Base64::encodedSize(data.size(), true), Base64::encode(data, true).size());
+
+    std::vector<char> output(encoded.size() / 4 * 3);
+    EXPECT_EQ(Base64::decodeInto(encoded.data(), encoded.size(), output.data()), data.size());
+    EXPECT_EQ(std::string(output.data(), data.size()), data);
+    EXPECT_EQ(Base64::decode(encoded.data(), encoded.size()), data);
+}
+
+TEST(base64_stream, encodes_in_chunks)
+{
+    const std::string data = randomBytes(1000, 11);
+    for (bool breakLine: {false, true}) {
+        const std::string expected = Base64::encode(data, breakLine);
+        for (size_t chunk: {1, 2, 3, 4, 5, 7, 57, 58, 100, 1000}) {
+            Base64Encoder encoder(breakLine);
+            std::string encoded;
+            std::vector<char> buffer(encoder.outputSize(chunk));
+            for (size_t at = 0; at < data.size(); at += chunk) {
+                const size_t size = std::min(chunk, data.size() - at);
+                ASSERT_LE(encoder.outputSize(size), buffer.size());
+                encoded.append(buffer.data(), encoder.update(data.data() + at, size, buffer.data()));
+            }
+            encoded.append(buffer.data(), encoder.finish(buffer.data()));
+            EXPECT_EQ(encoded, expected) << breakLine << ' ' << chunk;
+
+            // through an output iterator, the encoder is reusable
+            std::string iterated;
+            for (size_t at = 0; at < data.size(); at += chunk)
+                encoder.update(data.data() + at, std::min(chunk, data.size() - at), std::back_inserter(iterated));
+            encoder.finish(std::back_inserter(iterated));
+            EXPECT_EQ(iterated, expected) << breakLine << ' ' << chunk;
+        }
+    }
+
+    Base64Encoder empty(true);
+    char buffer[8];
+    EXPECT_EQ(empty.finish(buffer), 0u);
+}
+
+TEST(base64_stream, decodes_in_chunks)
+{
+    const std::string data = randomBytes(1000, 13);
+    std::string mime = Base64::encode(data, true);
+    // CRLF breaks, split anywhere by the chunks
+    for (size_t at = mime.find('\n'); at != std::string::npos; at = mime.find('\n', at + 2))
+        mime.insert(at, 1, '\r');
+
+    for (const std::string& encoded: {Base64::encode(data), mime}) {
+        for (size_t chunk: {1, 2, 3, 5, 16, 33, 77, 78, 4096}) {
+            Base64Decoder decoder;
+            std::string decoded;
+            for (size_t at = 0; at < encoded.size(); at += chunk) {
+                const size_t size = std::min(chunk, encoded.size() - at);
+                std::vector<char> buffer(decoder.outputSize(size));
+                decoded.append(buffer.data(), decoder.update(encoded.data() + at, size, buffer.data()));
+            }
+            decoder.finish();
+            EXPECT_EQ(decoded, data) << chunk;
+
+            std::string iterated;
+            for (size_t at = 0; at < encoded.size(); at += chunk)
+                decoder.update(encoded.data() + at, std::min(chunk, encoded.size() - at), std::back_inserter(iterated));
+            decoder.finish();
+            EXPECT_EQ(iterated, data) << chunk;
+        }
+    }
+
+    Base64Decoder decoder;
+    std::string decoded;
+    decoder.update("YWFh", 4, std::back_inserter(decoded));
+    decoder.update("YQ", 2, std::back_inserter(decoded));
+    EXPECT_THROW(decoder.finish(), Base64DecodeException);
+    decoder.update("YQ=", 3, std::back_inserter(decoded));
+    decoder.update("=", 1, std::back_inserter(decoded));
+    decoder.finish();
+    EXPECT_EQ(decoded, "aaaa");
+    EXPECT_THROW(decoder.update("Y*", 2, std::back_inserter(decoded)), Base64DecodeException);
+}
+
+TEST(base64_variants, url_and_unpadded)
+{
+    static_assert(Base64Url::encodedSize(1) == 2 && Base64Standard::encodedSize(1) == 4);
+    static_assert(Base64Mime::encodedSize(57) == 77 && Base64Mime::encodedSize(58) == 82);
+
+    EXPECT_EQ(Base64Url::encode("{\"alg\":\"HS256\",\"typ\":\"JWT\"}"), "eyJhbGciOiJIUzI1NiIsInR5cCI6IkpXVCJ9");
+    EXPECT_EQ(Base64Url::encode("f"), "Zg");
+    EXPECT_EQ(Base64Url::encode("fo"), "Zm8");
+    EXPECT_EQ(Base64Url::encode("foo"), "Zm9v");
+    EXPECT_EQ(Base64Url::encode("\xfb\xff"), "-_8");
+    EXPECT_EQ(Base64Standard::encode("\xfb\xff"), "+/8=");
+
+    EXPECT_EQ(Base64Url::decode("-_8"), "\xfb\xff");
+    EXPECT_EQ(Base64Url::decode("-_8="), "\xfb\xff");
+    EXPECT_EQ(Base64Url::decode("Zg"), "f");
+    EXPECT_EQ(Base64Url::decode("Zm9vYg"), "foob");
+    EXPECT_THROW(Base64Url::decode("+/8="), Base64DecodeException);
+    EXPECT_THROW(Base64Url::decode("Z"), Base64DecodeException);
+    EXPECT_THROW(Base64Standard::decode("Zg"), Base64DecodeException);
+    EXPECT_THROW(Base64Standard::decode("Z==="), Base64DecodeException);
+}
+
+TEST(base64_variants, kernels_agree_for_every_alphabet)
+{
+    const Base64::Kernel best = Base64::kernel();
+    for (size_t size = 0; size < 200; size += 7) {
+        const std::string data = randomBytes(size, size + 1);
+        Base64::setKernel(Base64::Kernel::Scalar);
+        const std::string url = Base64Url::encode(data);
+        const std::string mime = Base64Mime::encode(data);
+        for (auto kernel: supportedKernels()) {
+            ASSERT_TRUE(Base64::setKernel(kernel));
+            EXPECT_EQ(Base64Url::encode(data), url);
+            EXPECT_EQ(Base64Url::decode(url), data);
+            EXPECT_EQ(Base64Mime::encode(data), mime);
+            EXPECT_EQ(Base64Mime::decode(mime), data);
+        }
+        std::string standard = url;
+        std::replace(standard.begin(), standard.end(), '-', '+');
+        std::replace(standard.begin(), standard.end(), '_', '/');
+        standard.resize(Base64Standard::encodedSize(size), '=');
+        EXPECT_EQ(Base64Standard::encode(data), standard);
+    }
+    Base64::setKernel(best);
+}
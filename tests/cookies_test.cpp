@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/cookies.h"
+#include "utils/base64.h"
+#include "utils/hmac.h"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+
+namespace {
+
+std::string hex(const Sha256::Digest& digest)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string text;
+    for (uint8_t byte: digest) {
+        text += digits[byte >> 4];
+        text += digits[byte & 0xF];
+    }
+    return text;
+}
+
+Request withCookies(std::initializer_list<const char*> values)
+{
+    Request request;
+    appendHeader(request.headers, "Host", "example.com");
+    for (const char* value: values)
+        appendHeader(request.headers, "Cookie", value);
+    return request;
+}
+
+}
+
+TEST(cookies_test, sha256_and_hmac)
+{
+    Sha256 empty;
+    EXPECT_EQ(hex(empty.finish()), "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    // in pieces straddling the blocks
+    const std::string text(1000, 'a');
+    Sha256 whole;
+    whole.update(text);
+    Sha256 pieces;
+    for (size_t at = 0; at < text.size(); at += 7)
+        pieces.update(boost::string_ref(text).substr(at, 7));
+    EXPECT_EQ(hex(whole.finish()), hex(pieces.finish()));
+
+    // RFC 4231 test cases 2 and 6
+    EXPECT_EQ(hex(HmacSha256::digest("Jefe", "what do ya want for nothing?")),
+              "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    EXPECT_EQ(hex(HmacSha256::digest(std::string(131, '\xaa'),
+                                     "Test Using Larger Than Block-Size Key - Hash Key First")),
+              "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54");
+}
+
+TEST(cookies_test, splits_cookie_headers)
+{
+    const Request request = withCookies({"session=abc123; theme=\"dark\" ;  lang=en",
+                                         "flag; empty=; =orphan", "second=2"});
+    const Cookies& cookies = request.cookies();
+    EXPECT_EQ(cookies.size(), 5u);
+    EXPECT_EQ(cookies["session"], "abc123");
+    EXPECT_EQ(cookies["theme"], "dark");
+    EXPECT_EQ(cookies["lang"], "en");
+    EXPECT_EQ(cookies["empty"], "");
+    EXPECT_TRUE(cookies.contains("empty"));
+    EXPECT_EQ(cookies["second"], "2");
+    EXPECT_FALSE(cookies.contains("flag"));
+    EXPECT_FALSE(cookies.contains("missing"));
+
+    // views into the header, split once
+    const String& header = request.headers[1][1];
+    EXPECT_GE(cookies["session"].data(), header.data());
+    EXPECT_LT(cookies["session"].data(), header.data() + header.size());
+    EXPECT_EQ(&request.cookies(), &cookies);
+
+    const Request copy = request;
+    EXPECT_EQ(copy.cookies()["session"], "abc123");
+    EXPECT_EQ(copy.cookies()["session"].data(), copy.headers[1][1].data() + 8);
+
+    EXPECT_TRUE(withCookies({}).cookies().empty());
+}
+
+TEST(cookies_test, signed_cookies)
+{
+    const std::string value = signCookie("session", "user:42", "secret");
+    EXPECT_THAT(value, ::testing::StartsWith("user:42."));
+    EXPECT_EQ(value.size(), 8u + 44u);
+
+    const std::string cookie = "session=" + value;
+    EXPECT_EQ(signedCookie(withCookies({cookie.c_str()}), "session", "secret"), "user:42");
+    EXPECT_EQ(signedCookie(withCookies({cookie.c_str()}), "session", "other"), "");
+    EXPECT_EQ(signedCookie(withCookies({cookie.c_str()}), "missing", "secret"), "");
+
+    // signed for another cookie
+    const std::string moved = "admin=" + value;
+    EXPECT_EQ(signedCookie(withCookies({moved.c_str()}), "admin", "secret"), "");
+
+    std::string tampered = cookie;
+    tampered[13] = '3';
+    EXPECT_EQ(signedCookie(withCookies({tampered.c_str()}), "session", "secret"), "");
+    tampered = cookie;
+    tampered[tampered.size() - 2] = '!';
+    EXPECT_EQ(signedCookie(withCookies({tampered.c_str()}), "session", "secret"), "");
+    EXPECT_EQ(signedCookie(withCookies({"session=user:42"}), "session", "secret"), "");
+    EXPECT_EQ(signedCookie(withCookies({"session=user:42.AAAA"}), "session", "secret"), "");
+}
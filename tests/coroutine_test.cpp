@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+std::atomic<bool> slowDone(false);
+
+Task<std::string> wait(std::chrono::milliseconds delay)
+{
+    asio::steady_timer timer(co_await asio::this_coro::executor, delay);
+    co_await timer.async_wait(asio::use_awaitable);
+    co_return "waited";
+}
+
+struct Stamp {
+    void after(Request&, Response& response) { response.addHeader("X-Length", std::to_string(response.body.size())); }
+};
+
+}
+
+APP(AsyncApp, Stamp) {
+    Route("/slow") {
+        request.get = []() -> Task<std::string> {
+            std::string body = co_await wait(std::chrono::milliseconds(200));
+            slowDone = true;
+            co_return body;
+        };
+    }
+
+    Route("/fast") {
+        request.get = []() {
+            return "fast";
+        };
+    }
+
+    Route("/items/<int:id>") {
+        request.get = [](Request&, Response& response, int id) -> Task<> {
+            co_await wait(std::chrono::milliseconds(1));
+            response.status = 202;
+            response.body = std::to_string(id);
+        };
+    }
+
+    Route("/fail") {
+        request.get = []() -> Task<Response> {
+            co_await wait(std::chrono::milliseconds(1));
+            throw std::runtime_error("upstream failed");
+        };
+    }
+}
+
+TEST(coroutine_test, runs_in_place_without_a_connection)
+{
+    AsyncApp app;
+    Router router;
+    app.install(router);
+
+    Request request;
+    request.method = Method::GET;
+    request.url = "/items/9";
+    Response response;
+    router(request, response);
+    EXPECT_EQ(response.status, 202);
+    EXPECT_EQ(response.body, "9");
+    EXPECT_EQ(headerValue(response.headers, "X-Length"), "1");
+
+    request.url = "/fail";
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(response.status, 500);
+}
+
+TEST(coroutine_test, suspended_handlers_do_not_block_the_io_thread)
+{
+    AsyncApp app;
+    Router router;
+    app.install(router);
+    Server::Server server([&router](Request& request, Response& response) { router(request, response); });
+    auto& listener = server.listen("127.0.0.1", 0);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    const asio::ip::tcp::endpoint endpoint = loopback(listener);
+
+    asio::ip::tcp::socket slow(ioContext);
+    slow.connect(endpoint);
+    asio::write(slow, asio::buffer(std::string("GET /slow HTTP/1.1\r\n\r\n"
+                                               "GET /fast HTTP/1.1\r\nConnection: close\r\n\r\n")));
+
+    // the server runs a single thread, the fast request is answered while
+    // the slow one waits on its timer
+    asio::ip::tcp::socket fast(ioContext);
+    fast.connect(endpoint);
+    asio::write(fast, asio::buffer(std::string("GET /fast HTTP/1.0\r\n\r\n")));
+    const std::string fastResponse = readAll(fast);
+    EXPECT_FALSE(slowDone);
+    EXPECT_THAT(fastResponse, ::testing::EndsWith("\r\n\r\nfast"));
+
+    // pipelined requests are still answered in order
+    const std::string slowResponse = readAll(slow);
+    EXPECT_TRUE(slowDone);
+    EXPECT_THAT(slowResponse, ::testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(slowResponse, ::testing::HasSubstr("X-Length: 6\r\n"));
+    const auto first = slowResponse.find("waited");
+    ASSERT_NE(first, std::string::npos);
+    EXPECT_THAT(slowResponse.substr(first), ::testing::EndsWith("\r\n\r\nfast"));
+
+    thread.stop();
+}
@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <iostream>
+#include <map>
+#include <string>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/cgi.h"
+#include "../internal_webserver/fastcgi.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+std::string beginRequest(uint16_t requestId, bool keepConnection)
+{
+    std::string output;
+    const char body[8] = {0, FastCgi::Responder, static_cast<char>(keepConnection ? FastCgi::KeepConnection : 0)};
+    FastCgi::appendRecord(output, FastCgi::BeginRequest, requestId, boost::string_ref(body, 8));
+    return output;
+}
+
+std::string params(uint16_t requestId, const std::map<std::string, std::string>& values)
+{
+    std::string pairs, output;
+    for (auto& value: values)
+        FastCgi::appendPair(pairs, value.first, value.second);
+    FastCgi::appendStream(output, FastCgi::Params, requestId, pairs);
+    FastCgi::appendRecord(output, FastCgi::Params, requestId);
+    return output;
+}
+
+std::string stdinStream(uint16_t requestId, const std::string& data)
+{
+    std::string output;
+    FastCgi::appendStream(output, FastCgi::Stdin, requestId, data);
+    FastCgi::appendRecord(output, FastCgi::Stdin, requestId);
+    return output;
+}
+
+}
+
+TEST(fastcgi_test, record_parser_handles_split_input)
+{
+    std::string stream = beginRequest(1, true) + stdinStream(1, "some body");
+    FastCgi::RecordParser parser;
+    std::string body;
+    int begins = 0, ends = 0;
+    auto visitor = [&](const FastCgi::RecordHeader& header, boost::string_ref content, bool complete) {
+        EXPECT_EQ(header.requestId, 1);
+        if (header.type == FastCgi::BeginRequest) {
+            EXPECT_TRUE(complete);
+            EXPECT_EQ(content.size(), 8u);
+            begins++;
+        }
+        else if (content.empty()) {
+            ends++;
+        }
+        else {
+            body.append(content.data(), content.size());
+        }
+    };
+    // one byte at a time, the worst case for the parser
+    for (char chr: stream)
+        ASSERT_TRUE(parser.parse(&chr, &chr + 1, visitor));
+    EXPECT_EQ(begins, 1);
+    EXPECT_EQ(ends, 1);
+    EXPECT_EQ(body, "some body");
+}
+
+TEST(fastcgi_test, record_parser_rejects_other_protocols)
+{
+    std::string stream = "GET / HTTP/1.1\r\n\r\n";
+    FastCgi::RecordParser parser;
+    EXPECT_FALSE(parser.parse(stream.data(), stream.data() + stream.size(),
+                              [](const FastCgi::RecordHeader&, boost::string_ref, bool) {}));
+}
+
+TEST(fastcgi_test, params_decoder_long_and_split_pairs)
+{
+    std::string pairs;
+    const std::string longValue(300, 'x');
+    FastCgi::appendPair(pairs, "REQUEST_METHOD", "POST");
+    FastCgi::appendPair(pairs, "HTTP_COOKIE", longValue);
+    FastCgi::appendPair(pairs, "", "");
+
+    for (size_t split = 0; split <= pairs.size(); split++) {
+        FastCgi::ParamsDecoder decoder;
+        std::vector<std::pair<std::string, std::string>> decoded;
+        auto visitor = [&decoded](boost::string_ref name, boost::string_ref value) {
+            decoded.emplace_back(name.to_string(), value.to_string());
+        };
+        boost::string_ref data(pairs);
+        ASSERT_TRUE(decoder.feed(data.substr(0, split), visitor));
+        ASSERT_TRUE(decoder.feed(data.substr(split), visitor));
+        EXPECT_TRUE(decoder.empty());
+        ASSERT_EQ(decoded.size(), 3u);
+        EXPECT_EQ(decoded[0].second, "POST");
+        EXPECT_EQ(decoded[1].second, longValue);
+    }
+}
+
+TEST(fastcgi_test, cgi_variables_fill_request)
+{
+    Request request;
+    request.contentLength = -1;
+    Cgi::setVariable(request, "REQUEST_METHOD", "PUT");
+    Cgi::setVariable(request, "REQUEST_URI", "/items/1?x=y");
+    Cgi::setVariable(request, "SERVER_PROTOCOL", "HTTP/1.0");
+    Cgi::setVariable(request, "HTTP_HOST", "example.com");
+    Cgi::setVariable(request, "HTTP_X_APP_TEST", "Foo-Bar");
+    Cgi::setVariable(request, "CONTENT_LENGTH", "12");
+    Cgi::setVariable(request, "SCRIPT_FILENAME", "/srv/app");
+
+    EXPECT_EQ(request.method, Method::PUT);
+    EXPECT_EQ(request.methodString, "PUT");
+    EXPECT_EQ(request.url, "/items/1?x=y");
+    EXPECT_EQ(request.versionMajor, 1);
+    EXPECT_EQ(request.versionMinor, 0);
+    EXPECT_EQ(request.host, "example.com");
+    EXPECT_EQ(request.contentLength, 12);
+    Headers headers{{"Host", "example.com"}, {"X-App-Test", "Foo-Bar"}, {"Content-Length", "12"}};
+    EXPECT_EQ(request.headers, headers);
+}
+
+TEST(fastcgi_test, multiplexed_requests_on_persistent_connection)
+{
+    const std::string path = socketPath("fastcgi_test");
+    Server::Server server([](Request& request, Response& response) {
+        response.addHeader("Content-Type", "text/plain");
+        response.body = request.methodString + " " + request.url + " " + request.data;
+    });
+    server.listenUnix(path, UnixOptions(), Transport::FastCgi);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+
+    // two interleaved requests, the second one is answered first
+    std::string first = beginRequest(1, true) + params(1, {{"REQUEST_METHOD", "POST"},
+                                                           {"REQUEST_URI", "/one"},
+                                                           {"CONTENT_LENGTH", "3"}});
+    std::string second = beginRequest(2, true) + params(2, {{"REQUEST_METHOD", "GET"},
+                                                            {"REQUEST_URI", "/two"}});
+    asio::write(socket, asio::buffer(first + second + stdinStream(2, "") + stdinStream(1, "abc")));
+
+    std::map<uint16_t, std::string> stdoutStreams;
+    std::vector<uint16_t> ended;
+    FastCgi::RecordParser parser;
+    std::array<char, 4096> buffer;
+    while (ended.size() < 2) {
+        const size_t size = socket.read_some(asio::buffer(buffer));
+        ASSERT_TRUE(parser.parse(buffer.data(), buffer.data() + size,
+            [&](const FastCgi::RecordHeader& header, boost::string_ref content, bool complete) {
+                if (header.type == FastCgi::Stdout)
+                    stdoutStreams[header.requestId].append(content.data(), content.size());
+                else if (header.type == FastCgi::EndRequest && complete)
+                    ended.push_back(header.requestId);
+            }));
+    }
+    // the connection is kept, a third request goes through it
+    asio::write(socket, asio::buffer(beginRequest(3, false) +
+                                     params(3, {{"REQUEST_METHOD", "GET"}, {"REQUEST_URI", "/three"}}) +
+                                     stdinStream(3, "")));
+    const std::string rest = readAll(socket);
+    parser.parse(rest.data(), rest.data() + rest.size(),
+        [&](const FastCgi::RecordHeader& header, boost::string_ref content, bool complete) {
+            if (header.type == FastCgi::Stdout)
+                stdoutStreams[header.requestId].append(content.data(), content.size());
+            else if (header.type == FastCgi::EndRequest && complete)
+                ended.push_back(header.requestId);
+        });
+    thread.stop();
+
+    EXPECT_EQ(ended, (std::vector<uint16_t>{2, 1, 3}));
+    EXPECT_THAT(stdoutStreams[1], ::testing::StartsWith("Status: 200 OK\r\n"));
+    EXPECT_THAT(stdoutStreams[1], ::testing::EndsWith("\r\n\r\nPOST /one abc"));
+    EXPECT_THAT(stdoutStreams[2], ::testing::EndsWith("\r\n\r\nGET /two "));
+    EXPECT_THAT(stdoutStreams[3], ::testing::EndsWith("\r\n\r\nGET /three "));
+}
+
+TEST(fastcgi_test, streamed_response_one_record_per_chunk)
+{
+    const std::string path = socketPath("fastcgi_stream_test");
+    Server::Server server([](Request&, Response& response) {
+        response.stream = [part = 0](std::string& output) mutable {
+            output += "part" + std::to_string(part++) + ";";
+            return part < 3;
+        };
+    });
+    server.listenUnix(path, UnixOptions(), Transport::FastCgi);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+    asio::write(socket, asio::buffer(beginRequest(1, false) +
+                                     params(1, {{"REQUEST_METHOD", "GET"}, {"REQUEST_URI", "/stream"}}) +
+                                     stdinStream(1, "")));
+    const std::string output = readAll(socket);
+    thread.stop();
+
+    std::vector<std::string> records;
+    bool ended = false;
+    FastCgi::RecordParser parser;
+    parser.parse(output.data(), output.data() + output.size(),
+        [&](const FastCgi::RecordHeader& header, boost::string_ref content, bool complete) {
+            if (header.type == FastCgi::Stdout && complete)
+                records.push_back(content.to_string());
+            else if (header.type == FastCgi::EndRequest && complete)
+                ended = true;
+        });
+    ASSERT_EQ(records.size(), 5u);
+    EXPECT_THAT(records[0], ::testing::StartsWith("Status: 200 OK\r\n"));
+    EXPECT_EQ(records[1], "part0;");
+    EXPECT_EQ(records[2], "part1;");
+    EXPECT_EQ(records[3], "part2;");
+    EXPECT_EQ(records[4], "");
+    EXPECT_TRUE(ended);
+}
+
+TEST(fastcgi_test, closing_waits_for_multiplexed_requests)
+{
+    const std::string path = socketPath("fastcgi_close_test");
+    Server::Server server([](Request& request, Response& response) {
+        response.body = request.url;
+    });
+    server.listenUnix(path, UnixOptions(), Transport::FastCgi);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+
+    // the first request doesn't keep the connection, the second one is
+    // multiplexed before it ends and completes afterwards
+    asio::write(socket, asio::buffer(beginRequest(1, false) +
+                                     params(1, {{"REQUEST_METHOD", "GET"}, {"REQUEST_URI", "/one"}}) +
+                                     beginRequest(2, true) +
+                                     params(2, {{"REQUEST_METHOD", "GET"}, {"REQUEST_URI", "/two"}}) +
+                                     stdinStream(1, "")));
+
+    std::map<uint16_t, std::string> stdoutStreams;
+    std::vector<uint16_t> ended;
+    FastCgi::RecordParser parser;
+    auto visitor = [&](const FastCgi::RecordHeader& header, boost::string_ref content, bool complete) {
+        if (header.type == FastCgi::Stdout)
+            stdoutStreams[header.requestId].append(content.data(), content.size());
+        else if (header.type == FastCgi::EndRequest && complete)
+            ended.push_back(header.requestId);
+    };
+    std::array<char, 4096> buffer;
+    while (ended.empty()) {
+        const size_t size = socket.read_some(asio::buffer(buffer));
+        ASSERT_TRUE(parser.parse(buffer.data(), buffer.data() + size, visitor));
+    }
+    asio::write(socket, asio::buffer(stdinStream(2, "")));
+
+    // the connection is closed once the second request is answered
+    std::string rest;
+    boost::system::error_code errorCode;
+    asio::read(socket, asio::dynamic_buffer(rest), errorCode);
+    parser.parse(rest.data(), rest.data() + rest.size(), visitor);
+    thread.stop();
+
+    EXPECT_EQ(errorCode, asio::error::eof);
+    EXPECT_EQ(ended, (std::vector<uint16_t>{1, 2}));
+    EXPECT_THAT(stdoutStreams[1], ::testing::EndsWith("\r\n\r\n/one"));
+    EXPECT_THAT(stdoutStreams[2], ::testing::EndsWith("\r\n\r\n/two"));
+}
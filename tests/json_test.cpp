@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/json.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+std::string escaped(const std::string& text)
+{
+    std::string output;
+    JsonWriter::escape(output, text);
+    return output;
+}
+
+// the escaping of one byte at a time, for the vectorized one to agree with
+std::string reference(const std::string& text)
+{
+    std::string output;
+    char sequence[8];
+    for (unsigned char byte: text) {
+        switch (byte) {
+        case '"': output += "\\\""; break;
+        case '\\': output += "\\\\"; break;
+        case '\b': output += "\\b"; break;
+        case '\f': output += "\\f"; break;
+        case '\n': output += "\\n"; break;
+        case '\r': output += "\\r"; break;
+        case '\t': output += "\\t"; break;
+        default:
+            if (byte < 0x20) {
+                std::snprintf(sequence, sizeof(sequence), "\\u%04x", byte);
+                output += sequence;
+            }
+            else {
+                output += static_cast<char>(byte);
+            }
+        }
+    }
+    return output;
+}
+
+std::string number(double value)
+{
+    std::string output;
+    JsonWriter(output).value(value);
+    return output;
+}
+
+}
+
+TEST(json_test, escapes_strings)
+{
+    EXPECT_EQ(escaped("plain"), "plain");
+    EXPECT_EQ(escaped("say \"hi\"\n"), "say \\\"hi\\\"\\n");
+    EXPECT_EQ(escaped(std::string("\0\x1f/", 3)), "\\u0000\\u001f/");
+    EXPECT_EQ(escaped("caf\xc3\xa9 \xe2\x82\xac"), "caf\xc3\xa9 \xe2\x82\xac");
+
+    // every special byte at every offset of the 16 bytes blocks and the tail
+    const std::string specials("\"\\\b\f\n\r\t\x01\x7f\x80\xff", 11);
+    for (size_t length = 1; length < 40; ++length) {
+        for (size_t offset = 0; offset < length; ++offset) {
+            for (char special: specials) {
+                std::string text(length, 'a');
+                text[offset] = special;
+                text[length - 1 - offset / 2] = special;
+                EXPECT_EQ(escaped(text), reference(text)) << length << ' ' << offset;
+            }
+        }
+    }
+}
+
+TEST(json_test, writes_documents)
+{
+    std::string output;
+    JsonWriter json(output);
+    json.beginObject()
+        .key("name").value("wizrd")
+        .key("version").value(2)
+        .key("tags").beginArray().value("fast").value(std::string("small")).endArray()
+        .key("empty").beginObject().endObject()
+        .key("ratio").value(0.5)
+        .key("ok").value(true)
+        .key("parent").value(nullptr)
+        .key("raw").raw("[1,2]")
+        .endObject();
+    EXPECT_EQ(output, "{\"name\":\"wizrd\",\"version\":2,\"tags\":[\"fast\",\"small\"],"
+                      "\"empty\":{},\"ratio\":0.5,\"ok\":true,\"parent\":null,\"raw\":[1,2]}");
+    EXPECT_EQ(json.depth(), 0u);
+
+    output.clear();
+    std::vector<int> ids = {3, 1, 2};
+    json.array(ids, [](JsonWriter& writer, int id) {
+        writer.beginObject().key("id").value(id).endObject();
+    });
+    EXPECT_EQ(output, "[{\"id\":3},{\"id\":1},{\"id\":2}]");
+}
+
+TEST(json_test, numbers_round_trip)
+{
+    EXPECT_EQ(number(0.1), "0.1");
+    EXPECT_EQ(number(1.0 / 3), "0.3333333333333333");
+    EXPECT_EQ(number(-2.5), "-2.5");
+    EXPECT_EQ(number(1e300), "1e+300");
+    EXPECT_EQ(number(100), "100");
+    EXPECT_EQ(number(std::nan("")), "null");
+    EXPECT_EQ(number(std::numeric_limits<double>::infinity()), "null");
+
+    double value = 1.0;
+    for (int i = 0; i < 1000; ++i, value *= 1.37) {
+        EXPECT_EQ(std::strtod(number(value).c_str(), nullptr), value);
+        EXPECT_EQ(std::strtod(number(1 / value).c_str(), nullptr), 1 / value);
+    }
+
+    std::string output;
+    JsonWriter(output).beginArray()
+        .value(std::numeric_limits<long long>::min())
+        .value(std::numeric_limits<unsigned long long>::max())
+        .value(static_cast<short>(-7))
+        .endArray();
+    EXPECT_EQ(output, "[-9223372036854775808,18446744073709551615,-7]");
+}
+
+TEST(json_test, streams_in_chunks)
+{
+    Response response;
+    int next = 0;
+    streamJson(response, [&next](JsonWriter& json) {
+        if (next == 0)
+            json.beginArray();
+        for (int end = next + 1000; next < end && next < 2500; ++next)
+            json.value(next);
+        if (next < 2500)
+            return true;
+        json.endArray();
+        return false;
+    });
+    ASSERT_TRUE(response.stream);
+
+    Request request;
+    request.versionMajor = 1;
+    request.versionMinor = 1;
+    request.keepAlive = true;
+    std::string http;
+    response.toHttp(http, request);
+    EXPECT_THAT(http, ::testing::HasSubstr("Transfer-Encoding: chunked\r\n"));
+    EXPECT_THAT(http, ::testing::Not(::testing::HasSubstr("Content-Length")));
+    EXPECT_THAT(http, ::testing::EndsWith("\r\n\r\n"));
+
+    std::string chunks;
+    int calls = 1;
+    while (response.nextChunk(chunks, true))
+        ++calls;
+    EXPECT_EQ(calls, 3);
+    EXPECT_THAT(chunks, ::testing::EndsWith("\r\n0\r\n\r\n"));
+
+    // unframed, the chunks are the document
+    std::string document;
+    size_t at = 0;
+    while (true) {
+        const size_t size = std::stoul(chunks.substr(at, 8), nullptr, 16);
+        if (size == 0)
+            break;
+        document += chunks.substr(at + 10, size);
+        at += 10 + size + 2;
+    }
+    std::string expected = "[";
+    for (int i = 0; i < 2500; ++i)
+        expected += (i ? "," : "") + std::to_string(i);
+    expected += "]";
+    EXPECT_EQ(document, expected);
+}
+
+TEST(json_test, streams_over_connections)
+{
+    Server::Server server([](Request&, Response& response) {
+        auto rows = std::make_shared<int>(0);
+        streamJson(response, [rows](JsonWriter& json) {
+            if (*rows == 0)
+                json.beginArray();
+            json.beginObject().key("row").value(*rows).endObject();
+            if (++*rows < 3)
+                return true;
+            json.endArray();
+            return false;
+        });
+    });
+    auto& listener = server.listen("127.0.0.1", 0);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::ip::tcp::socket socket(ioContext);
+    socket.connect(loopback(listener));
+    const std::string responses = exchange(socket, "GET /rows HTTP/1.1\r\n\r\n"
+                                                   "GET /rows HTTP/1.0\r\n\r\n");
+    thread.stop();
+
+    const size_t second = responses.find("HTTP/1.0 200");
+    ASSERT_NE(second, std::string::npos);
+    const std::string chunked = responses.substr(0, second);
+    EXPECT_THAT(chunked, ::testing::HasSubstr("Transfer-Encoding: chunked\r\n"));
+    EXPECT_THAT(chunked, ::testing::HasSubstr("0000000a\r\n[{\"row\":0}\r\n"));
+    EXPECT_THAT(chunked, ::testing::EndsWith("0000000b\r\n,{\"row\":2}]\r\n0\r\n\r\n"));
+    // HTTP/1.0 gets the document as is, closing the connection after it
+    EXPECT_THAT(responses, ::testing::EndsWith("\r\n\r\n[{\"row\":0},{\"row\":1},{\"row\":2}]"));
+}
@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <optional>
+#include <sstream>
+#include <string>
+#include "gtest/gtest.h"
+#include "../loadgen/loadgen.h"
+#include "../internal_webserver/router.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+
+using namespace Wizrd;
+using namespace Wizrd::LoadGen;
+
+namespace {
+
+// a server on an ephemeral loopback port, running while in scope
+class LoopbackServer
+{
+public:
+    LoopbackServer()
+        : server_([this](Server::Request& request, Server::Response& response) { router_(request, response); }),
+          port_(server_.listen("127.0.0.1", 0).port())
+    {
+        router_.add(Server::Method::GET, "/", [](Server::Request&, Server::Response& response) {
+            response.body = "hello world!";
+        });
+        router_.add(Server::Method::POST, "/echo", [](Server::Request& request, Server::Response& response) {
+            response.body.assign(request.data.data(), request.data.size());
+        });
+        thread_.emplace(server_);
+    }
+
+    inline unsigned short port() const noexcept { return port_; }
+
+private:
+    Server::Router router_;
+    Server::Server server_;
+    unsigned short port_;
+    std::optional<Testing::ServerThread> thread_;
+};
+
+}
+
+TEST(loadgen_test, mix)
+{
+    std::istringstream input("# weight method target body\n"
+                             "3 GET /\n"
+                             "\n"
+                             "POST /echo some body\r\n"
+                             "HEAD /\n");
+    const auto mix = parseMix(input);
+    ASSERT_EQ(mix.size(), 3u);
+    EXPECT_EQ(mix[0].weight, 3u);
+    EXPECT_EQ(mix[0].method, "GET");
+    EXPECT_EQ(mix[0].target, "/");
+    EXPECT_EQ(mix[1].weight, 1u);
+    EXPECT_EQ(mix[1].body, "some body");
+    EXPECT_EQ(mix[2].method, "HEAD");
+
+    std::istringstream missingTarget("GET\n");
+    EXPECT_THROW(parseMix(missingTarget), LoadGenException);
+    std::istringstream zeroWeight("0 GET /\n");
+    EXPECT_THROW(parseMix(zeroWeight), LoadGenException);
+    std::istringstream empty("# nothing\n");
+    EXPECT_THROW(parseMix(empty), LoadGenException);
+}
+
+TEST(loadgen_test, responses)
+{
+    const std::string sized = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\nhello";
+    EXPECT_EQ(parseResponse(sized + "HTTP/1.1", false).size, sized.size());
+    EXPECT_EQ(parseResponse(sized.substr(0, sized.size() - 1), false).size, 0u);
+    EXPECT_EQ(parseResponse(sized, false).status, 200);
+    EXPECT_FALSE(parseResponse(sized, false).close);
+
+    // the body of a response to HEAD is not sent
+    const std::string head = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\n\r\n";
+    EXPECT_EQ(parseResponse(head, true).size, head.size());
+
+    const std::string chunked = "HTTP/1.1 404 Not Found\r\ntransfer-encoding: chunked\r\n\r\n"
+                                "5\r\nhello\r\nA;ext\r\n0123456789\r\n0\r\nTrailer: x\r\n\r\n";
+    EXPECT_EQ(parseResponse(chunked, false).size, chunked.size());
+    EXPECT_EQ(parseResponse(chunked, false).status, 404);
+    for (size_t size = 0; size < chunked.size(); size++)
+        EXPECT_EQ(parseResponse(chunked.substr(0, size), false).size, 0u) << size;
+
+    EXPECT_TRUE(parseResponse("HTTP/1.0 200 OK\r\nContent-Length: 0\r\n\r\n", false).close);
+    EXPECT_TRUE(parseResponse("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Length: 0\r\n\r\n", false).close);
+    const ResponseHead untilClose = parseResponse("HTTP/1.1 200 OK\r\n\r\nand so on", false);
+    EXPECT_EQ(untilClose.size, 0u);
+    EXPECT_TRUE(untilClose.close);
+
+    EXPECT_EQ(parseResponse("HTT", false).size, 0u);
+    EXPECT_THROW(parseResponse("GET / HTTP/1.1\r\n\r\n", false), LoadGenException);
+    EXPECT_THROW(parseResponse("HTTP/1.1 2x0 OK\r\n\r\n", false), LoadGenException);
+}
+
+TEST(loadgen_test, omission_correction)
+{
+    // a closed loop that expects a request per millisecond and got one
+    // stuck for 10 of them also missed the 9 that were due meanwhile
+    Histogram histogram;
+    for (int i = 0; i < 99; i++)
+        histogram.record(100000);
+    histogram.record(10000000);
+    const Histogram corrected = correctedForOmission(histogram, 1000000);
+    EXPECT_EQ(corrected.count, 109u);
+    EXPECT_LE(histogram.quantile(0.99), 110000u);
+    EXPECT_GE(corrected.quantile(0.99), 9000000u);
+    EXPECT_GE(corrected.quantile(0.95), 5000000u);
+    EXPECT_EQ(correctedForOmission(histogram, 0).count, histogram.count);
+}
+
+TEST(loadgen_test, closed_loop)
+{
+    LoopbackServer server;
+    LoadOptions options;
+    options.port = server.port();
+    options.connections = 4;
+    options.pipeline = 4;
+    options.threads = 2;
+    options.duration = std::chrono::milliseconds(300);
+    std::istringstream mix("3 GET /\n1 POST /echo body\n1 GET /missing\n");
+    options.mix = parseMix(mix);
+
+    const LoadReport report = run(options);
+    EXPECT_GT(report.responses, 0u);
+    EXPECT_EQ(report.errors, 0u);
+    EXPECT_EQ(report.requests, report.responses);
+    EXPECT_EQ(report.statuses[2] + report.statuses[4], report.responses);
+    EXPECT_GT(report.statuses[4], 0u);
+    EXPECT_EQ(report.uncorrected.count, report.responses);
+    EXPECT_GE(report.latency.count, report.uncorrected.count);
+    EXPECT_GT(report.bytesReceived, 0u);
+
+    std::string json;
+    report.writeJson(json);
+    EXPECT_EQ(json.compare(0, 17, "{\"mode\":\"closed\",") , 0) << json;
+    EXPECT_NE(json.find("\"latency_us\":{\"count\":"), std::string::npos);
+}
+
+TEST(loadgen_test, open_loop)
+{
+    LoopbackServer server;
+    LoadOptions options;
+    options.port = server.port();
+    options.connections = 2;
+    options.rate = 400;
+    options.duration = std::chrono::milliseconds(500);
+
+    // requests are sent on schedule, 200 of them
+    const LoadReport report = run(options);
+    EXPECT_GE(report.requests, 190u);
+    EXPECT_LE(report.requests, 200u);
+    EXPECT_EQ(report.errors, 0u);
+    EXPECT_EQ(report.statuses[2], report.responses);
+    EXPECT_EQ(report.latency.count, report.responses);
+
+    std::string text;
+    report.writeText(text);
+    EXPECT_EQ(text.compare(0, 9, "open loop"), 0) << text;
+}
+
+TEST(loadgen_test, unreachable)
+{
+    LoadOptions options;
+    options.port = 1;
+    options.connections = 1;
+    options.duration = std::chrono::milliseconds(50);
+    const LoadReport report = run(options);
+    EXPECT_EQ(report.responses, 0u);
+    EXPECT_GT(report.errors, 0u);
+}
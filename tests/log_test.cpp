@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "utils/log.h"
+
+using namespace Wizrd;
+
+namespace {
+
+// collects the lines written, without their timestamp
+class Lines
+{
+public:
+    Lines()
+    {
+        Log::setSink([this](LogLevel, boost::string_ref line) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            lines_.push_back(line.substr(line.find(' ') + 1).to_string());
+        });
+    }
+    ~Lines()
+    {
+        Log::flush();
+        Log::setSink(Log::Sink());
+    }
+
+    std::vector<std::string> get()
+    {
+        Log::flush();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return lines_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::string> lines_;
+};
+
+}
+
+TEST(log_test, formats_arguments)
+{
+    Lines lines;
+    const std::string text = "text";
+    WIZRD_LOG(Error, "plain");
+    WIZRD_LOG(Error, "{} {} {} {} {}", -42, 42u, 'c', true, 1.5);
+    WIZRD_LOG(Error, "{}|{}|{}", text, boost::string_ref("ref"), "literal");
+    WIZRD_LOG(Error, "missing {} {}", 1);
+    WIZRD_LOG(Error, "extra {}", 1, 2);
+    WIZRD_LOG(Warning, "{{}}");
+
+    const auto written = lines.get();
+    ASSERT_EQ(written.size(), 6u);
+    EXPECT_EQ(written[0], "[error] plain");
+    EXPECT_EQ(written[1], "[error] -42 42 c true 1.5");
+    EXPECT_EQ(written[2], "[error] text|ref|literal");
+    EXPECT_EQ(written[3], "[error] missing 1 {}");
+    EXPECT_EQ(written[4], "[error] extra 1");
+    EXPECT_EQ(written[5], "[warning] {{}}");
+}
+
+TEST(log_test, levels)
+{
+    Lines lines;
+    int evaluated = 0;
+    auto argument = [&evaluated] { return ++evaluated; };
+
+    // below the level compiled in, the arguments are not even evaluated
+    WIZRD_LOG(Trace, "trace {}", argument());
+    EXPECT_EQ(evaluated, WIZRD_LOG_MIN_LEVEL <= 0 ? 1 : 0);
+
+    Log::setLevel(LogLevel::Warning);
+    WIZRD_LOG(Info, "info {}", argument());
+    WIZRD_LOG(Fatal, "fatal");
+    Log::setLevel(LogLevel::Trace);
+
+    const auto written = lines.get();
+    ASSERT_FALSE(written.empty());
+    EXPECT_EQ(written.back(), "[fatal] fatal");
+    EXPECT_EQ(written.size(), WIZRD_LOG_MIN_LEVEL <= 0 ? 2u : 1u);
+}
+
+TEST(log_test, threads)
+{
+    Lines lines;
+    const uint64_t dropped = Log::dropped();
+    const int count = 10000;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; thread++) {
+        threads.emplace_back([thread] {
+            for (int i = 0; i < count; i++)
+                WIZRD_LOG(Error, "thread {} record {} {}", thread, i, std::string(i % 100, 'x'));
+        });
+    }
+    for (auto& thread: threads)
+        thread.join();
+
+    // records are never mixed up, they are written in order per thread
+    // and only dropped when a ring is full
+    const auto written = lines.get();
+    EXPECT_EQ(written.size() + (Log::dropped() - dropped), 4u * count);
+    std::vector<int> last(4, -1);
+    for (const std::string& line: written) {
+        int thread, record;
+        ASSERT_EQ(std::sscanf(line.c_str(), "[error] thread %d record %d", &thread, &record), 2) << line;
+        EXPECT_GT(record, last[thread]);
+        last[thread] = record;
+        EXPECT_EQ(line.size() - line.rfind(' ') - 1, size_t(record % 100));
+    }
+}
+
+TEST(log_test, full_ring_drops)
+{
+    Lines lines;
+    const uint64_t dropped = Log::dropped();
+    const std::string large(Log::RingSize / 2, 'x');
+    WIZRD_LOG(Error, "{}", large);
+    EXPECT_EQ(Log::dropped(), dropped + 1);
+    EXPECT_TRUE(lines.get().empty());
+}
+
+TEST(log_test, thread_local_destructors_log)
+{
+    // destroyed after the ring of the thread was closed
+    struct LateLogger {
+        ~LateLogger() { WIZRD_LOG(Error, "late"); }
+    };
+    Lines lines;
+    std::thread([] {
+        thread_local LateLogger logger;
+        (void)logger;
+        WIZRD_LOG(Error, "early");
+    }).join();
+
+    const auto written = lines.get();
+    ASSERT_EQ(written.size(), 2u);
+    EXPECT_EQ(written[0], "[error] early");
+    EXPECT_EQ(written[1], "[error] late");
+}
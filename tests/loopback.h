@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#pragma once
+
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <boost/asio.hpp>
+#include "../internal_webserver/server.h"
+
+// talking to a Server over a socket, shared by the tests that do
+
+namespace Wizrd { namespace Testing {
+
+/// runs server on a thread of its own until stop() or the end of the scope,
+/// its listeners are added before
+class ServerThread
+{
+public:
+    explicit ServerThread(Server::Server& server) : server_(server), thread_([this]() { server_.run(); }) {}
+    ServerThread(const ServerThread&) = delete;
+    ServerThread& operator=(const ServerThread&) = delete;
+    ~ServerThread() { stop(); }
+
+    inline std::thread::id id() const noexcept { return thread_.get_id(); }
+
+    void stop()
+    {
+        if (!thread_.joinable())
+            return;
+        server_.stop();
+        thread_.join();
+    }
+
+private:
+    Server::Server& server_;
+    std::thread thread_;
+};
+
+/// unix socket path of the test process
+inline std::string socketPath(const std::string& name)
+{
+    return "/tmp/wizrd_" + name + "_" + std::to_string(::getpid()) + ".sock";
+}
+
+/// address of a tcp listener bound to 127.0.0.1
+inline boost::asio::ip::tcp::endpoint loopback(const Server::Listener& listener)
+{
+    return boost::asio::ip::tcp::endpoint(boost::asio::ip::address_v4::loopback(), listener.port());
+}
+
+/// reads until the peer closes the connection
+template <class Socket>
+std::string readAll(Socket& socket)
+{
+    std::string output;
+    boost::system::error_code errorCode;
+    boost::asio::read(socket, boost::asio::dynamic_buffer(output), errorCode);
+    return output;
+}
+
+/// writes request, then reads until the peer closes the connection
+template <class Socket>
+std::string exchange(Socket& socket, const std::string& request)
+{
+    boost::asio::write(socket, boost::asio::buffer(request));
+    return readAll(socket);
+}
+
+}}
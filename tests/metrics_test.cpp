@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "../internal_webserver/metrics.h"
+#include "../internal_webserver/router.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+
+TEST(metrics_test, histogram_buckets)
+{
+    // small values have a bucket each, larger ones are kept within 12.5%
+    for (uint64_t value = 0; value < 8; value++)
+        EXPECT_EQ(LatencyHistogram::upperBound(LatencyHistogram::bucket(value)), value);
+    for (uint64_t value: {8ull, 9ull, 100ull, 1000ull, 123456ull, 999999999ull}) {
+        const uint64_t bound = LatencyHistogram::upperBound(LatencyHistogram::bucket(value));
+        EXPECT_GE(bound, value);
+        EXPECT_LE(bound, value + value / 8);
+    }
+    EXPECT_EQ(LatencyHistogram::bucket(uint64_t(1) << 62), LatencyHistogram::Buckets - 1);
+}
+
+TEST(metrics_test, histogram_quantiles)
+{
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 1000; value++)
+        histogram.record(value * 1000);
+    LatencyHistogram::Snapshot snapshot;
+    snapshot.add(histogram);
+    EXPECT_EQ(snapshot.count, 1000u);
+    EXPECT_EQ(snapshot.sum, 500500000u);
+    EXPECT_EQ(LatencyHistogram::Snapshot().quantile(0.5), 0u);
+    for (double q: {0.5, 0.9, 0.99, 0.999}) {
+        const double exact = q * 1000000;
+        EXPECT_GE(snapshot.quantile(q), exact);
+        EXPECT_LE(snapshot.quantile(q), exact * 1.125);
+    }
+}
+
+TEST(metrics_test, route_ids)
+{
+    EXPECT_EQ(Metrics::routeId(""), 0u);
+    const uint32_t users = Metrics::routeId("/metrics_test/users");
+    EXPECT_NE(users, 0u);
+    EXPECT_EQ(Metrics::routeId("/metrics_test/users"), users);
+    EXPECT_NE(Metrics::routeId("/metrics_test/user/<id>"), users);
+}
+
+TEST(metrics_test, threads_are_added_together)
+{
+    const uint32_t route = Metrics::routeId("/metrics_test/threads");
+    const uint64_t errors = Metrics::total(Metrics::ParseErrors);
+    auto work = [route] {
+        for (int i = 0; i < 100; i++) {
+            Metrics::record(route, Metrics::Parse, std::chrono::microseconds(10));
+            Metrics::count(Metrics::ParseErrors);
+        }
+    };
+    std::thread first(work), second(work);
+    first.join();
+    second.join();
+    EXPECT_EQ(Metrics::total(Metrics::ParseErrors), errors + 200);
+    const auto snapshot = Metrics::snapshot(route, Metrics::Parse);
+    EXPECT_EQ(snapshot.count, 200u);
+    EXPECT_EQ(snapshot.sum, 2000000u);
+    EXPECT_EQ(Metrics::snapshot(route, Metrics::Write).count, 0u);
+}
+
+TEST(metrics_test, exited_threads_are_kept_in_the_totals)
+{
+    const uint32_t route = Metrics::routeId("/metrics_test/exited");
+    const uint64_t reuses = Metrics::total(Metrics::KeepAliveReuses);
+    std::atomic<bool> done(false);
+    bool monotonic = true;
+    // scrapes while the threads exit, their counts must never go back
+    std::thread scraper([&done, &monotonic, reuses] {
+        uint64_t last = reuses;
+        while (!done) {
+            std::string output;
+            Metrics::write(output);
+            const uint64_t total = Metrics::total(Metrics::KeepAliveReuses);
+            monotonic = monotonic && total >= last;
+            last = total;
+        }
+    });
+    for (int i = 0; i < 50; i++) {
+        std::thread([route] {
+            Metrics::count(Metrics::KeepAliveReuses, 2);
+            Metrics::record(route, Metrics::Write, std::chrono::microseconds(1));
+        }).join();
+    }
+    done = true;
+    scraper.join();
+    EXPECT_TRUE(monotonic);
+    EXPECT_EQ(Metrics::total(Metrics::KeepAliveReuses), reuses + 100);
+    EXPECT_EQ(Metrics::snapshot(route, Metrics::Write).count, 50u);
+}
+
+TEST(metrics_test, disabled)
+{
+    const uint32_t route = Metrics::routeId("/metrics_test/disabled");
+    Metrics::setEnabled(false);
+    EXPECT_EQ(Metrics::now(), Metrics::Clock::time_point());
+    Metrics::record(route, Metrics::Handler, std::chrono::milliseconds(1));
+    Metrics::setEnabled(true);
+    EXPECT_EQ(Metrics::snapshot(route, Metrics::Handler).count, 0u);
+}
+
+TEST(metrics_test, router_records_routes)
+{
+    Router router;
+    router.add(Method::GET, "/metrics_test/items/<int:id>", [](Request&, Response& response) {
+        response.body = "item";
+    });
+    router.add(Method::GET, "/metrics", Metrics::handler());
+    const uint32_t route = Metrics::routeId("/metrics_test/items/<int:id>");
+
+    Request request;
+    request.url = "/metrics_test/items/7";
+    Response response;
+    router(request, response);
+    EXPECT_EQ(request.route, route);
+    EXPECT_EQ(Metrics::snapshot(route, Metrics::Route).count, 1u);
+    EXPECT_EQ(Metrics::snapshot(route, Metrics::Handler).count, 1u);
+
+    Request missing;
+    missing.url = "/metrics_test/nothing";
+    Response notFound;
+    router(missing, notFound);
+    EXPECT_EQ(notFound.status, 404);
+    EXPECT_EQ(missing.route, 0u);
+
+    Request scrape;
+    scrape.url = "/metrics";
+    Response exposition;
+    router(scrape, exposition);
+    EXPECT_EQ(exposition.status, 200);
+    EXPECT_NE(exposition.body.find("# TYPE wizrd_request_phase_seconds summary\n"), std::string::npos);
+    EXPECT_NE(exposition.body.find("wizrd_request_phase_seconds_count{route=\"/metrics_test/items/<int:id>\","
+                                   "phase=\"handler\"} 1\n"), std::string::npos);
+    EXPECT_NE(exposition.body.find("wizrd_request_phase_seconds{route=\"unmatched\",phase=\"route\","
+                                   "quantile=\"0.99\"} "), std::string::npos);
+    EXPECT_NE(exposition.body.find("# TYPE wizrd_connections_active gauge\n"), std::string::npos);
+}
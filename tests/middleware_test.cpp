@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string>
+#include "gtest/gtest.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+
+namespace {
+
+std::string trace;
+ResponseCache cache;
+
+struct Outer {
+    void before(Request&, Response&) { trace += "outer<"; }
+    void after(Request&, Response& response) { trace += ">outer"; response.addHeader("X-Outer", "1"); }
+};
+
+struct Auth {
+    std::string token = "secret";
+    bool before(Request& request, Response& response)
+    {
+        trace += "auth<";
+        if (headerValue(request.headers, "Authorization") == token)
+            return true;
+        response.status = 401;
+        return false;
+    }
+};
+
+struct Inner {
+    void after(Request&, Response&) { trace += ">inner"; }
+};
+
+}
+
+APP(GuardedApp, Outer, Auth, Inner) {
+    middleware<Auth>().token = "let me in";
+
+    Route("/items/<int:id>") {
+        request.get = [](int id) {
+            trace += "handler";
+            return std::to_string(id);
+        };
+    }
+
+    Route("/cached/<int:id>") {
+        request.cache(std::chrono::seconds(60), {}, cache);
+        request.get = [](int id) {
+            trace += "handler";
+            return std::to_string(id);
+        };
+    }
+
+    DynamicRoute(std::string("/dynamic")) {
+        request.get = []() {
+            trace += "dynamic";
+            return "dynamic";
+        };
+    }
+}
+
+TEST(middleware_test, layers_run_around_the_handler)
+{
+    GuardedApp app;
+    Router router;
+    app.install(router);
+
+    Request request;
+    request.method = Method::GET;
+    request.url = "/items/5";
+    request.headers.push_back({"Authorization", "let me in"});
+    Response response;
+    trace.clear();
+    router(request, response);
+    EXPECT_EQ(response.body, "5");
+    EXPECT_EQ(headerValue(response.headers, "X-Outer"), "1");
+    EXPECT_EQ(trace, "outer<auth<handler>inner>outer");
+
+    request.url = "/dynamic";
+    response.reset();
+    trace.clear();
+    router(request, response);
+    EXPECT_EQ(response.body, "dynamic");
+    EXPECT_EQ(trace, "outer<auth<dynamic>inner>outer");
+}
+
+TEST(middleware_test, before_can_answer_the_request)
+{
+    GuardedApp app;
+    Router router;
+    app.install(router);
+
+    Request request;
+    request.method = Method::GET;
+    request.url = "/items/5";
+    Response response;
+    trace.clear();
+    router(request, response);
+    EXPECT_EQ(response.status, 401);
+    EXPECT_EQ(response.body, "");
+    EXPECT_EQ(trace, "outer<auth<>outer");
+}
+
+TEST(middleware_test, cache_hits_run_the_before_hooks)
+{
+    GuardedApp app;
+    Router router;
+    app.install(router);
+    cache.clear();
+
+    Request request;
+    request.method = Method::GET;
+    request.url = "/cached/5";
+    request.headers.push_back({"Authorization", "let me in"});
+    Response response;
+    router(request, response);
+    EXPECT_EQ(response.body, "5");
+
+    response.reset();
+    trace.clear();
+    router(request, response);
+    ASSERT_TRUE(response.cached);
+    EXPECT_EQ(response.resolved().body, "5");
+    EXPECT_EQ(trace, "outer<auth<>inner>outer");
+
+    request.headers.clear();
+    response.reset();
+    trace.clear();
+    router(request, response);
+    EXPECT_FALSE(response.cached);
+    EXPECT_EQ(response.status, 401);
+    EXPECT_EQ(trace, "outer<auth<>outer");
+}
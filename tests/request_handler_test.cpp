@@ -80,10 +80,40 @@ TEST(request_parser_test, test_http10_request)
     EXPECT_EQ(req.versionMajor, 1);
     EXPECT_EQ(req.versionMinor, 0);
     EXPECT_EQ(false, req.keepAlive);
-    EXPECT_EQ("someDatablalalala", req.data);
+    // without Content-Length there is no body, the rest is left unparsed
+    EXPECT_EQ("", req.data);
     EXPECT_EQ(headers, req.headers);
-    EXPECT_TRUE(std::get<0>(response) == test_post.end());
+    EXPECT_EQ(std::get<1>(response), Server::RequestParser::Ok);
+    EXPECT_EQ(std::string(std::get<0>(response), test_post.end()), "someDatablalalala");
+
+}
+
+TEST(request_parser_test, test_http10_pipelined_keep_alive)
+{
+    Server::RequestParser parser;
+    std::string test_get("GET /first HTTP/1.0\r\n"
+                         "Connection: keep-alive\r\n"
+                         "\r\n"
+                         "GET /second HTTP/1.0\r\n"
+                         "Connection: keep-alive\r\n"
+                         "\r\n");
+    Server::Request req;
 
+    auto response = parser.parse(req, test_get.begin(), test_get.end());
+    ASSERT_EQ(std::get<1>(response), Server::RequestParser::Ok);
+    EXPECT_EQ(req.url, "/first");
+    EXPECT_EQ(req.versionMinor, 0);
+    EXPECT_TRUE(req.keepAlive);
+    EXPECT_EQ(req.data, "");
+    ASSERT_FALSE(std::get<0>(response) == test_get.end());
+
+    Server::Request second;
+    response = parser.parse(second, std::get<0>(response), test_get.end());
+    ASSERT_EQ(std::get<1>(response), Server::RequestParser::Ok);
+    EXPECT_EQ(second.url, "/second");
+    EXPECT_TRUE(second.keepAlive);
+    EXPECT_EQ(second.data, "");
+    EXPECT_TRUE(std::get<0>(response) == test_get.end());
 }
 
 TEST(request_parser_test1, test_http11_request_with_keep_alive)
@@ -154,3 +184,28 @@ TEST(request_parser_test2, test_invalid_request)
     EXPECT_FALSE(std::get<0>(response) == test_get.end());
 
 }
+
+TEST(request_parser_test2, test_request_target_is_canonical)
+{
+    Server::RequestParser parser;
+    std::string test_get("GET /a//b/./c/../%7euser/%2f%41?x=%2f&y#frag HTTP/1.1\r\n"
+                         "Host: www.example.com\r\n"
+                         "\r\n");
+    Server::Request req;
+    auto response = parser.parse(req, test_get.begin(), test_get.end());
+    ASSERT_EQ(std::get<1>(response), Server::RequestParser::Ok);
+    EXPECT_EQ(req.url, "/a/b/~user/%2FA?x=%2f&y");
+    EXPECT_EQ(req.host, "www.example.com");
+
+    std::string proxied("GET http://api.example.com:8080/v1/../v2?q=1 HTTP/1.1\r\n"
+                        "Host: ignored.example.com\r\n"
+                        "\r\n");
+    response = parser.parse(req, proxied.begin(), proxied.end());
+    ASSERT_EQ(std::get<1>(response), Server::RequestParser::Ok);
+    EXPECT_EQ(req.url, "/v2?q=1");
+    EXPECT_EQ(req.host, "api.example.com:8080");
+
+    std::string bad("GET ://nothing HTTP/1.1\r\n\r\n");
+    response = parser.parse(req, bad.begin(), bad.end());
+    EXPECT_EQ(std::get<1>(response), Server::RequestParser::Error);
+}
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <chrono>
+#include <string>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+int renders = 0;
+
+std::shared_ptr<const CachedResponse> entry(const std::string& body)
+{
+    auto response = std::make_shared<CachedResponse>();
+    response->response.body = body;
+    response->http = body;
+    return response;
+}
+
+std::string keyOf(const std::string& url, const std::string& host = "",
+                  const Headers& headers = Headers(), const std::vector<std::string>& vary = {})
+{
+    Request request;
+    request.method = Method::GET;
+    request.url = url;
+    request.host = host;
+    request.headers = headers;
+    std::string key;
+    ResponseCache::key(key, request, vary);
+    return key;
+}
+
+ResponseCache cache;
+
+}
+
+TEST(responsecache_test, keys_are_normalized)
+{
+    EXPECT_EQ(keyOf("/a?y=2&x=1", "Example.COM"), keyOf("/a?x=1&y=2#top", "example.com"));
+    EXPECT_NE(keyOf("/a?x=1"), keyOf("/a?x=2"));
+    EXPECT_EQ(keyOf("/a?id=1&x=0&id=2"), keyOf("/a?x=0&id=1&id=2"));
+    EXPECT_NE(keyOf("/a?id=1&id=2"), keyOf("/a?id=2&id=1"));
+    EXPECT_NE(keyOf("/a", "one"), keyOf("/a", "two"));
+
+    const std::vector<std::string> vary = {"Accept-Language"};
+    EXPECT_EQ(keyOf("/a", "", {{"accept-language", "fr"}}, vary),
+              keyOf("/a", "", {{"Accept-Language", "fr"}, {"X-Other", "1"}}, vary));
+    EXPECT_NE(keyOf("/a", "", {{"Accept-Language", "fr"}}, vary),
+              keyOf("/a", "", {{"Accept-Language", "en"}}, vary));
+}
+
+TEST(responsecache_test, head_responses_are_not_stored)
+{
+    ResponseCache cache(1024 * 1024, 1);
+    Cached<RequestHandler> cached(cache, std::chrono::seconds(60), {}, [](Request&, Response& response) {
+        response.status = 200;
+    });
+    Request request;
+    request.method = Method::HEAD;
+    request.url = "/a";
+    Response response;
+    cached(request, response);
+    EXPECT_EQ(cache.size(), 0u);
+}
+
+TEST(responsecache_test, entries_expire_and_are_purged)
+{
+    ResponseCache cache(1024 * 1024, 4);
+    cache.insert("GET /a", entry("a"), std::chrono::seconds(60));
+    cache.insert("GET /a?page=2", entry("a2"), std::chrono::seconds(60));
+    cache.insert("GET /b", entry("b"), std::chrono::seconds(0));
+    ASSERT_TRUE(cache.find("GET /a"));
+    EXPECT_EQ(cache.find("GET /a")->response.body, "a");
+    EXPECT_FALSE(cache.find("GET /b"));
+    EXPECT_FALSE(cache.find("GET /c"));
+    EXPECT_EQ(cache.size(), 3u);
+
+    EXPECT_EQ(cache.purge("/a"), 2u);
+    EXPECT_FALSE(cache.find("GET /a"));
+    EXPECT_FALSE(cache.find("GET /a?page=2"));
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0u);
+    EXPECT_EQ(cache.bytes(), 0u);
+}
+
+TEST(responsecache_test, clock_eviction_keeps_referenced_entries)
+{
+    // a single shard holding about four entries
+    ResponseCache cache(4 * (6 + 2 * 100), 1);
+    const std::string body(100, 'x');
+    for (int i = 0; i < 4; i++)
+        cache.insert("GET /" + std::to_string(i), entry(body), std::chrono::seconds(60));
+    EXPECT_EQ(cache.size(), 4u);
+    ASSERT_TRUE(cache.find("GET /0"));
+
+    cache.insert("GET /4", entry(body), std::chrono::seconds(60));
+    EXPECT_EQ(cache.size(), 4u);
+    EXPECT_LE(cache.bytes(), 4u * (6 + 2 * 100));
+    EXPECT_TRUE(cache.find("GET /0"));
+    EXPECT_TRUE(cache.find("GET /4"));
+    EXPECT_FALSE(cache.find("GET /1"));
+
+    // larger than the shard, not kept
+    cache.insert("GET /big", entry(std::string(1000, 'x')), std::chrono::seconds(60));
+    EXPECT_FALSE(cache.find("GET /big"));
+}
+
+APP(CatalogApp) {
+    Route("/products/<int:id>") {
+        request.cache(std::chrono::seconds(60), {"Accept-Language"}, cache);
+        request.get = [](Request&, Response& response, int id) {
+            renders++;
+            response.addHeader("Content-Type", "text/plain");
+            response.body = "product " + std::to_string(id);
+        };
+        request.post = [](int id) {
+            renders++;
+            return "updated " + std::to_string(id);
+        };
+    }
+
+    Route("/session") {
+        request.cache(std::chrono::seconds(60), {}, cache);
+        request.get = [](Request&, Response& response) {
+            renders++;
+            response.addHeader("Set-Cookie", "id=1");
+        };
+    }
+}
+
+TEST(responsecache_test, cached_routes)
+{
+    CatalogApp app;
+    Router router;
+    app.install(router);
+    cache.clear();
+    renders = 0;
+
+    Request request;
+    request.method = Method::GET;
+    request.url = "/products/1";
+    request.versionMajor = 1;
+    request.versionMinor = 1;
+    request.keepAlive = true;
+    Response response;
+    router(request, response);
+    EXPECT_EQ(renders, 1);
+    EXPECT_EQ(response.body, "product 1");
+
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(renders, 1);
+    ASSERT_TRUE(response.cached);
+    EXPECT_EQ(response.resolved().body, "product 1");
+    EXPECT_THAT(response.cached->http, ::testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(response.cached->http, ::testing::EndsWith("\r\n\r\nproduct 1"));
+    EXPECT_TRUE(response.cached->sendsAsIs(request));
+
+    request.method = Method::HEAD;
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(renders, 1);
+    EXPECT_FALSE(response.cached->sendsAsIs(request));
+
+    request.method = Method::GET;
+    request.headers.push_back({"Accept-Language", "fr"});
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(renders, 2);
+
+    request.method = Method::POST;
+    response.reset();
+    router(request, response);
+    router(request, response);
+    EXPECT_EQ(renders, 4);
+
+    request.method = Method::GET;
+    request.url = "/session";
+    response.reset();
+    router(request, response);
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(renders, 6);
+    EXPECT_FALSE(response.cached);
+
+    EXPECT_EQ(cache.purge("/products/1"), 2u);
+}
+
+TEST(responsecache_test, hits_are_sent_as_stored)
+{
+    CatalogApp app;
+    Router router;
+    app.install(router);
+    cache.clear();
+    renders = 0;
+    Server::Server server([&router](Request& request, Response& response) { router(request, response); });
+    auto& listener = server.listen("127.0.0.1", 0);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::ip::tcp::socket socket(ioContext);
+    socket.connect(loopback(listener));
+    const std::string responses = exchange(socket, "GET /products/7 HTTP/1.1\r\n\r\n"
+                                                   "GET /products/7 HTTP/1.1\r\n\r\n"
+                                                   "GET /products/7 HTTP/1.1\r\nConnection: close\r\n\r\n");
+    thread.stop();
+
+    EXPECT_EQ(renders, 1);
+    const std::string first = responses.substr(0, responses.find("product 7") + 9);
+    EXPECT_EQ(responses.substr(first.size(), first.size()), first);
+    EXPECT_THAT(responses, ::testing::HasSubstr("Connection: close\r\n"));
+    EXPECT_THAT(responses, ::testing::EndsWith("product 7"));
+}
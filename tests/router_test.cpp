@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <iostream>
+#include <string>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/router.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+
+namespace {
+
+RequestHandler named(const std::string& name)
+{
+    return [name](Request&, Response& response) { response.body = name; };
+}
+
+std::string dispatch(const Router& router, Method method, const std::string& url,
+                     const std::string& host = "", int* status = nullptr)
+{
+    Request request;
+    request.method = method;
+    request.url = url;
+    request.host = host;
+    Response response;
+    router(request, response);
+    if (status)
+        *status = response.status;
+    for (size_t i = 0; i < request.parameters.size(); i++) {
+        response.body += ' ';
+        response.body += request.parameters.name(i).to_string();
+        response.body += '=';
+        response.body += request.parameters.value(i).to_string();
+    }
+    return response.body;
+}
+
+}
+
+TEST(router_test, static_routes)
+{
+    Router router;
+    router.add(Method::GET, "/", named("root"));
+    router.add(Method::GET, "/users", named("users"));
+    router.add(Method::GET, "/users/new", named("new user"));
+    router.add(Method::GET, "/user", named("user"));
+    router.add(Method::POST, "/users", named("create user"));
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/"), "root");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users"), "users");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users?page=2#top"), "users");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/new"), "new user");
+    EXPECT_EQ(dispatch(router, Method::GET, "/user"), "user");
+    EXPECT_EQ(dispatch(router, Method::POST, "/users"), "create user");
+    EXPECT_EQ(dispatch(router, Method::HEAD, "/users"), "users");
+
+    int status = 0;
+    dispatch(router, Method::GET, "/use", "", &status);
+    EXPECT_EQ(status, 404);
+    dispatch(router, Method::DELETE, "/users", "", &status);
+    EXPECT_EQ(status, 405);
+}
+
+TEST(router_test, captures_and_wildcards)
+{
+    Router router;
+    router.add(Method::GET, "/users/<id>", named("user"));
+    router.add(Method::GET, "/users/<id>/posts/<post>", named("post"));
+    router.add(Method::GET, "/users/me", named("me"));
+    router.add(Method::GET, "/static/<path:file>", named("static"));
+    router.add(Method::GET, "/files/<name>.txt", named("text file"));
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/42"), "user id=42");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/me"), "me");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/mexico"), "user id=mexico");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/42/posts/7?full=1"), "post id=42 post=7");
+    EXPECT_EQ(dispatch(router, Method::GET, "/static/css/site.css"), "static file=css/site.css");
+    int status = 0;
+    dispatch(router, Method::GET, "/users/", "", &status);
+    EXPECT_EQ(status, 404);
+}
+
+TEST(router_test, float_captures_are_plain_decimals)
+{
+    Router router;
+    router.add(Method::GET, "/tree/<float:x>", named("tree"));
+    addCompiled<"/compiled/<float:x>">(router, Method::GET, [](double x) { return std::to_string(x); });
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/tree/1.5"), "tree x=1.5");
+    EXPECT_EQ(dispatch(router, Method::GET, "/compiled/1.5"), "1.500000 x=1.5");
+    for (const char* value: {"nan", "inf", "infinity", "NaN", "-1", "+1", "1e3", ".", "1.2.3"}) {
+        for (const char* prefix: {"/tree/", "/compiled/"}) {
+            int status = 0;
+            dispatch(router, Method::GET, prefix + std::string(value), "", &status);
+            EXPECT_EQ(status, 404) << prefix << value;
+        }
+    }
+}
+
+TEST(router_test, parameters_are_views_into_the_url)
+{
+    Router router;
+    router.add(Method::GET, "/items/<id>", named("item"));
+    PathParameters parameters;
+    const std::string url = "/items/abc?x=1";
+    ASSERT_NE(router.match(Method::GET, "", url, parameters), nullptr);
+    ASSERT_EQ(parameters.size(), 1u);
+    EXPECT_EQ(parameters["id"], "abc");
+    EXPECT_EQ(parameters["id"].data(), url.data() + 7);
+    EXPECT_TRUE(parameters["missing"].empty());
+}
+
+TEST(router_test, virtual_hosts)
+{
+    Router router;
+    router.add(Method::GET, "/", named("default"));
+    router.add(Method::GET, "/", named("api"), "api.example.com");
+    router.add(Method::GET, "/only-api", named("only api"), "api.example.com");
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/", "www.example.com"), "default");
+    EXPECT_EQ(dispatch(router, Method::GET, "/", "API.example.com:8080"), "api");
+    EXPECT_EQ(dispatch(router, Method::GET, "/only-api", "api.example.com"), "only api");
+    int status = 0;
+    dispatch(router, Method::GET, "/only-api", "www.example.com", &status);
+    EXPECT_EQ(status, 404);
+}
+
+TEST(router_test, invalid_patterns)
+{
+    Router router;
+    router.add(Method::GET, "/a/<id>", named("a"));
+    EXPECT_ANY_THROW(router.add(Method::GET, "relative", named("")));
+    EXPECT_ANY_THROW(router.add(Method::GET, "/a/<id>", named("")));
+    EXPECT_ANY_THROW(router.add(Method::GET, "/a/<other>", named("")));
+    EXPECT_ANY_THROW(router.add(Method::GET, "/b/<path:rest>/more", named("")));
+    EXPECT_ANY_THROW(router.add(Method::GET, "/c/<unterminated", named("")));
+}
+
+APP(TestApp) {
+    Route("/") {
+        request.get = []() {
+            return "hello world!";
+        };
+    }
+
+    Route("/hello/<name>") {
+        request.get = [](Request& request) {
+            return "hello " + request.parameters["name"].to_string();
+        };
+    }
+
+    Route("/login") {
+        request.accept("application/json");
+        request.post = [](Request& request, Response& response) {
+            response.status = 201;
+            response.body = request.data;
+        };
+    }
+}
+
+TEST(router_test, app_dsl)
+{
+    TestApp app;
+    Router router;
+    app.install(router);
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/"), "hello world!");
+    EXPECT_EQ(dispatch(router, Method::GET, "/hello/wizrd"), "hello wizrd name=wizrd");
+
+    Request request;
+    request.method = Method::POST;
+    request.url = "/login";
+    request.contentType = "application/json; charset=utf-8";
+    request.data = "{}";
+    Response response;
+    router(request, response);
+    EXPECT_EQ(response.status, 201);
+    EXPECT_EQ(response.body, "{}");
+
+    request.contentType = "text/plain";
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(response.status, 415);
+}
+
+TEST(router_test, redirects_quote_the_location)
+{
+    Router router;
+    router.add(Method::GET, "/old", [](Request&, Response& response) {
+        response.redirect("/new page?q=caf\xC3\xA9&x=%41#top", 301);
+    });
+
+    Request request;
+    request.method = Method::GET;
+    request.url = "/old";
+    Response response;
+    router(request, response);
+    EXPECT_EQ(response.status, 301);
+    EXPECT_EQ(headerValue(response.headers, "location"), "/new%20page?q=caf%C3%A9&x=%41#top");
+}
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <iostream>
+#include <string>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+
+using namespace Wizrd;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+void helloHandler(Server::Request& request, Server::Response& response)
+{
+    response.addHeader("Content-Type", "text/plain");
+    response.body = "hello " + request.url;
+}
+
+}
+
+TEST(server_test, unix_socket_listener)
+{
+    const std::string path = socketPath("server_test");
+    Server::Server server(helloHandler);
+    Server::UnixOptions options;
+    options.permissions = 0600;
+    server.listenUnix(path, options);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+    auto response = exchange(socket, "GET /unix HTTP/1.1\r\n"
+                                     "Host: localhost\r\n"
+                                     "Connection: close\r\n"
+                                     "\r\n");
+    thread.stop();
+
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(response, ::testing::HasSubstr("Connection: close\r\n"));
+    EXPECT_THAT(response, ::testing::EndsWith("\r\n\r\nhello /unix"));
+    EXPECT_NE(::access(path.c_str(), F_OK), 0);
+}
+
+TEST(server_test, tcp_listener_options)
+{
+    Server::Server server(helloHandler);
+    Server::TcpOptions options;
+    options.deferAccept = 5;
+    options.fastOpen = 16;
+    options.acceptBatch = 4;
+    auto& listener = server.listen("127.0.0.1", 0, options);
+
+    int value = 0;
+    socklen_t size = sizeof(value);
+    ASSERT_EQ(::getsockopt(listener.nativeHandle(), IPPROTO_TCP, TCP_DEFER_ACCEPT, &value, &size), 0);
+    EXPECT_GT(value, 0);
+    ASSERT_EQ(::getsockopt(listener.nativeHandle(), IPPROTO_TCP, TCP_FASTOPEN, &value, &size), 0);
+    EXPECT_EQ(value, 16);
+
+    ServerThread thread(server);
+    asio::io_context ioContext;
+    asio::ip::tcp::socket socket(ioContext);
+    socket.connect(loopback(listener));
+    auto response = exchange(socket, "GET /tcp HTTP/1.0\r\n\r\n");
+    thread.stop();
+
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.0 200 OK\r\n"));
+    EXPECT_THAT(response, ::testing::EndsWith("hello /tcp"));
+}
+
+TEST(server_test, pipelined_keep_alive_requests)
+{
+    const std::string path = socketPath("server_test_pipeline");
+    Server::Server server(helloHandler);
+    server.listenUnix(path);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+    auto response = exchange(socket, "GET /first HTTP/1.1\r\n\r\n"
+                                     "POST /second HTTP/1.1\r\n"
+                                     "Content-Length: 4\r\n"
+                                     "\r\n"
+                                     "data"
+                                     "GET /third HTTP/1.1\r\n"
+                                     "Connection: close\r\n"
+                                     "\r\n");
+    thread.stop();
+
+    EXPECT_THAT(response, ::testing::HasSubstr("hello /first"));
+    EXPECT_THAT(response, ::testing::HasSubstr("hello /second"));
+    EXPECT_THAT(response, ::testing::EndsWith("hello /third"));
+}
+
+TEST(server_test, malformed_request_is_rejected)
+{
+    const std::string path = socketPath("server_test_malformed");
+    Server::Server server(helloHandler);
+    server.listenUnix(path);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+    auto response = exchange(socket, "G3T / HTTP/1.1\r\n\r\n");
+    thread.stop();
+
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.1 400 Bad Request\r\n"));
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <string>
+#include "gtest/gtest.h"
+#include "../internal_webserver/staticroute.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+
+namespace {
+
+std::string dispatch(const Router& router, Method method, const std::string& url, int* status = nullptr)
+{
+    Request request;
+    request.method = method;
+    request.url = url;
+    Response response;
+    router(request, response);
+    if (status)
+        *status = response.status;
+    return response.body;
+}
+
+}
+
+TEST(staticroute_test, pattern_segments)
+{
+    using Users = CompiledPattern<"/users/<int:id>/posts/<slug>">;
+    static_assert(Users::segments.size() == 4);
+    static_assert(Users::captureCount == 2);
+    static_assert(!Users::literal);
+    static_assert(std::is_same<Users::Captures, std::tuple<int, boost::string_ref>>::value);
+    static_assert(CompiledPattern<"/about">::literal);
+
+    Users::Captures captures;
+    PathParameters parameters;
+    ASSERT_TRUE(Users::match("/users/42/posts/hello", captures, &parameters));
+    EXPECT_EQ(std::get<0>(captures), 42);
+    EXPECT_EQ(std::get<1>(captures), "hello");
+    EXPECT_EQ(parameters["id"], "42");
+    EXPECT_EQ(parameters["slug"], "hello");
+
+    EXPECT_FALSE(Users::match("/users/4x/posts/hello", captures, nullptr));
+    EXPECT_FALSE(Users::match("/users/-4/posts/hello", captures, nullptr));
+    EXPECT_FALSE(Users::match("/users/42/posts/", captures, nullptr));
+    EXPECT_FALSE(Users::match("/users/42/posts/a/b", captures, nullptr));
+}
+
+TEST(staticroute_test, captures_match_like_the_tree)
+{
+    using File = CompiledPattern<"/files/<name>/<float:version>/<path:rest>">;
+    File::Captures captures;
+    ASSERT_TRUE(File::match("/files/report.txt/1.5/a/b/c", captures, nullptr));
+    EXPECT_EQ(std::get<0>(captures), "report.txt");
+    EXPECT_DOUBLE_EQ(std::get<1>(captures), 1.5);
+    EXPECT_EQ(std::get<2>(captures), "a/b/c");
+
+    // a capture takes the whole segment and an int has to fit, compiled or not
+    Router router;
+    router.add(Method::GET, "/tree/f/<name>.txt", [](Request&, Response& response) { response.body = "tree"; });
+    router.add(Method::GET, "/tree/n/<int:id>", [](Request&, Response& response) { response.body = "tree"; });
+    addCompiled<"/compiled/f/<name>.txt">(router, Method::GET, []() { return "compiled"; });
+    addCompiled<"/compiled/n/<int:id>">(router, Method::GET, [](int) { return "compiled"; });
+    EXPECT_EQ(dispatch(router, Method::GET, "/tree/n/2147483647"), "tree");
+    EXPECT_EQ(dispatch(router, Method::GET, "/compiled/n/2147483647"), "compiled");
+    for (const char* value: {"f/report.txt", "n/2147483648", "n/99999999999999999999"}) {
+        for (const char* prefix: {"/tree/", "/compiled/"}) {
+            int status = 0;
+            dispatch(router, Method::GET, prefix + std::string(value), &status);
+            EXPECT_EQ(status, 404) << prefix << value;
+        }
+    }
+}
+
+TEST(staticroute_test, literal_routes_by_length)
+{
+    Router router;
+    addCompiled<"/a">(router, Method::GET, []() { return "a"; });
+    addCompiled<"/b">(router, Method::GET, []() { return "b"; });
+    addCompiled<"/ab">(router, Method::GET, []() { return "ab"; });
+    router.add(Method::GET, "/<name>", [](Request&, Response& response) { response.body = "tree"; });
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/a"), "a");
+    EXPECT_EQ(dispatch(router, Method::GET, "/b?query"), "b");
+    EXPECT_EQ(dispatch(router, Method::GET, "/ab"), "ab");
+    EXPECT_EQ(dispatch(router, Method::GET, "/c"), "tree");
+    EXPECT_EQ(dispatch(router, Method::HEAD, "/a"), "a");
+
+    int status = 0;
+    dispatch(router, Method::POST, "/a", &status);
+    EXPECT_EQ(status, 405);
+}
+
+TEST(staticroute_test, capture_routes_prefer_static_text)
+{
+    Router router;
+    addCompiled<"/users/<id>">(router, Method::GET, []() { return "user"; });
+    addCompiled<"/users/<id>/posts">(router, Method::GET, []() { return "posts"; });
+    addCompiled<"/<path:rest>">(router, Method::GET, []() { return "rest"; });
+    addCompiled<"/users/me<suffix>">(router, Method::GET, []() { return "me"; });
+    router.add(Method::GET, "/users/admin/<name>", [](Request&, Response& response) { response.body = "admin"; });
+    router.add(Method::HEAD, "/users/<id>", [](Request&, Response& response) { response.body = "head"; });
+
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/7"), "user");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/mex"), "me");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/7/posts"), "posts");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/admin/bob"), "admin");
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/7/likes"), "rest");
+    EXPECT_EQ(dispatch(router, Method::GET, "/other"), "rest");
+    // the HEAD route of the tree comes before the GET fallback
+    EXPECT_EQ(dispatch(router, Method::HEAD, "/users/7"), "head");
+    EXPECT_EQ(dispatch(router, Method::HEAD, "/users/7/posts"), "posts");
+
+    EXPECT_THROW((addCompiled<"/users/<name>">(router, Method::GET, []() { return ""; })), RouteException);
+    EXPECT_THROW((addCompiled<"/<path:other>">(router, Method::GET, []() { return ""; })), RouteException);
+    EXPECT_NO_THROW((addCompiled<"/users/<int:id>">(router, Method::GET, []() { return ""; })));
+    EXPECT_NO_THROW((addCompiled<"/users/<id>">(router, Method::POST, []() { return ""; })));
+}
+
+TEST(staticroute_test, tree_converters)
+{
+    Router router;
+    router.add(Method::GET, "/n/<int:id>", [](Request&, Response& response) { response.body = "int"; });
+    router.add(Method::GET, "/f/<float:x>", [](Request&, Response& response) { response.body = "float"; });
+
+    int status = 0;
+    EXPECT_EQ(dispatch(router, Method::GET, "/n/12"), "int");
+    dispatch(router, Method::GET, "/n/twelve", &status);
+    EXPECT_EQ(status, 404);
+    EXPECT_EQ(dispatch(router, Method::GET, "/f/1.25"), "float");
+    dispatch(router, Method::GET, "/f/1.2.5", &status);
+    EXPECT_EQ(status, 404);
+    EXPECT_ANY_THROW(router.add(Method::GET, "/x/<complex:z>", nullptr));
+}
+
+APP(TypedApp) {
+    Route("/users/<int:id>") {
+        request.get = [](int id) {
+            return "user " + std::to_string(id);
+        };
+        request.accept("application/json");
+        request.put = [](Request&, Response& response, int id) {
+            response.status = 204;
+            response.addHeader("X-User", std::to_string(id));
+        };
+    }
+
+    Route("/price/<float:amount>/<currency>") {
+        request.get = [](Request&, double amount, boost::string_ref currency) {
+            return std::to_string(static_cast<int>(amount * 100)) + " " + currency.to_string();
+        };
+    }
+}
+
+TEST(staticroute_test, typed_handlers)
+{
+    TypedApp app;
+    Router router;
+    app.install(router);
+
+    int status = 0;
+    EXPECT_EQ(dispatch(router, Method::GET, "/users/7"), "user 7");
+    dispatch(router, Method::GET, "/users/seven", &status);
+    EXPECT_EQ(status, 404);
+    EXPECT_EQ(dispatch(router, Method::GET, "/price/2.5/eur"), "250 eur");
+
+    Request request;
+    request.method = Method::PUT;
+    request.url = "/users/3";
+    request.contentType = "application/json";
+    request.data = "{}";
+    Response response;
+    router(request, response);
+    EXPECT_EQ(response.status, 204);
+
+    request.contentType = "text/plain";
+    response.reset();
+    router(request, response);
+    EXPECT_EQ(response.status, 415);
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#include <string>
+#include "gtest/gtest.h"
+#include "utils/uri.h"
+
+using namespace Wizrd;
+
+namespace {
+
+std::string normalized(std::string path)
+{
+    path.resize(normalizePath(&path[0], path.size()));
+    return path;
+}
+
+std::string canonical(std::string target)
+{
+    RequestTarget parts;
+    if (!RequestTarget::parse(target, parts))
+        return "<invalid>";
+    target.resize(canonicalTarget(&target[0], parts));
+    return target;
+}
+
+}
+
+TEST(uri_test, origin_form)
+{
+    RequestTarget parts;
+    ASSERT_TRUE(RequestTarget::parse("/search/items?q=a+b#top", parts));
+    EXPECT_EQ(parts.form, RequestTarget::Origin);
+    EXPECT_EQ(parts.path, "/search/items");
+    EXPECT_TRUE(parts.hasQuery);
+    EXPECT_EQ(parts.query, "q=a+b");
+    EXPECT_TRUE(parts.hasFragment);
+    EXPECT_EQ(parts.fragment, "top");
+    EXPECT_TRUE(parts.scheme.empty());
+    EXPECT_TRUE(parts.authority.empty());
+
+    ASSERT_TRUE(RequestTarget::parse("/?", parts));
+    EXPECT_EQ(parts.path, "/");
+    EXPECT_TRUE(parts.hasQuery);
+    EXPECT_TRUE(parts.query.empty());
+    EXPECT_FALSE(parts.hasFragment);
+}
+
+TEST(uri_test, other_forms)
+{
+    RequestTarget parts;
+    ASSERT_TRUE(RequestTarget::parse("https://user@example.com:8443/a/b?c", parts));
+    EXPECT_EQ(parts.form, RequestTarget::Absolute);
+    EXPECT_EQ(parts.scheme, "https");
+    EXPECT_EQ(parts.authority, "user@example.com:8443");
+    EXPECT_EQ(parts.path, "/a/b");
+    EXPECT_EQ(parts.query, "c");
+
+    ASSERT_TRUE(RequestTarget::parse("http://example.com", parts));
+    EXPECT_EQ(parts.authority, "example.com");
+    EXPECT_TRUE(parts.path.empty());
+
+    ASSERT_TRUE(RequestTarget::parse("example.com:443", parts));
+    EXPECT_EQ(parts.form, RequestTarget::Authority);
+    EXPECT_EQ(parts.authority, "example.com:443");
+
+    ASSERT_TRUE(RequestTarget::parse("*", parts));
+    EXPECT_EQ(parts.form, RequestTarget::Asterisk);
+
+    EXPECT_FALSE(RequestTarget::parse("", parts));
+    EXPECT_FALSE(RequestTarget::parse("http:///path", parts));
+    EXPECT_FALSE(RequestTarget::parse("index.html?x", parts));
+}
+
+TEST(uri_test, path_normalization)
+{
+    EXPECT_EQ(normalized("/"), "/");
+    EXPECT_EQ(normalized("/a/b"), "/a/b");
+    EXPECT_EQ(normalized("//a///b//"), "/a/b/");
+    EXPECT_EQ(normalized("/a/./b/."), "/a/b/");
+    EXPECT_EQ(normalized("/a/b/../c"), "/a/c");
+    EXPECT_EQ(normalized("/a/b/.."), "/a/");
+    EXPECT_EQ(normalized("/../../a"), "/a");
+    EXPECT_EQ(normalized("/.."), "/");
+    EXPECT_EQ(normalized("/a/..b/.c"), "/a/..b/.c");
+    // unreserved chars are decoded, before the dot segments are removed
+    EXPECT_EQ(normalized("/%7Euser/%61%62%2d"), "/~user/ab-");
+    EXPECT_EQ(normalized("/a/%2e%2E/b"), "/b");
+    // reserved and other chars stay escaped, with uppercase digits
+    EXPECT_EQ(normalized("/a%2fb/%c3%a9/%20"), "/a%2Fb/%C3%A9/%20");
+    EXPECT_EQ(normalized("/100%/%4"), "/100%/%4");
+    EXPECT_EQ(normalized("relative/./path"), "relative/./path");
+}
+
+TEST(uri_test, canonical_targets)
+{
+    EXPECT_EQ(canonical("/a//b/../c?x=%2e#frag"), "/a/c?x=%2e");
+    EXPECT_EQ(canonical("http://example.com/a/./b?q"), "/a/b?q");
+    EXPECT_EQ(canonical("http://example.com"), "/");
+    EXPECT_EQ(canonical("http://example.com?q=1"), "/?q=1");
+    EXPECT_EQ(canonical("example.com:443"), "example.com:443");
+    EXPECT_EQ(canonical("*"), "*");
+}
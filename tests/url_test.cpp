@@ -27,6 +27,7 @@
 #include <iostream>
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
+#include "utils/query.h"
 #include "utils/url.h"
 #include <string>
 
@@ -160,3 +161,178 @@ TEST(url_test_case, url_encode_invalid_number_of_parameters_should_throw_URLEnco
     EXPECT_THROW(Wizrd::URL::encode(params), Wizrd::URLEncodeError);
     EXPECT_THROW(Wizrd::URL::encode(params2), Wizrd::URLEncodeError);
 }
+
+TEST(url_test_case, quote_non_ascii_test)
+{
+    EXPECT_EQ(Wizrd::URL::quote("caf\xC3\xA9"), "caf%C3%A9");
+    EXPECT_EQ(Wizrd::URL::quotePlus("\xFF \x80"), "%FF+%80");
+    EXPECT_EQ(Wizrd::URL::unquote("caf%C3%a9"), "caf\xC3\xA9");
+}
+
+TEST(url_test_case, quote_every_byte_round_trip)
+{
+    std::string all;
+    for (int i = 0; i < 256; i++)
+        all += static_cast<char>(i);
+    // long enough for the block scanners and their scalar tail
+    all += all;
+
+    auto quoted{Wizrd::URL::quote(all)};
+    EXPECT_EQ(quoted.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_./%"),
+              std::string::npos);
+    EXPECT_EQ(Wizrd::URL::unquote(quoted), all);
+    EXPECT_EQ(Wizrd::URL::unquotePlus(Wizrd::URL::quotePlus(all)), all);
+}
+
+TEST(url_test_case, escapes_at_every_offset_of_long_input)
+{
+    for (size_t offset = 0; offset < 150; offset++) {
+        std::string plain(150, 'a');
+        plain[offset] = ' ';
+        std::string quoted(150, 'a');
+        quoted.replace(offset, 1, "%20");
+        std::string quotedPlus(150, 'a');
+        quotedPlus[offset] = '+';
+
+        EXPECT_EQ(Wizrd::URL::quote(plain), quoted);
+        EXPECT_EQ(Wizrd::URL::quotePlus(plain), quotedPlus);
+        EXPECT_EQ(Wizrd::URL::unquote(quoted), plain);
+        EXPECT_EQ(Wizrd::URL::unquotePlus(quotedPlus), plain);
+        EXPECT_EQ(Wizrd::URL::unquote(quotedPlus), quotedPlus);
+    }
+}
+
+TEST(url_test_case, unquote_malformed_escapes_in_long_input)
+{
+    std::string input(100, 'x');
+    input += "%4H%%41%";
+    EXPECT_EQ(Wizrd::URL::unquote(input), std::string(100, 'x') + "%4H%A%");
+}
+
+TEST(url_test_case, quote_honors_every_safe_char)
+{
+    EXPECT_EQ(Wizrd::URL::quote("a:b@c d/e", "/:@"), "a:b@c%20d/e");
+    EXPECT_EQ(Wizrd::URL::quote("a:b@c", ":"), "a:b%40c");
+    EXPECT_EQ(Wizrd::URL::quotePlus("a b~c", "~"), "a+b~c");
+}
+
+TEST(url_test_case, safe_char_sets)
+{
+    constexpr auto segment = Wizrd::URLSafeChars::unreserved().with(":@");
+    static_assert(segment.contains('~') && segment.contains('@') && !segment.contains('/'));
+    static_assert(!Wizrd::URLSafeChars().contains('a'));
+    static_assert(Wizrd::URLSafeChars::pathSegment().contains('='));
+
+    EXPECT_EQ(Wizrd::URL::quote("x/y@z~w", segment), "x%2Fy@z~w");
+    std::string escaped;
+    for (int i = 0; i < 100; i++)
+        escaped += "%2F";
+    EXPECT_EQ(Wizrd::URL::quote(std::string(100, '/') + "~", segment), escaped + "~");
+
+    // non-ASCII chars can be safe too, past the vector scanners as well
+    const Wizrd::URLSafeChars utf8("\xC3\xA9");
+    const std::string long_word = std::string(70, '\xC3') + " \xA9";
+    EXPECT_EQ(Wizrd::URL::quote(long_word, utf8), std::string(70, '\xC3') + "%20\xA9");
+
+    std::string appended = "Location: ";
+    Wizrd::URL::appendQuoted(appended, "/a b", Wizrd::URLSafeChars::uri());
+    EXPECT_EQ(appended, "Location: /a%20b");
+    EXPECT_EQ(Wizrd::URL::quotedSize("a b\xFF", Wizrd::URLSafeChars::uri(), true), 6u);
+}
+
+TEST(url_test_case, query_string_views)
+{
+    const std::string query = "page=2&&q=caf%C3%A9+au+lait&flag&id=1&id=2&na%6De=x&empty=";
+    Wizrd::QueryString parameters(query);
+    std::string scratch;
+
+    std::vector<std::string> names;
+    for (const auto& parameter: parameters)
+        names.push_back(parameter.name());
+    EXPECT_EQ(names, (std::vector<std::string>{"page", "q", "flag", "id", "id", "name", "empty"}));
+
+    // clean values are views into the query string
+    auto page = parameters.get("page", scratch);
+    EXPECT_EQ(page, "2");
+    EXPECT_EQ(page.data(), query.data() + 5);
+
+    EXPECT_EQ(parameters.get("q", scratch), "caf\xC3\xA9 au lait");
+    EXPECT_EQ(parameters.get("id", scratch), "1");
+    EXPECT_EQ(parameters.get("name", scratch), "x");
+    EXPECT_EQ(parameters.get("missing", scratch), "");
+    EXPECT_FALSE(parameters.contains("na"));
+
+    auto flag = parameters.find("flag");
+    ASSERT_NE(flag, parameters.end());
+    EXPECT_FALSE(flag->hasValue());
+    auto empty = parameters.find("empty");
+    ASSERT_NE(empty, parameters.end());
+    EXPECT_TRUE(empty->hasValue());
+    EXPECT_EQ(empty->value(), "");
+    EXPECT_EQ(parameters.find("q")->rawValue(), "caf%C3%A9+au+lait");
+
+    EXPECT_TRUE(Wizrd::QueryString().empty());
+    EXPECT_TRUE(Wizrd::QueryString("&&").empty());
+}
+
+TEST(url_test_case, unquoted_equals)
+{
+    EXPECT_TRUE(Wizrd::URL::unquotedEquals("a%20b", "a b"));
+    EXPECT_TRUE(Wizrd::URL::unquotedEquals("a+b", "a b", true));
+    EXPECT_FALSE(Wizrd::URL::unquotedEquals("a+b", "a b"));
+    EXPECT_TRUE(Wizrd::URL::unquotedEquals("100%", "100%"));
+    EXPECT_TRUE(Wizrd::URL::unquotedEquals("%4H", "%4H"));
+    EXPECT_FALSE(Wizrd::URL::unquotedEquals("a%20b", "a "));
+    EXPECT_FALSE(Wizrd::URL::unquotedEquals("a%20", "a b"));
+}
+
+TEST(url_test_case, url_decode_many_pairs)
+{
+    auto result{Wizrd::URL::decode("a=1&b=2&c=3&&d")};
+    Wizrd::params expect{{"a", "1"}, {"b", "2"}, {"c", "3"}, {"d"}};
+    EXPECT_EQ(result, expect);
+}
+
+TEST(url_test_case, url_decode_map_keeps_repeated_names)
+{
+    auto result{Wizrd::URL::decodeMap("id=1&x=y&id=2&id=3")};
+    Wizrd::paramsMap expect{{"id", "1"}, {"x", "y"}, {"id", "2"}, {"id", "3"}};
+    EXPECT_EQ(result, expect);
+    EXPECT_EQ(result.get("id"), "1");
+    EXPECT_EQ(result.count("id"), 3u);
+    std::vector<std::string> ids(result.all("id").begin(), result.all("id").end());
+    EXPECT_EQ(ids, (std::vector<std::string>{"1", "2", "3"}));
+    EXPECT_EQ(Wizrd::URL::encode(result), "id=1&x=y&id=2&id=3");
+}
+
+TEST(url_test_case, param_map_index)
+{
+    Wizrd::ParamMap map;
+    std::string query;
+    for (int i = 0; i < 200; i++) {
+        map.add("name" + std::to_string(i % 50), std::to_string(i));
+        query += (i ? "&name" : "name") + std::to_string(i % 50) + "=" + std::to_string(i);
+    }
+    EXPECT_EQ(map.size(), 200u);
+    for (int i = 0; i < 50; i++) {
+        const std::string name = "name" + std::to_string(i);
+        ASSERT_TRUE(map.contains(name));
+        EXPECT_EQ(map.get(name), std::to_string(i));
+        EXPECT_EQ(map.count(name), 4u);
+        int expected = i;
+        for (const std::string& value: map.all(name)) {
+            EXPECT_EQ(value, std::to_string(expected));
+            expected += 50;
+        }
+    }
+    EXPECT_FALSE(map.contains("name50"));
+    EXPECT_EQ(map.find("missing"), nullptr);
+    EXPECT_TRUE(map.all("missing").empty());
+
+    EXPECT_EQ(Wizrd::URL::decodeMap(query), map);
+    EXPECT_EQ(Wizrd::URL::encode(map), query);
+
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_FALSE(map.contains("name1"));
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <iostream>
+#include <map>
+#include <string>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/uwsgi.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+std::string packet(const std::vector<std::pair<std::string, std::string>>& vars)
+{
+    std::string block;
+    auto appendString = [&block](const std::string& value) {
+        block += static_cast<char>(value.size() & 0xFF);
+        block += static_cast<char>(value.size() >> 8);
+        block += value;
+    };
+    for (auto& var: vars) {
+        appendString(var.first);
+        appendString(var.second);
+    }
+    std::string output{0, static_cast<char>(block.size() & 0xFF),
+                       static_cast<char>(block.size() >> 8), 0};
+    return output + block;
+}
+
+std::string roundTrip(const std::string& path, const std::vector<std::string>& writes)
+{
+    asio::io_context ioContext;
+    asio::local::stream_protocol::socket socket(ioContext);
+    socket.connect(asio::local::stream_protocol::endpoint(path));
+    for (auto& data: writes)
+        asio::write(socket, asio::buffer(data));
+    return readAll(socket);
+}
+
+}
+
+TEST(uwsgi_test, decode_vars)
+{
+    std::string data = packet({{"REQUEST_METHOD", "GET"}, {"HTTP_HOST", std::string(300, 'h')}});
+    std::map<std::string, std::string> vars;
+    const auto header = Uwsgi::parseHeader(data.data());
+    EXPECT_EQ(header.modifier1, Uwsgi::Request);
+    EXPECT_EQ(header.dataSize, data.size() - Uwsgi::HeaderSize);
+    EXPECT_TRUE(Uwsgi::decodeVars(boost::string_ref(data).substr(Uwsgi::HeaderSize),
+                                  [&vars](boost::string_ref key, boost::string_ref value) {
+                                      vars[key.to_string()] = value.to_string();
+                                  }));
+    EXPECT_EQ(vars["REQUEST_METHOD"], "GET");
+    EXPECT_EQ(vars["HTTP_HOST"], std::string(300, 'h'));
+
+    // truncated block
+    EXPECT_FALSE(Uwsgi::decodeVars(boost::string_ref(data).substr(Uwsgi::HeaderSize, 10),
+                                   [](boost::string_ref, boost::string_ref) {}));
+}
+
+TEST(uwsgi_test, request_through_listener)
+{
+    const std::string path = socketPath("uwsgi_test");
+    Server::Server server([](Request& request, Response& response) {
+        response.body = request.methodString + " " + request.url + " " + request.host + " " + request.data;
+    });
+    server.listenUnix(path, UnixOptions(), Transport::Uwsgi);
+    ServerThread thread(server);
+
+    auto request = packet({{"REQUEST_METHOD", "POST"},
+                           {"REQUEST_URI", "/upload?x=1"},
+                           {"SERVER_PROTOCOL", "HTTP/1.1"},
+                           {"HTTP_HOST", "example.com"},
+                           {"CONTENT_LENGTH", "7"}});
+    auto response = roundTrip(path, {request + "payload"});
+    // header, vars and body split across writes
+    auto split = roundTrip(path, {request.substr(0, 2), request.substr(2, 20),
+                                 request.substr(22) + "pay", "load"});
+    thread.stop();
+
+    EXPECT_THAT(response, ::testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(response, ::testing::EndsWith("\r\n\r\nPOST /upload?x=1 example.com payload"));
+    EXPECT_EQ(response, split);
+}
+
+TEST(uwsgi_test, streamed_response_is_chunked)
+{
+    const std::string path = socketPath("uwsgi_stream_test");
+    Server::Server server([](Request&, Response& response) {
+        response.stream = [part = 0](std::string& output) mutable {
+            output += "part" + std::to_string(part++) + ";";
+            return part < 3;
+        };
+    });
+    server.listenUnix(path, UnixOptions(), Transport::Uwsgi);
+    ServerThread thread(server);
+
+    auto http11 = roundTrip(path, {packet({{"REQUEST_METHOD", "GET"},
+                                           {"REQUEST_URI", "/stream"},
+                                           {"SERVER_PROTOCOL", "HTTP/1.1"}})});
+    auto http10 = roundTrip(path, {packet({{"REQUEST_METHOD", "GET"},
+                                           {"REQUEST_URI", "/stream"},
+                                           {"SERVER_PROTOCOL", "HTTP/1.0"}})});
+    thread.stop();
+
+    EXPECT_THAT(http11, ::testing::StartsWith("HTTP/1.1 200 OK\r\n"));
+    EXPECT_THAT(http11, ::testing::HasSubstr("Transfer-Encoding: chunked\r\n"));
+    EXPECT_THAT(http11, ::testing::EndsWith("\r\n\r\n00000006\r\npart0;\r\n00000006\r\npart1;\r\n"
+                                            "00000006\r\npart2;\r\n0\r\n\r\n"));
+    // HTTP/1.0 has no chunks, the body ends with the connection
+    EXPECT_THAT(http10, ::testing::Not(::testing::HasSubstr("Transfer-Encoding")));
+    EXPECT_THAT(http10, ::testing::EndsWith("\r\n\r\npart0;part1;part2;"));
+}
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2016 - Wizrd Team
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use,
+ * copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following
+ * conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+#include "../internal_webserver/server.h"
+#include "loopback.h"
+#include "wizrd"
+
+using namespace Wizrd;
+using namespace Wizrd::Server;
+using namespace Wizrd::Testing;
+namespace asio = boost::asio;
+
+namespace {
+
+std::atomic<bool> renderDone(false);
+std::thread::id renderThread;
+
+}
+
+TEST(workerpool_test, deque_pops_newest_and_steals_oldest)
+{
+    WorkStealingDeque<int> deque(2);
+    int items[5] = {0, 1, 2, 3, 4};
+    for (int& item: items)
+        deque.push(&item);
+    EXPECT_EQ(*deque.steal(), 0);
+    EXPECT_EQ(*deque.pop(), 4);
+    EXPECT_EQ(*deque.steal(), 1);
+    EXPECT_EQ(*deque.pop(), 3);
+    EXPECT_EQ(*deque.pop(), 2);
+    EXPECT_EQ(deque.pop(), nullptr);
+    EXPECT_EQ(deque.steal(), nullptr);
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(workerpool_test, deque_items_are_taken_once)
+{
+    WorkStealingDeque<int> deque;
+    std::vector<int> items(20000);
+    std::atomic<int> taken(0);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < 3; i++) {
+        thieves.emplace_back([&]() {
+            while (!done || !deque.empty()) {
+                if (int* item = deque.steal()) {
+                    (*item)++;
+                    taken++;
+                }
+            }
+        });
+    }
+    for (size_t i = 0; i < items.size(); i++) {
+        deque.push(&items[i]);
+        if (i % 3 == 0) {
+            if (int* item = deque.pop()) {
+                (*item)++;
+                taken++;
+            }
+        }
+    }
+    while (int* item = deque.pop()) {
+        (*item)++;
+        taken++;
+    }
+    done = true;
+    for (auto& thief: thieves)
+        thief.join();
+    EXPECT_EQ(taken, static_cast<int>(items.size()));
+    for (int item: items)
+        EXPECT_EQ(item, 1);
+}
+
+TEST(workerpool_test, runs_jobs_and_the_jobs_they_submit)
+{
+    std::atomic<int> count(0);
+    {
+        WorkerPool pool(3);
+        EXPECT_EQ(pool.size(), 3u);
+        for (int i = 0; i < 100; i++) {
+            pool.submit([&pool, &count]() {
+                count++;
+                pool.submit([&count]() { count++; });
+            });
+        }
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (count < 200 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(count, 200);
+}
+
+TEST(workerpool_test, destructor_runs_the_queued_jobs)
+{
+    std::atomic<int> count(0);
+    {
+        WorkerPool pool(2);
+        // the workers are busy, the others wait in the queues
+        for (int i = 0; i < 50; i++) {
+            pool.submit([&pool, &count]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                count++;
+                pool.submit([&count]() { count++; });
+            });
+        }
+    }
+    EXPECT_EQ(count, 100);
+}
+
+APP(OffloadApp) {
+    Route("/render/<int:size>") {
+        request.offload();
+        request.get = [](int size) {
+            renderThread = std::this_thread::get_id();
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            renderDone = true;
+            return std::string(size, '#');
+        };
+    }
+
+    Route("/ping") {
+        request.get = []() {
+            return "pong";
+        };
+    }
+}
+
+TEST(workerpool_test, offloaded_handlers_leave_the_io_thread_free)
+{
+    OffloadApp app;
+    Router router;
+    app.install(router);
+    Server::Server server([&router](Request& request, Response& response) { router(request, response); });
+    auto& listener = server.listen("127.0.0.1", 0);
+    ServerThread thread(server);
+
+    asio::io_context ioContext;
+    const asio::ip::tcp::endpoint endpoint = loopback(listener);
+
+    asio::ip::tcp::socket render(ioContext);
+    render.connect(endpoint);
+    asio::write(render, asio::buffer(std::string("GET /render/3 HTTP/1.0\r\n\r\n")));
+    asio::ip::tcp::socket ping(ioContext);
+    ping.connect(endpoint);
+    asio::write(ping, asio::buffer(std::string("GET /ping HTTP/1.0\r\n\r\n")));
+
+    EXPECT_THAT(readAll(ping), ::testing::EndsWith("\r\n\r\npong"));
+    EXPECT_FALSE(renderDone);
+    EXPECT_THAT(readAll(render), ::testing::EndsWith("\r\n\r\n###"));
+    EXPECT_TRUE(renderDone);
+    EXPECT_NE(renderThread, thread.id());
+
+    thread.stop();
+}